@@ -0,0 +1,187 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Microbenchmarks for the per-sample hot paths shared by the drivers.
+ * The conversion kernels measured here are exactly the ones the rtl,
+ * hackrf, bladerf and soapy work() functions run at the full sample
+ * rate, so a regression in one of them shows up in every backend.
+ *
+ * Run with `make bench` and diff the output across commits.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <volk/volk.h>
+
+#include <boost/thread/thread.hpp>
+
+#include "arg_helpers.h"
+#include "ring_buffer.h"
+
+/* u8 offset binary to float, the rtl and hackrf streaming conversion */
+static void BM_u8_to_fc32(benchmark::State &state)
+{
+  const int num = state.range(0);
+  unsigned char *in = (unsigned char *)volk_malloc(num, volk_get_alignment());
+  float *out = (float *)volk_malloc(num * sizeof(float), volk_get_alignment());
+
+  for (int i = 0; i < num; i++)
+    in[i] = (unsigned char)i;
+
+  while (state.KeepRunning()) {
+    volk_8i_s32f_convert_32f(out, (const int8_t *)in, 128.0f, num);
+    benchmark::DoNotOptimize(out[0]);
+  }
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * num);
+  volk_free(in);
+  volk_free(out);
+}
+BENCHMARK(BM_u8_to_fc32)->Range(1 << 12, 1 << 20);
+
+/* s16 to float, the bladerf and soapy native format conversion */
+static void BM_s16_to_fc32(benchmark::State &state)
+{
+  const int num = state.range(0);
+  int16_t *in = (int16_t *)volk_malloc(num * sizeof(int16_t),
+                                       volk_get_alignment());
+  float *out = (float *)volk_malloc(num * sizeof(float), volk_get_alignment());
+
+  for (int i = 0; i < num; i++)
+    in[i] = (int16_t)i;
+
+  while (state.KeepRunning()) {
+    volk_16i_s32f_convert_32f(out, in, 2048.0f, num);
+    benchmark::DoNotOptimize(out[0]);
+  }
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * num * sizeof(int16_t));
+  volk_free(in);
+  volk_free(out);
+}
+BENCHMARK(BM_s16_to_fc32)->Range(1 << 12, 1 << 20);
+
+/* channel demultiplex as done by the dual channel bladerf path: one
+ * SC16 sample is the width of one float, so the 32fc deinterleave
+ * kernel splits the channels without touching the payload */
+static void BM_deinterleave_sc16_x2(benchmark::State &state)
+{
+  const int num = state.range(0); /* samples per channel */
+  int16_t *in = (int16_t *)volk_malloc(4 * num * sizeof(int16_t),
+                                       volk_get_alignment());
+  float *out0 = (float *)volk_malloc(num * sizeof(float),
+                                     volk_get_alignment());
+  float *out1 = (float *)volk_malloc(num * sizeof(float),
+                                     volk_get_alignment());
+
+  for (int i = 0; i < 4 * num; i++)
+    in[i] = (int16_t)i;
+
+  while (state.KeepRunning()) {
+    volk_32fc_deinterleave_32f_x2(out0, out1, (const lv_32fc_t *)in, num);
+    benchmark::DoNotOptimize(out0[0]);
+  }
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * 4 * num
+                          * sizeof(int16_t));
+  volk_free(in);
+  volk_free(out0);
+  volk_free(out1);
+}
+BENCHMARK(BM_deinterleave_sc16_x2)->Range(1 << 12, 1 << 18);
+
+/* device argument parsing, paid on every block instantiation */
+static void BM_params_to_dict(benchmark::State &state)
+{
+  const std::string args =
+      "rtl=0,buffers=32,buflen=65536,direct_samp=0,offset_tune=0,"
+      "label='Generic RTL2832U OEM'";
+
+  while (state.KeepRunning()) {
+    dict_t dict = params_to_dict(args);
+    benchmark::DoNotOptimize(dict.size());
+  }
+}
+BENCHMARK(BM_params_to_dict);
+
+/* one produce/consume cycle through the SPSC ring, uncontended */
+static void BM_ring_push_pop(benchmark::State &state)
+{
+  const unsigned int len = state.range(0);
+  ring_buffer ring(8, len);
+
+  while (state.KeepRunning()) {
+    char *wr = (char *)ring.write_ptr();
+    wr[0] = 1;
+    ring.write_done(len);
+
+    unsigned int avail = 0;
+    char *rd = (char *)ring.read_ptr(&avail);
+    benchmark::DoNotOptimize(rd[0]);
+    ring.read_done();
+  }
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * len);
+}
+BENCHMARK(BM_ring_push_pop)->Range(1 << 12, 1 << 18);
+
+static void drain_ring(ring_buffer *ring, bool *running)
+{
+  while (*running) {
+    ring->wait_for(1, *running);
+
+    unsigned int len = 0;
+    while (ring->read_ptr(&len))
+      ring->read_done();
+  }
+}
+
+/* ring throughput with a draining consumer thread, the steady state of
+ * a streaming callback feeding work() */
+static void BM_ring_contended(benchmark::State &state)
+{
+  const unsigned int len = state.range(0);
+  ring_buffer ring(8, len);
+  bool running = true;
+
+  boost::thread drain(drain_ring, &ring, &running);
+
+  while (state.KeepRunning()) {
+    /* back off when full instead of taking the overrun path, it logs */
+    if (ring.used() == ring.buf_num())
+      continue;
+
+    char *wr = (char *)ring.write_ptr();
+    if (wr) {
+      wr[0] = 1;
+      ring.write_done(len);
+    }
+  }
+
+  running = false;
+  ring.notify();
+  drain.join();
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * len);
+}
+BENCHMARK(BM_ring_contended)->Range(1 << 12, 1 << 18);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,24 @@
+INCLUDE(FindPkgConfig)
+PKG_CHECK_MODULES(PC_LIBZSTD libzstd)
+
+FIND_PATH(
+    LIBZSTD_INCLUDE_DIRS
+    NAMES zstd.h
+    HINTS $ENV{LIBZSTD_DIR}/include
+        ${PC_LIBZSTD_INCLUDEDIR}
+    PATHS /usr/local/include
+          /usr/include
+)
+
+FIND_LIBRARY(
+    LIBZSTD_LIBRARIES
+    NAMES zstd
+    HINTS $ENV{LIBZSTD_DIR}/lib
+        ${PC_LIBZSTD_LIBDIR}
+    PATHS /usr/local/lib
+          /usr/lib
+)
+
+INCLUDE(FindPackageHandleStandardArgs)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(LIBZSTD DEFAULT_MSG LIBZSTD_LIBRARIES LIBZSTD_INCLUDE_DIRS)
+MARK_AS_ADVANCED(LIBZSTD_LIBRARIES LIBZSTD_INCLUDE_DIRS)
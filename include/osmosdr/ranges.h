@@ -119,6 +119,20 @@ namespace osmosdr{
         //! Convert this meta-range to a printable string
         const std::string to_pp_string(void) const;
 
+    private:
+        /*!
+         * Cached index over the ranges: the monotonicity check, the
+         * overall bounds and the enumerated values are computed once
+         * on first query instead of on every call. The cache is
+         * rebuilt whenever the list of ranges no longer matches the
+         * fingerprint it was built for; modifying a range_t element
+         * in place is not detected (no caller does that, ranges are
+         * built once with push_back and queried afterwards).
+         */
+        struct index;
+        mutable boost::shared_ptr<index> _index;
+
+        index &fetch_index(void) const;
     };
 
     typedef meta_range_t gain_range_t;
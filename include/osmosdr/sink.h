@@ -25,6 +25,8 @@
 #include <osmosdr/time_spec.h>
 #include <gnuradio/hier_block2.h>
 
+#include <stdint.h>
+
 namespace osmosdr {
 
 class sink;
@@ -34,6 +36,12 @@ class sink;
  * \ingroup block
  *
  * This uses the preferred technique: subclassing gr::hier_block2.
+ *
+ * Stream tags attached to the input pass through to the hardware driver
+ * unchanged. Drivers with burst support (hackrf with the burst=1
+ * argument, bladerf with enable_metadata=1) honor the tx_sob/tx_eob
+ * tags or a packet_len length tag and keep the transmit pipeline idle
+ * between the tagged bursts.
  */
 class OSMOSDR_API sink : virtual public gr::hier_block2
 {
@@ -58,6 +66,29 @@ public:
    */
   virtual size_t get_num_channels( void ) = 0;
 
+  /*!
+   * Get the number of overflow events, i.e. samples the driver had to
+   * drop on the way to the device or medium, summed over all devices,
+   * since stream start or the last reset_stream_stats() call. Polling
+   * this is cheap, the counters live on the streaming path as relaxed
+   * atomics.
+   * \return the number of overflow events
+   */
+  virtual uint64_t get_num_overflows( void ) = 0;
+
+  /*!
+   * Get the number of underflow events, i.e. the hardware ran out of
+   * samples to transmit, summed over all devices, since stream start
+   * or the last reset_stream_stats() call.
+   * \return the number of underflow events
+   */
+  virtual uint64_t get_num_underflows( void ) = 0;
+
+  /*!
+   * Reset the overflow/underflow counters of all devices to zero.
+   */
+  virtual void reset_stream_stats( void ) = 0;
+
   /*!
    * Get the possible sample rates for the underlying radio hardware.
    * \return a range of rates in Sps
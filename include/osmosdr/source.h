@@ -23,8 +23,11 @@
 #include <osmosdr/api.h>
 #include <osmosdr/ranges.h>
 #include <osmosdr/time_spec.h>
+#include <osmosdr/tune_request.h>
 #include <gnuradio/hier_block2.h>
 
+#include <stdint.h>
+
 namespace osmosdr {
 
 class source;
@@ -47,6 +50,19 @@ public:
    * constructor is private.  osmosdr::source::make is the public
    * interface for creating new instances.
    *
+   * The "wire_format" argument selects the item type of the output
+   * stream: "fc32" (complex float, the default), "sc16" or "sc8"
+   * (interleaved signed integer IQ). The native formats avoid the 4x
+   * inflation to float for backends that support them; currently the
+   * rtl backend implements "sc8".
+   *
+   * Although the returned block is a hier_block2 wrapping the driver
+   * block(s), this costs nothing at runtime: GNU Radio flattens the
+   * hierarchy when the flow graph starts, so with a single device and
+   * no correction chain in between (see the "iq_balance" argument) the
+   * driver block's output buffer is consumed directly by the
+   * downstream block with no intermediate copy or scheduler hop.
+   *
    * \param args the address to identify the hardware
    * \return a new osmosdr source block object
    */
@@ -67,6 +83,63 @@ public:
    */
   virtual bool seek( long seek_point, int whence, size_t chan = 0 ) = 0;
 
+  /*!
+   * \brief seek file to \p seconds from the start of the capture
+   *
+   * The time offset is resolved against the file's original sample
+   * rate, so a position in a multi-hour recording is reached directly
+   * instead of being converted to sample counts by the application.
+   * \param seconds	time offset into the file
+   * \param chan the channel index 0 to N-1
+   * \return true on success
+   */
+  virtual bool seek_time( double seconds, size_t chan = 0 ) = 0;
+
+  /*!
+   * Get the number of overflow events, i.e. samples the hardware had
+   * to drop because the flow graph did not consume them in time,
+   * summed over all devices, since stream start or the last
+   * reset_stream_stats() call. Polling this is cheap, the counters
+   * live on the streaming path as relaxed atomics.
+   * \return the number of overflow events
+   */
+  virtual uint64_t get_num_overflows( void ) = 0;
+
+  /*!
+   * Get the number of underflow events summed over all devices since
+   * stream start or the last reset_stream_stats() call.
+   * \return the number of underflow events
+   */
+  virtual uint64_t get_num_underflows( void ) = 0;
+
+  /*!
+   * Reset the overflow/underflow counters of all devices to zero.
+   */
+  virtual void reset_stream_stats( void ) = 0;
+
+  /*!
+   * Drop the cached tuner settings (sample rate, frequency, correction,
+   * gain mode, gain). Getters normally answer from this cache so that
+   * high rate telemetry polling stays off the control bus; after this
+   * call the next getter queries the hardware again and refills it. Use
+   * it when the device may have been retuned behind our back.
+   */
+  virtual void reset_settings_cache( void ) = 0;
+
+  /*!
+   * Discard the given number of samples from a channel's stream before
+   * producing again. This is the alignment primitive for coherent
+   * multi-device setups: receivers on a shared clock run at the same
+   * rate but start with a constant sample offset, so measure the
+   * offsets once (e.g. by cross-correlating against a reference
+   * channel) and trim each lagging channel accordingly. The samples
+   * are dropped on the streaming path without blocking the caller.
+   * Drivers without support ignore the call.
+   * \param count the number of samples to drop
+   * \param chan the channel index 0 to N-1
+   */
+  virtual void skip_samples( uint64_t count, size_t chan = 0 ) = 0;
+
   /*!
    * Get the possible sample rates for the underlying radio hardware.
    * \return a range of rates in Sps
@@ -111,6 +184,17 @@ public:
    */
   virtual double get_center_freq( size_t chan = 0 ) = 0;
 
+  /*!
+   * Tune several channels with a single call.
+   *
+   * Equivalent to calling set_center_freq() once per channel, but the
+   * per call overhead (binding dispatch for scripted scan loops, the
+   * virtual call chain) is paid once for the whole batch.
+   * \param freqs the desired frequencies in Hz, one entry per channel
+   * \return the actual frequencies in Hz, one entry per channel
+   */
+  virtual std::vector<double> set_center_freqs( const std::vector<double> &freqs ) = 0;
+
   /*!
    * Set the frequency correction value in parts per million.
    * \param ppm the desired correction value in parts per million
@@ -126,6 +210,23 @@ public:
    */
   virtual double get_freq_corr( size_t chan = 0 ) = 0;
 
+  /*!
+   * Apply a batch of settings as one transaction.
+   *
+   * Only the fields flagged in the request are touched. Compared to
+   * calling the individual setters this saves driver round-trips and
+   * lets drivers with hardware support program several parameters in
+   * a single control transfer, which cuts retune latency for
+   * frequency hopping applications. The sample rate, being common to
+   * all devices, is applied through the regular rate path; the
+   * remaining fields go to the device serving the given channel.
+   *
+   * \param request the settings to apply, see osmosdr::tune_request_t
+   * \param chan the channel index 0 to N-1
+   */
+  virtual void apply_settings( const tune_request_t &request,
+                               size_t chan = 0 ) = 0;
+
   /*!
    * Get the gain stage names of the underlying radio hardware.
    * \param chan the channel index 0 to N-1
@@ -201,6 +302,22 @@ public:
    */
   virtual double get_gain( const std::string & name, size_t chan = 0 ) = 0;
 
+  /*!
+   * Set the overall gain of several channels with a single call.
+   *
+   * Equivalent to calling set_gain() once per channel, but the per
+   * call overhead is paid once for the whole batch.
+   * \param gains the desired gains in dB, one entry per channel
+   * \return the actual gains in dB, one entry per channel
+   */
+  virtual std::vector<double> set_gains( const std::vector<double> &gains ) = 0;
+
+  /*!
+   * Get the actual overall gain setting of every channel in one call.
+   * \return the actual gains in dB, one entry per channel
+   */
+  virtual std::vector<double> get_gains( void ) = 0;
+
   /*!
    * Set the IF gain for the underlying radio hardware.
    * This function will automatically distribute the desired gain value over
@@ -415,6 +532,51 @@ public:
    * \param time_spec the new time
    */
   virtual void set_time_unknown_pps(const ::osmosdr::time_spec_t &time_spec) = 0;
+
+  /*!
+   * Schedule subsequent setter calls for execution at the given device
+   * time. All frequency, gain etc. changes issued while a command time
+   * is active are queued by the hardware and applied in the same
+   * instant, which keeps multiple channels phase aligned. Use
+   * clear_command_time() to return to immediate execution.
+   *
+   * Devices without a timed-command queue apply settings immediately.
+   *
+   * \param time_spec the absolute device time to latch the commands at
+   * \param mboard the motherboard index 0 to M-1
+   */
+  virtual void set_command_time(const ::osmosdr::time_spec_t &time_spec,
+                                size_t mboard = 0) = 0;
+
+  /*!
+   * Return to immediate execution of setter calls.
+   * \param mboard the motherboard index 0 to M-1
+   */
+  virtual void clear_command_time(size_t mboard = 0) = 0;
+
+  /*!
+   * Defer streaming to the given device time instead of starting as
+   * soon as the flow graph runs. All channels of the device begin with
+   * the same first sample time, so a shared trigger for coherent
+   * arrays comes for free. Must be called before the flow graph is
+   * started.
+   *
+   * \param time_spec the absolute device time to start streaming at
+   */
+  virtual void set_start_time(const ::osmosdr::time_spec_t &time_spec) = 0;
+
+  /*!
+   * Align streaming across all underlying devices in two phases: every
+   * device's producer is gated first so no new samples enter the
+   * buffers, then all of them are released back to back, so the start
+   * skew between devices is bounded by a flag store per device. The
+   * streams themselves stay up throughout, making the call safe while
+   * the flow graph runs; devices without gating support pass through
+   * unaffected. Backends with a device clock are aligned exactly by
+   * calling set_start_time() beforehand; for the rest this release
+   * barrier is the best the hardware offers.
+   */
+  virtual void start_synchronized() = 0;
 };
 
 } /* namespace osmosdr */
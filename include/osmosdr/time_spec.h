@@ -76,6 +76,23 @@ namespace osmosdr{
          */
         static time_spec_t from_ticks(long long ticks, double tick_rate);
 
+        /*!
+         * Create a time_spec_t from an integer nanosecond count.
+         * Fast path for nanosecond-granularity clock domains: the split
+         * into whole and fractional seconds is pure integer arithmetic
+         * and the result needs no re-normalization.
+         * \param nsecs an integer count of nanoseconds
+         */
+        static time_spec_t from_nsecs(long long nsecs);
+
+        /*!
+         * Convert the time spec into an integer nanosecond count.
+         * Counterpart of from_nsecs(), the whole seconds contribute
+         * through an integer multiplication only.
+         * \return an integer number of nanoseconds
+         */
+        long long to_nsecs(void) const;
+
         /*!
          * Convert the fractional seconds to clock ticks.
          * Translation into clock-domain specific units.
@@ -0,0 +1,65 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2012 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_OSMOSDR_TUNE_REQUEST_H
+#define INCLUDED_OSMOSDR_TUNE_REQUEST_H
+
+#include <osmosdr/api.h>
+
+namespace osmosdr {
+
+/*!
+ * A batch of settings to be applied as one transaction via
+ * apply_settings(). Only the fields whose set_* flag is true are
+ * touched, everything else keeps its current value. Frequency hopping
+ * applications fill in frequency, gain and rate once and hand the
+ * request over instead of paying a full driver round-trip per setter.
+ */
+struct OSMOSDR_API tune_request_t
+{
+    //! Create an empty request, fill in the desired fields afterwards.
+    tune_request_t(void):
+        rate(0), freq(0), freq_corr(0), gain(0),
+        set_rate(false), set_freq(false),
+        set_freq_corr(false), set_gain(false)
+    {
+        /* NOP */
+    }
+
+    //! sample rate in samples/s, applied when set_rate is true
+    double rate;
+
+    //! center frequency in Hz, applied when set_freq is true
+    double freq;
+
+    //! frequency correction in ppm, applied when set_freq_corr is true
+    double freq_corr;
+
+    //! overall gain in dB, applied when set_gain is true
+    double gain;
+
+    bool set_rate;
+    bool set_freq;
+    bool set_freq_corr;
+    bool set_gain;
+};
+
+} /* namespace osmosdr */
+
+#endif /* INCLUDED_OSMOSDR_TUNE_REQUEST_H */
@@ -38,11 +38,15 @@
 #include <boost/thread/thread.hpp>
 
 #include <gnuradio/io_signature.h>
+#include <osmosdr/time_spec.h>
+
+#include <volk/volk.h>
 
 #include "airspy_source_c.h"
 #include "airspy_fir_kernels.h"
 
 #include "arg_helpers.h"
+#include "osmosdr_trace.h"
 
 using namespace boost::assign;
 
@@ -86,6 +90,12 @@ airspy_source_c::airspy_source_c (const std::string &args)
         gr::io_signature::make(MIN_IN, MAX_IN, sizeof (gr_complex)),
         gr::io_signature::make(MIN_OUT, MAX_OUT, sizeof (gr_complex))),
     _dev(NULL),
+    _native(false),
+    _conv_buf(NULL),
+    _conv_items(0),
+    _overflows(0),
+    _time_tag_pending(false),
+    _tagged_overruns(0),
     _sample_rate(0),
     _center_freq(0),
     _freq_corr(0),
@@ -94,7 +104,8 @@ airspy_source_c::airspy_source_c (const std::string &args)
     _lna_gain(0),
     _mix_gain(0),
     _vga_gain(0),
-    _bandwidth(0)
+    _bandwidth(0),
+    _fir_len(0)
 {
   int ret;
 
@@ -169,11 +180,59 @@ airspy_source_c::airspy_source_c (const std::string &args)
     AIRSPY_THROW_ON_ERROR(ret, "Failed to set USB bit packing")
   }
 
+/* fir_len forces a fixed conversion filter length instead of the
+ * decimation based pick in set_bandwidth(). shorter kernels trade
+ * stopband attenuation for conversion CPU time, which matters on small
+ * hosts. supported lengths match the shipped kernels. */
+  if ( dict.count( "fir_len" ) )
+  {
+    int fir_len = boost::lexical_cast<int>( dict["fir_len"] );
+    if ( fir_len != 0 &&
+         fir_len != KERNEL_16_110_LEN &&
+         fir_len != KERNEL_8_100_LEN &&
+         fir_len != KERNEL_4_90_LEN &&
+         fir_len != KERNEL_2_80_LEN )
+      throw std::runtime_error(
+            boost::str( boost::format("Unsupported fir_len %d, "
+                                      "use one of 0 (auto), %d, %d, %d, %d")
+                        % fir_len
+                        % KERNEL_16_110_LEN % KERNEL_8_100_LEN
+                        % KERNEL_4_90_LEN % KERNEL_2_80_LEN ) );
+    _fir_len = fir_len;
+  }
+
+/* native=1 keeps the samples in their native width end to end: packed
+ * 12 bit words on the USB bus and int16 IQ out of libairspy, so its
+ * conversion threads move half the bytes, and the block inflates to
+ * float itself with a volk kernel. Note the USB link always carries
+ * the raw 12 bit ADC words no matter which host side sample type is
+ * selected, so the wire saving comes entirely from the bit packing. */
+  if ( dict.count( "native" ) )
+  {
+    bool native = boost::lexical_cast<bool>( dict["native"] );
+    if ( native )
+    {
+      int ret = airspy_set_packing(_dev, 1);
+      AIRSPY_THROW_ON_ERROR(ret, "Failed to set USB bit packing")
+
+      ret = airspy_set_sample_type(_dev, AIRSPY_SAMPLE_INT16_IQ);
+      AIRSPY_THROW_ON_ERROR(ret, "Failed to set int16 sample type")
+
+      _native = true;
+    }
+  }
+
   _fifo = new boost::circular_buffer<gr_complex>(5000000);
   if (!_fifo) {
     throw std::runtime_error( std::string(__FUNCTION__) + " " +
                               "Failed to allocate a sample FIFO!" );
   }
+
+  /* Set up constraints: produce in aligned full SIMD widths so the
+   * conversion kernels never have to run a scalar tail */
+  int const alignment_multiple = volk_get_alignment() / sizeof(gr_complex);
+  set_alignment(std::max(1, alignment_multiple));
+  set_output_multiple(std::max(1, alignment_multiple));
 }
 
 /*
@@ -206,6 +265,12 @@ airspy_source_c::~airspy_source_c ()
     delete _fifo;
     _fifo = NULL;
   }
+
+  if (_conv_buf)
+  {
+    volk_free(_conv_buf);
+    _conv_buf = NULL;
+  }
 }
 
 int airspy_source_c::_airspy_rx_callback(airspy_transfer *transfer)
@@ -217,9 +282,27 @@ int airspy_source_c::_airspy_rx_callback(airspy_transfer *transfer)
 
 int airspy_source_c::airspy_rx_callback(void *samples, int sample_count)
 {
+  OSMOSDR_TRACE1(airspy_callback, sample_count);
+
   size_t i, n_avail, to_copy, num_samples = sample_count;
   float *sample = (float *)samples;
 
+  if (_native) {
+    /* libairspy delivers full scale int16 IQ here, inflate to float
+     * with the SIMD kernel before feeding the fifo */
+    if (_conv_items < 2 * sample_count) {
+      if (_conv_buf)
+        volk_free(_conv_buf);
+      _conv_items = 2 * sample_count;
+      _conv_buf = (float *)volk_malloc(_conv_items * sizeof(float),
+                                       volk_get_alignment());
+    }
+
+    volk_16i_s32f_convert_32f(_conv_buf, (const int16_t *)samples,
+                              32768.f, 2 * sample_count);
+    sample = _conv_buf;
+  }
+
   _fifo_lock.lock();
 
   n_avail = _fifo->capacity() - _fifo->size();
@@ -243,8 +326,11 @@ int airspy_source_c::airspy_rx_callback(void *samples, int sample_count)
   }
 
   /* Indicate overrun, if neccesary */
-  if (to_copy < num_samples)
+  if (to_copy < num_samples) {
+    _overflows.fetch_add(1, boost::memory_order_relaxed);
+    OSMOSDR_TRACE1(airspy_overrun, num_samples - to_copy);
     std::cerr << "O" << std::flush;
+  }
 
   return 0; // TODO: return -1 on error/stop
 }
@@ -254,6 +340,9 @@ bool airspy_source_c::start()
   if ( ! _dev )
     return false;
 
+  _time_tag_pending = true;
+  _tagged_overruns = _overflows.load(boost::memory_order_relaxed);
+
   int ret = airspy_start_rx( _dev, _airspy_rx_callback, (void *)this );
   if ( ret != AIRSPY_SUCCESS ) {
     std::cerr << "Failed to start RX streaming (" << ret << ")" << std::endl;
@@ -283,6 +372,8 @@ int airspy_source_c::work( int noutput_items,
 {
   gr_complex *out = (gr_complex *)output_items[0];
 
+  OSMOSDR_TRACE1(airspy_work_entry, noutput_items);
+
   bool running = false;
 
   if ( _dev )
@@ -301,6 +392,24 @@ int airspy_source_c::work( int noutput_items,
     n_samples_avail = _fifo->size();
   }
 
+  /* (re)stamp the stream on start and after overruns so downstream
+   * blocks can resynchronize instead of correlating continuously */
+  uint64_t overruns = _overflows.load(boost::memory_order_relaxed);
+  if (_time_tag_pending || overruns != _tagged_overruns) {
+    osmosdr::time_spec_t now = osmosdr::time_spec_t::get_system_time();
+    add_item_tag(0, nitems_written(0),
+                 pmt::mp("rx_time"),
+                 pmt::make_tuple(pmt::from_uint64(now.get_full_secs()),
+                                 pmt::from_double(now.get_frac_secs())),
+                 pmt::mp(alias()));
+    add_item_tag(0, nitems_written(0),
+                 pmt::mp("rx_rate"),
+                 pmt::from_double(get_sample_rate()),
+                 pmt::mp(alias()));
+    _time_tag_pending = false;
+    _tagged_overruns = overruns;
+  }
+
   for(int i = 0; i < noutput_items; ++i) {
     out[i] = _fifo->at(0);
     _fifo->pop_front();
@@ -308,6 +417,8 @@ int airspy_source_c::work( int noutput_items,
 
   //std::cerr << "-" << std::flush;
 
+  OSMOSDR_TRACE1(airspy_work_exit, noutput_items);
+
   return noutput_items;
 }
 
@@ -346,6 +457,26 @@ size_t airspy_source_c::get_num_channels()
   return 1;
 }
 
+uint64_t airspy_source_c::get_num_overflows()
+{
+  return _overflows.load(boost::memory_order_relaxed);
+}
+
+void airspy_source_c::reset_stream_stats()
+{
+  _overflows.store(0, boost::memory_order_relaxed);
+}
+
+double airspy_source_c::get_buffer_level()
+{
+  if ( ! _fifo )
+    return 0;
+
+  boost::mutex::scoped_lock lock(_fifo_lock);
+
+  return _fifo->size() / (double)_fifo->capacity();
+}
+
 osmosdr::meta_range_t airspy_source_c::get_sample_rates()
 {
   osmosdr::meta_range_t range;
@@ -431,9 +562,18 @@ double airspy_source_c::get_center_freq( size_t chan )
 
 double airspy_source_c::set_freq_corr( double ppm, size_t chan )
 {
+  if ( ppm == _freq_corr )
+    return get_freq_corr( chan );
+
+  /* the tuner is programmed with integer granularity, so small
+   * calibration steps often leave the corrected frequency unchanged;
+   * skip the tuner transaction entirely in that case */
+  double prev = APPLY_PPM_CORR( _center_freq, _freq_corr );
+
   _freq_corr = ppm;
 
-  set_center_freq( _center_freq );
+  if ( uint64_t( APPLY_PPM_CORR( _center_freq, ppm ) ) != uint64_t( prev ) )
+    set_center_freq( _center_freq );
 
   return get_freq_corr( chan );
 }
@@ -666,7 +806,29 @@ double airspy_source_c::set_bandwidth( double bandwidth, size_t chan )
 //      size = 0;
 //    }
 //    else
-    if (decim < 4)
+    /* a fir_len device arg pins the filter length regardless of the
+     * decimation, so the conversion cost can be dialed per host */
+    if (KERNEL_16_110_LEN == _fir_len)
+    {
+      kernel = KERNEL_16_110;
+      size = KERNEL_16_110_LEN;
+    }
+    else if (KERNEL_8_100_LEN == _fir_len)
+    {
+      kernel = KERNEL_8_100;
+      size = KERNEL_8_100_LEN;
+    }
+    else if (KERNEL_4_90_LEN == _fir_len)
+    {
+      kernel = KERNEL_4_90;
+      size = KERNEL_4_90_LEN;
+    }
+    else if (KERNEL_2_80_LEN == _fir_len)
+    {
+      kernel = KERNEL_2_80;
+      size = KERNEL_2_80_LEN;
+    }
+    else if (decim < 4)
     {
       kernel = KERNEL_2_80;
       size = KERNEL_2_80_LEN;
@@ -22,6 +22,7 @@
 #ifndef INCLUDED_AIRSPY_SOURCE_C_H
 #define INCLUDED_AIRSPY_SOURCE_C_H
 
+#include <boost/atomic.hpp>
 #include <boost/circular_buffer.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/condition_variable.hpp>
@@ -89,6 +90,10 @@ public:
 
   size_t get_num_channels( void );
 
+  uint64_t get_num_overflows( void );
+  void reset_stream_stats( void );
+  double get_buffer_level( void );
+
   osmosdr::meta_range_t get_sample_rates( void );
   double set_sample_rate( double rate );
   double get_sample_rate( void );
@@ -127,10 +132,18 @@ private:
 
   airspy_device *_dev;
 
+  bool _native; /* packed 12 bit USB transfers, int16 IQ from libairspy */
+  float *_conv_buf; /* volk-aligned staging area for int16 to float */
+  int _conv_items;
+
   boost::circular_buffer<gr_complex> *_fifo;
   boost::mutex _fifo_lock;
+  boost::atomic<uint64_t> _overflows;
   boost::condition_variable _samp_avail;
 
+  bool _time_tag_pending;    /* stamp rx_time/rx_rate on the next sample */
+  uint64_t _tagged_overruns; /* overrun count at the last stamp */
+
   std::vector< std::pair<double, uint32_t> > _sample_rates;
   double _sample_rate;
   double _center_freq;
@@ -147,6 +160,7 @@ private:
   double _mix_gain;
   double _vga_gain;
   double _bandwidth;
+  int _fir_len; /* forced conversion filter length, 0 = auto by decimation */
 };
 
 #endif /* INCLUDED_AIRSPY_SOURCE_C_H */
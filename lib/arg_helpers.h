@@ -21,6 +21,7 @@
 #ifndef OSMOSDR_ARG_HELPERS_H
 #define OSMOSDR_ARG_HELPERS_H
 
+#include <cstdlib>
 #include <iostream>
 #include <vector>
 #include <map>
@@ -110,6 +111,107 @@ inline dict_t params_to_dict( const std::string &params )
   return result;
 }
 
+/*!
+ * Device arguments parsed once into key/value form with typed
+ * accessors. boost::lexical_cast spins up a complete iostream for
+ * every conversion; the accessors below use strtod/strtol instead,
+ * and a single object can be handed around so the argument string is
+ * tokenized once per block instead of once per helper. Accessors
+ * return the given default when the key is absent or its value does
+ * not parse.
+ */
+class device_args_t
+{
+public:
+  device_args_t( const std::string &args = "" )
+    : _dict( params_to_dict( args ) )
+  {
+  }
+
+  bool has( const std::string &key ) const
+  {
+    return _dict.count( key ) > 0;
+  }
+
+  std::string to_string( const std::string &key,
+                         const std::string &def = "" ) const
+  {
+    dict_t::const_iterator it = _dict.find( key );
+    return ( it == _dict.end() ) ? def : it->second;
+  }
+
+  double to_double( const std::string &key, double def = 0 ) const
+  {
+    dict_t::const_iterator it = _dict.find( key );
+    if ( it == _dict.end() || it->second.empty() )
+      return def;
+
+    char *end = NULL;
+    double value = strtod( it->second.c_str(), &end );
+    return ( end != NULL && *end == '\0' ) ? value : def;
+  }
+
+  long to_long( const std::string &key, long def = 0 ) const
+  {
+    dict_t::const_iterator it = _dict.find( key );
+    if ( it == _dict.end() || it->second.empty() )
+      return def;
+
+    char *end = NULL;
+    long value = strtol( it->second.c_str(), &end, 0 );
+    return ( end != NULL && *end == '\0' ) ? value : def;
+  }
+
+  unsigned int to_uint( const std::string &key, unsigned int def = 0 ) const
+  {
+    long value = to_long( key, (long) def );
+    return ( value < 0 ) ? def : (unsigned int) value;
+  }
+
+  bool to_bool( const std::string &key, bool def = false ) const
+  {
+    dict_t::const_iterator it = _dict.find( key );
+    if ( it == _dict.end() )
+      return def;
+
+    const std::string &value = it->second;
+    if ( value.empty() || "1" == value || "true" == value ||
+         "on" == value || "yes" == value )
+      return true;
+    if ( "0" == value || "false" == value ||
+         "off" == value || "no" == value )
+      return false;
+
+    return def;
+  }
+
+  const dict_t &dict( void ) const
+  {
+    return _dict;
+  }
+
+private:
+  dict_t _dict;
+};
+
+/*!
+ * Item size of the wire format requested via the "wire_format" device
+ * argument. "fc32" (the default) is complex float, "sc16" and "sc8"
+ * are interleaved signed integer IQ as exchanged with the hardware,
+ * usable on the source output as well as on the sink input.
+ */
+inline size_t wire_format_item_size( const std::string &format )
+{
+  if ( "sc8" == format )
+    return 2 * sizeof(char);
+  else if ( "sc16" == format )
+    return 2 * sizeof(short);
+  else if ( "fc32" == format || format.empty() )
+    return sizeof(gr_complex);
+
+  throw std::runtime_error("Unknown wire format '" + format + "'.");
+}
+
 struct is_nchan_argument
 {
   bool operator ()(const std::string &str)
@@ -122,6 +224,7 @@ inline gr::io_signature::sptr args_to_io_signature( const std::string &args )
 {
   size_t max_nchan = 0;
   size_t dev_nchan = 0;
+  size_t item_size = sizeof(gr_complex);
   std::vector< std::string > arg_list = args_to_vector( args );
 
   BOOST_FOREACH( std::string arg, arg_list )
@@ -133,6 +236,13 @@ inline gr::io_signature::sptr args_to_io_signature( const std::string &args )
     }
   }
 
+  BOOST_FOREACH( std::string arg, arg_list )
+  {
+    dict_t dict = params_to_dict(arg);
+    if (dict.count("wire_format")) // native stream format requested
+      item_size = wire_format_item_size( dict["wire_format"] );
+  }
+
   arg_list.erase( std::remove_if( // remove any global nchan tokens
                     arg_list.begin(),
                     arg_list.end(),
@@ -159,7 +269,7 @@ inline gr::io_signature::sptr args_to_io_signature( const std::string &args )
     throw std::runtime_error("Wrong device arguments specified. Missing nchan?");
 
   const size_t nchan = std::max<size_t>(dev_nchan, 1); // assume at least one
-  return gr::io_signature::make(nchan, nchan, sizeof(gr_complex));
+  return gr::io_signature::make(nchan, nchan, item_size);
 }
 
 #endif // OSMOSDR_ARG_HELPERS_H
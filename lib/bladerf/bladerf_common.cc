@@ -40,6 +40,12 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/weak_ptr.hpp>
 
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#endif
+
 #include "bladerf_common.h"
 
 /* Defaults for these values. */
@@ -52,6 +58,7 @@ using namespace boost::assign;
 
 boost::mutex bladerf_common::_devs_mutex;
 std::list<boost::weak_ptr<struct bladerf>> bladerf_common::_devs;
+std::list<bladerf_sptr> bladerf_common::_pinned_devs;
 
 /* name for system-wide gain (which is not its own libbladeRF gain stage) */
 static const char *SYSTEM_GAIN_NAME = "system";
@@ -221,6 +228,14 @@ void bladerf_common::init(dict_t const &dict, bladerf_direction direction)
                   "'%s': _dev is NULL") % device_name));
   }
 
+  /* keepalive=1 parks a strong reference to the session, so tearing the
+   * flowgraph down no longer closes the device: the next instantiation
+   * hits the handle cache and reattaches in milliseconds, skipping USB
+   * enumeration, FPGA verification and re-initialization entirely */
+  if (dict.count("keepalive")) {
+    pin_device(_dev);
+  }
+
   /* Load a FPGA */
   if (dict.count("fpga")) {
     if (dict.count("fpga-reload") == 0 &&
@@ -353,6 +368,23 @@ void bladerf_common::init(dict_t const &dict, bladerf_direction direction)
                 % _num_buffers
                 % _samples_per_buffer
                 % _num_transfers));
+
+  /* Page-locked stream buffers. libbladeRF allocates and owns the USB
+   * transfer buffers configured above, so the only way to keep them
+   * resident at high sample rates is to pin the whole process, present
+   * and future mappings included. */
+  if (dict.count("mlock")) {
+#ifndef _WIN32
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+      BLADERF_WARNING("Failed to lock memory: " << strerror(errno)
+                      << ". Try raising the memlock rlimit.");
+    } else {
+      BLADERF_INFO("Memory locked, stream buffers will not be paged out");
+    }
+#else
+    BLADERF_WARNING("Memory locking is not supported on this platform");
+#endif
+  }
 }
 
 std::vector<std::string> bladerf_common::devices()
@@ -1131,6 +1163,19 @@ void bladerf_common::close(void *dev)
   bladerf_close(static_cast<struct bladerf *>(dev));
 }
 
+void bladerf_common::pin_device(bladerf_sptr dev)
+{
+  boost::unique_lock<boost::mutex> lock(_devs_mutex);
+
+  BOOST_FOREACH(bladerf_sptr pinned, _pinned_devs) {
+    if (pinned.get() == dev.get()) {
+      return;
+    }
+  }
+
+  _pinned_devs.push_back(dev);
+}
+
 bladerf_sptr bladerf_common::get_cached_device(struct bladerf_devinfo devinfo)
 {
   /* Lock to _devs must be aquired by caller */
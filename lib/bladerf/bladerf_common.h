@@ -279,6 +279,8 @@ private:
   static void close(void *dev);
   /* If a device described by devinfo is open, this returns a sptr to it */
   static bladerf_sptr get_cached_device(struct bladerf_devinfo devinfo);
+  /* Keep a strong reference so the handle survives block teardown */
+  static void pin_device(bladerf_sptr dev);
   /* Prints a summary of device information */
   void print_device_info();
 
@@ -289,6 +291,7 @@ private:
    ****************************************************************************/
   static boost::mutex _devs_mutex;  /**< mutex for access to _devs */
   static std::list<boost::weak_ptr<struct bladerf>> _devs;  /**< dev cache */
+  static std::list<bladerf_sptr> _pinned_devs; /**< keepalive=1 sessions */
 };
 
 #endif
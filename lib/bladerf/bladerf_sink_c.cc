@@ -116,7 +116,7 @@ bladerf_sink_c::bladerf_sink_c(const std::string &args) :
   int const alignment_multiple = volk_get_alignment() / sizeof(gr_complex);
   set_alignment(std::max(1,alignment_multiple));
   set_max_noutput_items(_samples_per_buffer);
-  set_output_multiple(get_num_channels());
+  set_output_multiple(get_num_channels() * std::max(1, alignment_multiple));
 
   /* Set channel layout */
   _layout = (get_num_channels() > 1) ? BLADERF_TX_X2 : BLADERF_TX_X1;
@@ -305,6 +305,11 @@ int bladerf_sink_c::transmit_with_tags(int16_t const *samples,
   int const INVALID_IDX = -1;
   int16_t const zeros[8] = { 0 };
 
+  // a tx_time tag at the burst start offset schedules the burst on the
+  // FPGA timestamp counter instead of transmitting immediately
+  bool have_time = false;
+  uint64_t timestamp = 0;
+
   memset(&meta, 0, sizeof(meta));
 
   BLADERF_DEBUG("transmit_with_tags(" << noutput_items << ")");
@@ -343,10 +348,36 @@ int bladerf_sink_c::transmit_with_tags(int16_t const *samples,
 
         BLADERF_DEBUG("Got SOB " << start_idx << " samples into work payload");
 
-        meta.flags |= (BLADERF_META_FLAG_TX_NOW | BLADERF_META_FLAG_TX_BURST_START);
+        meta.flags |= BLADERF_META_FLAG_TX_BURST_START;
+
+        if (have_time) {
+          meta.timestamp = timestamp;
+        } else {
+          meta.flags |= BLADERF_META_FLAG_TX_NOW;
+        }
+
         _in_burst = true;
       }
 
+    } else if (pmt::symbol_to_string(tag.key) == "tx_time") {
+      // UHD style tuple of (uint64 full seconds, double fractional
+      // seconds), converted into ticks of the FPGA sample counter
+      uint64_t full_secs = pmt::to_uint64(pmt::tuple_ref(tag.value, 0));
+      double frac_secs = pmt::to_double(pmt::tuple_ref(tag.value, 1));
+      double rate = bladerf_common::get_sample_rate(chan2channel(BLADERF_TX, 0));
+
+      timestamp = full_secs * static_cast<uint64_t>(rate)
+                  + static_cast<uint64_t>(frac_secs * rate + 0.5);
+      have_time = true;
+
+      if (_in_burst) {
+        // tx_sob was already seen at this offset, reschedule the burst
+        meta.timestamp = timestamp;
+        meta.flags &= ~BLADERF_META_FLAG_TX_NOW;
+      }
+
+      BLADERF_DEBUG("Got tx_time, burst scheduled @ " << timestamp);
+
     } else if (pmt::symbol_to_string(tag.key) == "tx_eob") {
       if (!_in_burst) {
         BLADERF_WARNING("Got EOB while not in burst");
@@ -391,6 +422,9 @@ int bladerf_sink_c::transmit_with_tags(int16_t const *samples,
       start_idx = INVALID_IDX;
       end_idx = (noutput_items - 1);
       meta.flags = 0;
+      meta.timestamp = 0;
+      have_time = false;
+      timestamp = 0;
       _in_burst = false;
 
       if (status != 0) {
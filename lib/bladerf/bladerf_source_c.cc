@@ -164,7 +164,7 @@ bladerf_source_c::bladerf_source_c(const std::string &args) :
   int const alignment_multiple = volk_get_alignment() / sizeof(gr_complex);
   set_alignment(std::max(1,alignment_multiple));
   set_max_noutput_items(_samples_per_buffer);
-  set_output_multiple(get_num_channels());
+  set_output_multiple(get_num_channels() * std::max(1, alignment_multiple));
 
   /* Set channel layout */
   _layout = (get_num_channels() > 1) ? BLADERF_RX_X2 : BLADERF_RX_X1;
@@ -322,26 +322,34 @@ int bladerf_source_c::work(int noutput_items,
     _failures = 0;
   }
 
-  // convert from int16_t to float
-  // output_items is gr_complex (2x float), so num_points is 2*noutput_items
-  volk_16i_s32f_convert_32f(reinterpret_cast<float *>(_32fcbuf), _16icbuf,
-                            SCALING_FACTOR, 2*noutput_items);
-
-  // copy the samples into output_items
   gr_complex **out = reinterpret_cast<gr_complex **>(&output_items[0]);
 
   if (nstreams > 1) {
-    // we need to deinterleave the multiplex as we copy
-    gr_complex const *deint_in = _32fcbuf;
-
-    for (size_t i = 0; i < (noutput_items/nstreams); ++i) {
-      for (size_t n = 0; n < nstreams; ++n) {
-        memcpy(out[n]++, deint_in++, sizeof(gr_complex));
-      }
+    // deinterleave the channel multiplex before converting: one SC16 Q11
+    // sample is exactly the width of one float, so the 32fc deinterleave
+    // kernel splits the two channels without touching the sample payload.
+    // _32fcbuf is large enough to hold both deinterleaved SC16 halves and
+    // serves as scratch space here.
+    int16_t *deint[2] = {
+      reinterpret_cast<int16_t *>(_32fcbuf),
+      reinterpret_cast<int16_t *>(_32fcbuf) + noutput_items
+    };
+
+    volk_32fc_deinterleave_32f_x2(reinterpret_cast<float *>(deint[0]),
+                                  reinterpret_cast<float *>(deint[1]),
+                                  reinterpret_cast<lv_32fc_t const *>(_16icbuf),
+                                  noutput_items/2);
+
+    // convert from int16_t to float, straight into the output buffers
+    for (size_t n = 0; n < nstreams; ++n) {
+      volk_16i_s32f_convert_32f(reinterpret_cast<float *>(out[n]), deint[n],
+                                SCALING_FACTOR, noutput_items);
     }
   } else {
-    // no deinterleaving to do: simply copy everything
-    memcpy(out[0], _32fcbuf, sizeof(gr_complex) * noutput_items);
+    // convert from int16_t to float
+    // output_items is gr_complex (2x float), so num_points is 2*noutput_items
+    volk_16i_s32f_convert_32f(reinterpret_cast<float *>(out[0]), _16icbuf,
+                              SCALING_FACTOR, 2*noutput_items);
   }
 
   return noutput_items;
@@ -0,0 +1,89 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <boost/thread/thread.hpp>
+
+#include <gnuradio/io_signature.h>
+
+#include "buffer_monitor.h"
+
+buffer_monitor_sptr make_buffer_monitor(
+    const std::vector< source_iface * > &devs, double interval_ms )
+{
+  return gnuradio::get_initial_sptr(
+      new buffer_monitor(devs, interval_ms) );
+}
+
+buffer_monitor::buffer_monitor( const std::vector< source_iface * > &devs,
+                                double interval_ms )
+  : gr::block("buffer_monitor",
+              gr::io_signature::make(0, 0, 0),
+              gr::io_signature::make(0, 0, 0)),
+    _devs(devs),
+    _interval_ms(interval_ms),
+    _running(false)
+{
+  message_port_register_out(pmt::mp("telemetry"));
+}
+
+buffer_monitor::~buffer_monitor()
+{
+}
+
+bool buffer_monitor::start()
+{
+  _running = true;
+  _thread = gr::thread::thread(_poll_task, this);
+
+  return true;
+}
+
+bool buffer_monitor::stop()
+{
+  _running = false;
+
+  if (_thread.joinable())
+    _thread.join();
+
+  return true;
+}
+
+void buffer_monitor::_poll_task( buffer_monitor *obj )
+{
+  obj->poll_task();
+}
+
+void buffer_monitor::poll_task()
+{
+  while (_running) {
+    boost::this_thread::sleep(
+        boost::posix_time::milliseconds((long)_interval_ms) );
+
+    if (!_running)
+      break;
+
+    pmt::pmt_t levels = pmt::make_f32vector(_devs.size(), 0);
+
+    for (size_t i = 0; i < _devs.size(); i++)
+      pmt::f32vector_set(levels, i, _devs[i]->get_buffer_level());
+
+    message_port_pub(pmt::mp("telemetry"), levels);
+  }
+}
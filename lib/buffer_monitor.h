@@ -0,0 +1,72 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_BUFFER_MONITOR_H
+#define OSMOSDR_BUFFER_MONITOR_H
+
+#include <gnuradio/block.h>
+#include <gnuradio/thread/thread.h>
+
+#include <vector>
+
+#include "source_iface.h"
+
+class buffer_monitor;
+
+typedef boost::shared_ptr< buffer_monitor > buffer_monitor_sptr;
+
+buffer_monitor_sptr make_buffer_monitor(
+    const std::vector< source_iface * > &devs, double interval_ms );
+
+/*!
+ * \brief Periodically publishes the buffer fill of a device group.
+ *
+ * A helper block without streams, carrying only the "telemetry"
+ * message port. A background thread polls get_buffer_level() of every
+ * device at a fixed interval and publishes the levels as a f32vector
+ * (one entry per device, 0.0 empty to 1.0 about to overflow), so a
+ * supervisor can react before samples are actually dropped.
+ */
+class buffer_monitor : public gr::block
+{
+private:
+  friend buffer_monitor_sptr make_buffer_monitor(
+      const std::vector< source_iface * > &devs, double interval_ms );
+
+  buffer_monitor( const std::vector< source_iface * > &devs,
+                  double interval_ms );
+
+public:
+  ~buffer_monitor();
+
+  bool start();
+  bool stop();
+
+private:
+  static void _poll_task( buffer_monitor *obj );
+  void poll_task();
+
+  std::vector< source_iface * > _devs;
+  double _interval_ms;
+
+  gr::thread::thread _thread;
+  bool _running;
+};
+
+#endif /* OSMOSDR_BUFFER_MONITOR_H */
@@ -0,0 +1,144 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2012 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_CONVERTER_H
+#define OSMOSDR_CONVERTER_H
+
+#include <gnuradio/gr_complex.h>
+
+#include <volk/volk.h>
+
+#include <cstring>
+
+/*!
+ * Shared sample format conversions for the drivers.
+ *
+ * The heavy lifting is delegated to volk, whose dispatcher ranks the
+ * available proto-kernels (generic, SSE, AVX, NEON, ...) once per
+ * process and then calls the fastest one for the host, so every driver
+ * gets the same ISA awareness without maintaining its own loops. The
+ * converter owns a volk-aligned staging area for the formats that need
+ * a recentering pass (unsigned wire formats), grown on demand and
+ * reused across calls.
+ *
+ * Use one converter per streaming thread, the staging area is not
+ * locked.
+ */
+class sample_converter
+{
+public:
+  sample_converter() : _stage(NULL), _stage_size(0) {}
+
+  ~sample_converter()
+  {
+    if (_stage)
+      volk_free(_stage);
+  }
+
+  /*!
+   * Convert unsigned 8 bit values to float, counted in individual
+   * values rather than I/Q pairs so the float-output blocks share the
+   * same kernel. The rtl-style wire format is centered around 127.4
+   * rather than 128, pass the residual as \p dc (0.6f / 128.0f) to
+   * take it out after scaling.
+   */
+  void u8_f32(float *out, const unsigned char *in,
+              unsigned int count, float dc = 0.0f)
+  {
+    signed char *stage = (signed char *)ensure(count);
+
+    for (unsigned int i = 0; i < count; i++)
+      stage[i] = (signed char)(in[i] ^ 0x80); /* recenter to signed */
+
+    volk_8i_s32f_convert_32f(out, stage, 128.0f, count);
+
+    if (dc != 0.0f)
+      for (unsigned int i = 0; i < count; i++)
+        out[i] += dc;
+  }
+
+  /*! Convert unsigned 8 bit I/Q to gr_complex, see u8_f32(). */
+  void u8_fc32(gr_complex *out, const unsigned char *in,
+               unsigned int samples, float dc = 0.0f)
+  {
+    u8_f32((float *)out, in, samples * 2, dc);
+  }
+
+  /*! Convert signed 8 bit I/Q to gr_complex. */
+  void s8_fc32(gr_complex *out, const signed char *in, unsigned int samples)
+  {
+    volk_8i_s32f_convert_32f((float *)out, in, 128.0f, samples * 2);
+  }
+
+  /*!
+   * Convert signed 16 bit I/Q to gr_complex. \p fullscale is the
+   * positive full scale of the ADC words, 32768 for true 16 bit
+   * samples or e.g. 2048 for 12 bit words in 16 bit containers.
+   */
+  void s16_fc32(gr_complex *out, const short *in, unsigned int samples,
+                float fullscale = 32768.0f)
+  {
+    volk_16i_s32f_convert_32f((float *)out, in, fullscale, samples * 2);
+  }
+
+  /*! Convert gr_complex to signed 8 bit I/Q with saturation. */
+  void fc32_s8(signed char *out, const gr_complex *in, unsigned int samples)
+  {
+    volk_32f_s32f_convert_8i((int8_t *)out, (const float *)in,
+                             127.0f, samples * 2);
+  }
+
+  /*! Convert gr_complex to unsigned 8 bit I/Q with saturation. */
+  void fc32_u8(unsigned char *out, const gr_complex *in, unsigned int samples)
+  {
+    signed char *stage = (signed char *)ensure(samples * 2);
+
+    volk_32f_s32f_convert_8i((int8_t *)stage, (const float *)in,
+                             127.0f, samples * 2);
+
+    for (unsigned int i = 0; i < samples * 2; i++)
+      out[i] = (unsigned char)(stage[i] ^ 0x80);
+  }
+
+  /*! Convert gr_complex to signed 16 bit I/Q with saturation. */
+  void fc32_s16(short *out, const gr_complex *in, unsigned int samples,
+                float fullscale = 32767.0f)
+  {
+    volk_32f_s32f_convert_16i(out, (const float *)in,
+                              fullscale, samples * 2);
+  }
+
+private:
+  void *ensure(size_t bytes)
+  {
+    if (bytes > _stage_size) {
+      if (_stage)
+        volk_free(_stage);
+      _stage = volk_malloc(bytes, volk_get_alignment());
+      _stage_size = bytes;
+    }
+
+    return _stage;
+  }
+
+  void *_stage;
+  size_t _stage_size;
+};
+
+#endif /* OSMOSDR_CONVERTER_H */
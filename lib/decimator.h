@@ -0,0 +1,113 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2012 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_DECIMATOR_H
+#define OSMOSDR_DECIMATOR_H
+
+#include <gnuradio/gr_complex.h>
+
+#include <stdint.h>
+#include <math.h>
+#include <vector>
+#include <stdexcept>
+
+/*!
+ * In-block CIC decimator for the narrowband case where the wanted rate
+ * is not in a device's supported list. The driver runs the hardware at
+ * an integer multiple and decimates right after sample conversion, so
+ * the stream never leaves the block at full rate.
+ *
+ * Classic 4 stage CIC on 64 bit fixed point accumulators; floating
+ * point integrators would lose precision over time as they grow, the
+ * fixed point registers are sized so they never overflow for the
+ * supported factors. The phase carries across calls, feed the stream
+ * in arbitrary chunks. Note the usual CIC passband droop towards
+ * fs/(2*decim), narrowband consumers near DC are unaffected.
+ *
+ * Use one decimator per streaming thread, the state is not locked.
+ */
+class cic_decimator
+{
+public:
+  static const unsigned int MAX_DECIM = 1024; /* keeps 16+4*log2(N) < 63 */
+
+  cic_decimator(unsigned int decim)
+    : _decim(decim),
+      _phase(0),
+      _integ(STAGES, std::complex<int64_t>(0, 0)),
+      _comb(STAGES, std::complex<int64_t>(0, 0))
+  {
+    if (decim < 2 || decim > MAX_DECIM)
+      throw std::invalid_argument("Decimation factor out of range.");
+
+    double gain = 32768.0; /* input quantization scale */
+    for (unsigned int s = 0; s < STAGES; s++)
+      gain *= decim;
+
+    _scale = 1.0 / gain;
+  }
+
+  /*!
+   * Decimate \p samples input items into \p out, which must hold at
+   * least samples / decim + 1 items. Returns the number of output
+   * items actually produced.
+   */
+  unsigned int process(gr_complex *out, const gr_complex *in,
+                       unsigned int samples)
+  {
+    unsigned int produced = 0;
+
+    for (unsigned int i = 0; i < samples; i++) {
+      std::complex<int64_t> acc((int64_t)lrintf(in[i].real() * 32768.0f),
+                                (int64_t)lrintf(in[i].imag() * 32768.0f));
+
+      for (unsigned int s = 0; s < STAGES; s++)
+        acc = _integ[s] += acc;
+
+      if (++_phase < _decim)
+        continue;
+
+      _phase = 0;
+
+      for (unsigned int s = 0; s < STAGES; s++) {
+        std::complex<int64_t> prev = _comb[s];
+        _comb[s] = acc;
+        acc -= prev;
+      }
+
+      out[produced++] = gr_complex(float(acc.real() * _scale),
+                                   float(acc.imag() * _scale));
+    }
+
+    return produced;
+  }
+
+  unsigned int decim(void) const { return _decim; }
+
+private:
+  static const unsigned int STAGES = 4;
+
+  unsigned int _decim;
+  unsigned int _phase; /* input samples since the last output */
+  std::vector< std::complex<int64_t> > _integ;
+  std::vector< std::complex<int64_t> > _comb;
+  double _scale;
+};
+
+#endif /* OSMOSDR_DECIMATOR_H */
@@ -20,10 +20,16 @@
 
 #include <osmosdr/device.h>
 #include <stdexcept>
+#include <boost/bind.hpp>
+#include <boost/bind/protect.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/foreach.hpp>
 #include <boost/format.hpp>
+#include <boost/function.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 #include <algorithm>
+#include <iostream>
 #include <sstream>
 
 #ifdef HAVE_CONFIG_H
@@ -90,6 +96,14 @@
 #include <freesrp_source_c.h>
 #endif
 
+#ifdef ENABLE_SYNTHETIC
+#include <synthetic_source_c.h>
+#endif
+
+#ifdef ENABLE_SHM
+#include <shm_source_c.h>
+#endif
+
 #include "arg_helpers.h"
 
 using namespace osmosdr;
@@ -135,6 +149,36 @@ std::string device_t::to_string(void) const
   return ss.str();
 }
 
+typedef std::vector< std::string > device_list_t;
+
+/*!
+ * Run a single backend's enumeration, catching whatever it may throw:
+ * a backend failing to probe must not hide the devices of the others.
+ */
+static void probe_backend( boost::function< device_list_t () > probe,
+                           device_list_t *result )
+{
+  try {
+    *result = probe();
+  } catch ( const std::exception &ex ) {
+    std::cerr << "Device enumeration failed: " << ex.what() << std::endl;
+  } catch ( ... ) {
+    std::cerr << "Device enumeration failed." << std::endl;
+  }
+}
+
+/* cache of the last enumeration result. probing pokes every piece of
+ * hardware and easily takes seconds, while GUIs tend to call find()
+ * several times in a row, so a short-lived cache pays off. the cache
+ * is dropped after CACHE_TIMEOUT, when the fake setting differs from
+ * the cached run or when a "refresh" hint is given. */
+#define CACHE_TIMEOUT  10 /* seconds */
+
+static devices_t _device_cache;
+static bool _device_cache_valid = false;
+static bool _device_cache_fake = true;
+static boost::posix_time::ptime _device_cache_time;
+
 devices_t device::find(const device_t &hint)
 {
   boost::mutex::scoped_lock lock(_device_mutex);
@@ -144,73 +188,153 @@ devices_t device::find(const device_t &hint)
   if ( hint.count("nofake") )
     fake = false;
 
+  boost::posix_time::ptime now =
+      boost::posix_time::microsec_clock::universal_time();
+
+  if ( hint.count("refresh") )
+    _device_cache_valid = false;
+
+  if ( _device_cache_valid &&
+       _device_cache_fake == fake &&
+       now - _device_cache_time < boost::posix_time::seconds(CACHE_TIMEOUT) )
+    return _device_cache;
+
   devices_t devices;
 
+  /* probe the backends in parallel: most of them poke hardware and
+   * wait on usb or network round trips, so the total discovery time
+   * is the slowest backend instead of the sum of all of them. the
+   * result is appended in the fixed order below to keep the device
+   * list stable across runs. */
+
+  device_list_t osmosdr_devs, fcd_devs, rtl_devs, uhd_devs, miri_devs,
+      sdrplay_devs, bladerf_devs, hackrf_devs, rfspace_devs, airspy_devs,
+      freesrp_devs, soapy_devs, rtl_tcp_devs, redpitaya_devs, file_devs,
+      synthetic_devs, shm_devs;
+
+  boost::thread_group probes;
+
 #ifdef ENABLE_OSMOSDR
-  BOOST_FOREACH( std::string dev, osmosdr_src_c::get_devices() )
-    devices.push_back( device_t(dev) );
+  probes.create_thread( boost::bind( probe_backend,
+      &osmosdr_src_c::get_devices, &osmosdr_devs ) );
 #endif
 #ifdef ENABLE_FCD
-  BOOST_FOREACH( std::string dev, fcd_source_c::get_devices() )
-    devices.push_back( device_t(dev) );
+  probes.create_thread( boost::bind( probe_backend,
+      &fcd_source_c::get_devices, &fcd_devs ) );
 #endif
 #ifdef ENABLE_RTL
-  BOOST_FOREACH( std::string dev, rtl_source_c::get_devices() )
-    devices.push_back( device_t(dev) );
+  probes.create_thread( boost::bind( probe_backend,
+      &rtl_source_c::get_devices, &rtl_devs ) );
 #endif
 #ifdef ENABLE_UHD
-  BOOST_FOREACH( std::string dev, uhd_source_c::get_devices() )
-    devices.push_back( device_t(dev) );
+  probes.create_thread( boost::bind( probe_backend,
+      &uhd_source_c::get_devices, &uhd_devs ) );
 #endif
 #ifdef ENABLE_MIRI
-  BOOST_FOREACH( std::string dev, miri_source_c::get_devices() )
-    devices.push_back( device_t(dev) );
+  probes.create_thread( boost::bind( probe_backend,
+      &miri_source_c::get_devices, &miri_devs ) );
 #endif
 #ifdef ENABLE_SDRPLAY
-  BOOST_FOREACH( std::string dev, sdrplay_source_c::get_devices() )
-    devices.push_back( device_t(dev) );
+  probes.create_thread( boost::bind( probe_backend,
+      &sdrplay_source_c::get_devices, &sdrplay_devs ) );
 #endif
 #ifdef ENABLE_BLADERF
-  BOOST_FOREACH( std::string dev, bladerf_source_c::get_devices() )
-    devices.push_back( device_t(dev) );
+  probes.create_thread( boost::bind( probe_backend,
+      &bladerf_source_c::get_devices, &bladerf_devs ) );
 #endif
 #ifdef ENABLE_HACKRF
-  BOOST_FOREACH( std::string dev, hackrf_source_c::get_devices() )
-    devices.push_back( device_t(dev) );
+  probes.create_thread( boost::bind( probe_backend,
+      &hackrf_source_c::get_devices, &hackrf_devs ) );
 #endif
 #ifdef ENABLE_RFSPACE
-  BOOST_FOREACH( std::string dev, rfspace_source_c::get_devices( fake ) )
-    devices.push_back( device_t(dev) );
+  probes.create_thread( boost::bind( probe_backend,
+      boost::protect( boost::bind( &rfspace_source_c::get_devices, fake ) ),
+      &rfspace_devs ) );
 #endif
 #ifdef ENABLE_AIRSPY
-  BOOST_FOREACH( std::string dev, airspy_source_c::get_devices() )
-    devices.push_back( device_t(dev) );
+  probes.create_thread( boost::bind( probe_backend,
+      &airspy_source_c::get_devices, &airspy_devs ) );
 #endif
 #ifdef ENABLE_FREESRP
-  BOOST_FOREACH( std::string dev, freesrp_source_c::get_devices() )
-    devices.push_back( device_t(dev) );
+  probes.create_thread( boost::bind( probe_backend,
+      &freesrp_source_c::get_devices, &freesrp_devs ) );
 #endif
 #ifdef ENABLE_SOAPY
-  BOOST_FOREACH( std::string dev, soapy_source_c::get_devices() )
-    devices.push_back( device_t(dev) );
+  probes.create_thread( boost::bind( probe_backend,
+      &soapy_source_c::get_devices, &soapy_devs ) );
 #endif
+#ifdef ENABLE_RTL_TCP
+  probes.create_thread( boost::bind( probe_backend,
+      boost::protect( boost::bind( &rtl_tcp_source_c::get_devices, fake ) ),
+      &rtl_tcp_devs ) );
+#endif
+#ifdef ENABLE_REDPITAYA
+  probes.create_thread( boost::bind( probe_backend,
+      boost::protect( boost::bind( &redpitaya_source_c::get_devices, fake ) ),
+      &redpitaya_devs ) );
+#endif
+#ifdef ENABLE_FILE
+  probes.create_thread( boost::bind( probe_backend,
+      boost::protect( boost::bind( &file_source_c::get_devices, fake ) ),
+      &file_devs ) );
+#endif
+#ifdef ENABLE_SYNTHETIC
+  probes.create_thread( boost::bind( probe_backend,
+      boost::protect( boost::bind( &synthetic_source_c::get_devices, fake ) ),
+      &synthetic_devs ) );
+#endif
+#ifdef ENABLE_SHM
+  probes.create_thread( boost::bind( probe_backend,
+      boost::protect( boost::bind( &shm_source_c::get_devices, fake ) ),
+      &shm_devs ) );
+#endif
+
+  probes.join_all();
+
+  BOOST_FOREACH( std::string dev, osmosdr_devs )
+    devices.push_back( device_t(dev) );
+  BOOST_FOREACH( std::string dev, fcd_devs )
+    devices.push_back( device_t(dev) );
+  BOOST_FOREACH( std::string dev, rtl_devs )
+    devices.push_back( device_t(dev) );
+  BOOST_FOREACH( std::string dev, uhd_devs )
+    devices.push_back( device_t(dev) );
+  BOOST_FOREACH( std::string dev, miri_devs )
+    devices.push_back( device_t(dev) );
+  BOOST_FOREACH( std::string dev, sdrplay_devs )
+    devices.push_back( device_t(dev) );
+  BOOST_FOREACH( std::string dev, bladerf_devs )
+    devices.push_back( device_t(dev) );
+  BOOST_FOREACH( std::string dev, hackrf_devs )
+    devices.push_back( device_t(dev) );
+  BOOST_FOREACH( std::string dev, rfspace_devs )
+    devices.push_back( device_t(dev) );
+  BOOST_FOREACH( std::string dev, airspy_devs )
+    devices.push_back( device_t(dev) );
+  BOOST_FOREACH( std::string dev, freesrp_devs )
+    devices.push_back( device_t(dev) );
+  BOOST_FOREACH( std::string dev, soapy_devs )
+    devices.push_back( device_t(dev) );
 
   /* software-only sources should be appended at the very end,
    * hopefully resulting in hardware sources to be shown first
    * in a graphical interface etc... */
 
-#ifdef ENABLE_RTL_TCP
-  BOOST_FOREACH( std::string dev, rtl_tcp_source_c::get_devices( fake ) )
+  BOOST_FOREACH( std::string dev, rtl_tcp_devs )
     devices.push_back( device_t(dev) );
-#endif
-#ifdef ENABLE_REDPITAYA
-  BOOST_FOREACH( std::string dev, redpitaya_source_c::get_devices( fake ) )
+  BOOST_FOREACH( std::string dev, redpitaya_devs )
     devices.push_back( device_t(dev) );
-#endif
-#ifdef ENABLE_FILE
-  BOOST_FOREACH( std::string dev, file_source_c::get_devices( fake ) )
+  BOOST_FOREACH( std::string dev, file_devs )
     devices.push_back( device_t(dev) );
-#endif
+  BOOST_FOREACH( std::string dev, synthetic_devs )
+    devices.push_back( device_t(dev) );
+  BOOST_FOREACH( std::string dev, shm_devs )
+    devices.push_back( device_t(dev) );
+
+  _device_cache = devices;
+  _device_cache_fake = fake;
+  _device_cache_time = now;
+  _device_cache_valid = true;
 
   return devices;
 }
@@ -0,0 +1,331 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * config.h is generated by configure. It contains the results
+ * of probing for features, options etc. It should be the first
+ * file included in your .cc file.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "fcd_direct_c.h"
+
+#include <gnuradio/io_signature.h>
+
+#include <volk/volk.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+/* HID command set shared by both dongle generations (qthid) */
+#define FCD_CMD_APP_SET_FREQ_HZ    101
+#define FCD_CMD_APP_SET_LNA_GAIN   110
+#define FCD_CMD_APP_SET_MIXER_GAIN 114
+#define FCD_CMD_APP_SET_IF_GAIN1   117
+
+#define FCD_HID_REPORT_SIZE 64
+
+#define FCD_DEFAULT_PERIOD 256 /* frames, ~2.7 ms at 96 kS/s */
+
+fcd_direct_c_sptr make_fcd_direct_c( const std::string & device,
+                                     int sample_rate,
+                                     int dongle_type,
+                                     unsigned int period )
+{
+  return gnuradio::get_initial_sptr(
+        new fcd_direct_c( device, sample_rate, dongle_type, period ) );
+}
+
+fcd_direct_c::fcd_direct_c( const std::string & device,
+                            int sample_rate,
+                            int dongle_type,
+                            unsigned int period )
+  : gr::sync_block( "fcd_direct_c",
+                    gr::io_signature::make( 0, 0, 0 ),
+                    gr::io_signature::make( 1, 1, sizeof( gr_complex ) ) ),
+    _pcm( NULL ),
+    _hid( -1 ),
+    _rate( sample_rate ),
+    _type( dongle_type ),
+    _period( period ? period : FCD_DEFAULT_PERIOD )
+{
+  int ret;
+
+  ret = snd_pcm_open( &_pcm, device.c_str(), SND_PCM_STREAM_CAPTURE, 0 );
+  if ( ret < 0 )
+    throw std::runtime_error( "Failed to open ALSA device " + device + ": " +
+                              snd_strerror( ret ) );
+
+  snd_pcm_hw_params_t *hw;
+  snd_pcm_hw_params_alloca( &hw );
+  snd_pcm_hw_params_any( _pcm, hw );
+
+  ret = snd_pcm_hw_params_set_access( _pcm, hw,
+                                      SND_PCM_ACCESS_MMAP_INTERLEAVED );
+  if ( ret < 0 )
+    throw std::runtime_error( "ALSA device " + device +
+                              " does not support mmap access." );
+
+  snd_pcm_hw_params_set_format( _pcm, hw, SND_PCM_FORMAT_S16_LE );
+  snd_pcm_hw_params_set_channels( _pcm, hw, 2 );
+
+  unsigned int rate = _rate;
+  snd_pcm_hw_params_set_rate_near( _pcm, hw, &rate, NULL );
+  if ( (int)rate != _rate )
+    throw std::runtime_error( "ALSA device " + device +
+                              " does not support the dongle's native rate." );
+
+  /* small periods are the whole point of this block, the generic audio
+   * chain runs with whatever the system wide gnuradio config says */
+  snd_pcm_hw_params_set_period_size_near( _pcm, hw, &_period, NULL );
+
+  unsigned int periods = 4;
+  snd_pcm_hw_params_set_periods_near( _pcm, hw, &periods, NULL );
+
+  ret = snd_pcm_hw_params( _pcm, hw );
+  if ( ret < 0 )
+    throw std::runtime_error( "Failed to configure ALSA device " + device +
+                              ": " + snd_strerror( ret ) );
+
+  snd_pcm_sw_params_t *sw;
+  snd_pcm_sw_params_alloca( &sw );
+  snd_pcm_sw_params_current( _pcm, sw );
+  snd_pcm_sw_params_set_avail_min( _pcm, sw, _period );
+  snd_pcm_sw_params( _pcm, sw );
+
+  std::string hidraw = find_hidraw();
+  if ( hidraw.length() )
+    _hid = open( hidraw.c_str(), O_RDWR | O_NONBLOCK );
+
+  if ( _hid < 0 )
+    std::cerr << "Control endpoint of FUNcube Dongle not accessible, "
+              << "tuning will not work." << std::endl;
+
+  std::cerr << "Using " << device << " with mmap access, period of "
+            << _period << " frames." << std::endl;
+
+  /* Set up constraints: produce in aligned full SIMD widths so the
+   * conversion kernels never have to run a scalar tail */
+  int const alignment_multiple = volk_get_alignment() / sizeof(gr_complex);
+  set_alignment(std::max(1, alignment_multiple));
+  set_output_multiple(std::max(1, alignment_multiple));
+}
+
+fcd_direct_c::~fcd_direct_c()
+{
+  if ( _hid >= 0 )
+    close( _hid );
+
+  if ( _pcm )
+    snd_pcm_close( _pcm );
+}
+
+std::string fcd_direct_c::find_hidraw( void )
+{
+  /* 04d8:fb56 is the V1.0 dongle, 04d8:fb31 the Pro+ */
+  std::string id = ( 2 == _type ) ? "04D8:0000FB31" : "04D8:0000FB56";
+
+  for ( int i = 0; i < 32; i++ )
+  {
+    std::string node = "hidraw" + boost::lexical_cast< std::string >( i );
+    std::ifstream uevent( ("/sys/class/hidraw/" + node + "/device/uevent").c_str() );
+
+    std::string line;
+    while ( std::getline( uevent, line ) )
+    {
+      if ( line.compare( 0, 7, "HID_ID=" ) == 0 &&
+           line.find( id ) != std::string::npos )
+        return "/dev/" + node;
+    }
+  }
+
+  return "";
+}
+
+bool fcd_direct_c::hid_command( unsigned char cmd,
+                                const unsigned char *data, size_t len )
+{
+  unsigned char report[ FCD_HID_REPORT_SIZE + 1 ];
+
+  if ( _hid < 0 )
+    return false;
+
+  memset( report, 0, sizeof( report ) );
+  report[0] = 0; /* report number */
+  report[1] = cmd;
+
+  if ( data && len )
+    memcpy( &report[2], data, std::min( len, sizeof( report ) - 2 ) );
+
+  if ( write( _hid, report, sizeof( report ) ) != (ssize_t)sizeof( report ) )
+    return false;
+
+  /* drain the dongle's reply, we don't evaluate it */
+  while ( read( _hid, report, sizeof( report ) ) > 0 );
+
+  return true;
+}
+
+bool fcd_direct_c::start()
+{
+  snd_pcm_prepare( _pcm );
+  snd_pcm_start( _pcm );
+
+  return true;
+}
+
+bool fcd_direct_c::stop()
+{
+  snd_pcm_drop( _pcm );
+
+  return true;
+}
+
+void fcd_direct_c::recover_xrun( void )
+{
+  std::cerr << "O" << std::flush;
+
+  snd_pcm_prepare( _pcm );
+  snd_pcm_start( _pcm );
+}
+
+int fcd_direct_c::work( int noutput_items,
+                        gr_vector_const_void_star &input_items,
+                        gr_vector_void_star &output_items )
+{
+  gr_complex *out = (gr_complex *)output_items[0];
+  int produced = 0;
+
+  if ( SND_PCM_STATE_XRUN == snd_pcm_state( _pcm ) )
+    recover_xrun();
+
+  if ( snd_pcm_wait( _pcm, 100 ) < 0 )
+  {
+    recover_xrun();
+    return 0;
+  }
+
+  snd_pcm_sframes_t avail = snd_pcm_avail_update( _pcm );
+  if ( avail < 0 )
+  {
+    recover_xrun();
+    return 0;
+  }
+
+  snd_pcm_uframes_t frames =
+      std::min( (snd_pcm_uframes_t)avail, (snd_pcm_uframes_t)noutput_items );
+
+  while ( frames )
+  {
+    const snd_pcm_channel_area_t *areas;
+    snd_pcm_uframes_t offset;
+    snd_pcm_uframes_t chunk = frames;
+
+    if ( snd_pcm_mmap_begin( _pcm, &areas, &offset, &chunk ) < 0 )
+    {
+      recover_xrun();
+      break;
+    }
+
+    /* S16_LE stereo is interleaved and contiguous, convert the I/Q pairs
+     * right out of the ALSA ring, the dispatcher handles alignment */
+    const int16_t *in = (const int16_t *)
+        ( (const char *)areas[0].addr +
+          ( areas[0].first + offset * areas[0].step ) / 8 );
+
+    volk_16i_s32f_convert_32f( (float *)out, in, 32768.f, chunk * 2 );
+
+    snd_pcm_mmap_commit( _pcm, offset, chunk );
+
+    out += chunk;
+    produced += chunk;
+    frames -= chunk;
+  }
+
+  return produced;
+}
+
+void fcd_direct_c::set_freq( double freq )
+{
+  uint32_t hz = uint32_t( freq );
+  unsigned char data[4];
+
+  data[0] = hz & 0xff;
+  data[1] = (hz >> 8) & 0xff;
+  data[2] = (hz >> 16) & 0xff;
+  data[3] = (hz >> 24) & 0xff;
+
+  hid_command( FCD_CMD_APP_SET_FREQ_HZ, data, sizeof( data ) );
+}
+
+void fcd_direct_c::set_lna_gain( double gain )
+{
+  unsigned char value;
+
+  if ( 2 == _type )
+  {
+    value = gain > 0 ? 1 : 0; /* the Pro+ LNA is on/off only */
+  }
+  else
+  {
+    /* enumerated gain settings of the V1 tuner chip */
+    const double gains[] = { -5.0, -2.5, 0, 2.5, 5, 7.5, 10,
+                             12.5, 15, 17.5, 20, 25, 30 };
+    const unsigned char codes[] = { 0, 1, 4, 5, 6, 7, 8,
+                                    9, 10, 11, 12, 13, 14 };
+    size_t i = 0;
+    while ( i + 1 < sizeof( gains ) / sizeof( gains[0] ) &&
+            gains[i + 1] <= gain )
+      i++;
+
+    value = codes[i];
+  }
+
+  hid_command( FCD_CMD_APP_SET_LNA_GAIN, &value, 1 );
+}
+
+void fcd_direct_c::set_mixer_gain( double gain )
+{
+  unsigned char value;
+
+  if ( 2 == _type )
+    value = gain > 0 ? 1 : 0;
+  else
+    value = gain > 4 ? 1 : 0; /* 0 = 4 dB, 1 = 12 dB */
+
+  hid_command( FCD_CMD_APP_SET_MIXER_GAIN, &value, 1 );
+}
+
+void fcd_direct_c::set_if_gain( double gain )
+{
+  unsigned char value = (unsigned char)gain;
+
+  hid_command( FCD_CMD_APP_SET_IF_GAIN1, &value, 1 );
+}
@@ -0,0 +1,92 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2013 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef FCD_DIRECT_C_H
+#define FCD_DIRECT_C_H
+
+#include <gnuradio/sync_block.h>
+
+#include <alsa/asoundlib.h>
+
+#include <string>
+
+class fcd_direct_c;
+
+typedef boost::shared_ptr< fcd_direct_c > fcd_direct_c_sptr;
+
+fcd_direct_c_sptr make_fcd_direct_c( const std::string & device,
+                                     int sample_rate,
+                                     int dongle_type,
+                                     unsigned int period = 0 );
+
+/*!
+ * \brief Low latency capture block for FUNcube Dongles.
+ *
+ * Opens the dongle's sound card directly with mmap access and small
+ * periods instead of going through the generic gr-audio chain and
+ * converts the S16_LE frames straight out of the ALSA ring into
+ * gr_complex. Tuning and gain commands are sent over the dongle's
+ * HID control endpoint (hidraw), so no other process may hold it.
+ *
+ * \param device ALSA device identifier, e.g. "hw:1"
+ * \param sample_rate native rate of the dongle (96k for V1, 192k for V2)
+ * \param dongle_type 1 for the V1.0 dongle, 2 for the Pro+
+ * \param period ALSA period size in frames, 0 selects the default
+ */
+class fcd_direct_c : public gr::sync_block
+{
+private:
+  friend fcd_direct_c_sptr make_fcd_direct_c( const std::string & device,
+                                              int sample_rate,
+                                              int dongle_type,
+                                              unsigned int period );
+
+  fcd_direct_c( const std::string & device,
+                int sample_rate,
+                int dongle_type,
+                unsigned int period );
+
+public:
+  ~fcd_direct_c();
+
+  bool start();
+  bool stop();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  void set_freq( double freq );
+  void set_lna_gain( double gain );
+  void set_mixer_gain( double gain );
+  void set_if_gain( double gain );
+
+private:
+  std::string find_hidraw( void );
+  bool hid_command( unsigned char cmd, const unsigned char *data, size_t len );
+  void recover_xrun( void );
+
+  snd_pcm_t *_pcm;
+  int _hid; /* hidraw fd, -1 when the control endpoint is unavailable */
+  int _rate;
+  int _type;
+  snd_pcm_uframes_t _period;
+};
+
+#endif // FCD_DIRECT_C_H
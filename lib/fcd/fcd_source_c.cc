@@ -92,7 +92,10 @@ fcd_source_c::fcd_source_c(const std::string &args) :
   gr::hier_block2("fcd_source_c",
                  gr::io_signature::make(0, 0, 0),
                  gr::io_signature::make(1, 1, sizeof (gr_complex))),
-  _type( FUNCUBE_UNKNOWN )
+  _type( FUNCUBE_UNKNOWN ),
+  _direct( false ),
+  _freq( 0 ),
+  _correct( 0 )
 {
   std::string dev_name;
   unsigned int dev_index = 0;
@@ -119,6 +122,9 @@ fcd_source_c::fcd_source_c(const std::string &args) :
     _type = FUNCUBE_V1;
   }
 
+  if (dict.count("direct"))
+    _direct = ! ( "off" == dict["direct"] || "0" == dict["direct"] );
+
   if (dict.count("type"))
   {
     _type = (dongle_type) boost::lexical_cast< int >( dict["type"] );
@@ -142,8 +148,49 @@ fcd_source_c::fcd_source_c(const std::string &args) :
 
   std::cerr << "Using " << name() << " (" << dev_name << ")" << std::endl;
 
+#ifndef HAVE_FCD_DIRECT
+  if ( _direct )
+  {
+    std::cerr << "Direct capture not compiled in, using the audio chain."
+              << std::endl;
+    _direct = false;
+  }
+#else
+  if ( _direct )
+  {
+    unsigned int period = 0;
+
+    if (dict.count("period"))
+    {
+      std::string value = dict["period"];
+      try {
+        period = boost::lexical_cast< unsigned int >( value );
+      } catch ( std::exception &ex ) {
+        throw std::runtime_error(
+              "Failed to use '" + value + "' as period: " + ex.what());
+      }
+    }
+
+    _src_direct = make_fcd_direct_c( dev_name, (int)get_sample_rate(),
+                                     FUNCUBE_V2 == _type ? 2 : 1, period );
+    connect( _src_direct, 0, self(), 0 );
+
+    if ( FUNCUBE_V1 == _type )
+    {
+      set_gain( 20, "LNA" );
+      set_gain( 12, "MIX" );
+    }
+    else
+    {
+      set_gain( 1, "LNA" );
+      set_gain( 1, "MIX" );
+      set_gain( 15, "BB" );
+    }
+  }
+#endif
+
 #ifdef HAVE_FCD
-  if ( FUNCUBE_V1 == _type )
+  if ( ! _direct && FUNCUBE_V1 == _type )
   {
     _src_v1 = gr::fcd::source_c::make( dev_name );
     connect( _src_v1, 0, self(), 0 );
@@ -154,7 +201,7 @@ fcd_source_c::fcd_source_c(const std::string &args) :
 #endif
 
 #ifdef HAVE_FCDPP
-  if ( FUNCUBE_V2 == _type )
+  if ( ! _direct && FUNCUBE_V2 == _type )
   {
     _src_v2 = gr::fcdproplus::fcdproplus::make( dev_name );
     connect( _src_v2, 0, self(), 0 );
@@ -241,6 +288,19 @@ osmosdr::freq_range_t fcd_source_c::get_freq_range( size_t chan )
 
 double fcd_source_c::set_center_freq( double freq, size_t chan )
 {
+#ifdef HAVE_FCD_DIRECT
+  if ( _direct )
+  {
+    /* the HID command takes the absolute frequency, apply the ppm
+     * correction ourselves like the gr blocks do internally */
+    _src_direct->set_freq( freq * ( 1.0 + _correct * 1e-6 ) );
+
+    _freq = freq;
+
+    return get_center_freq(chan);
+  }
+#endif
+
 #ifdef HAVE_FCD
   if ( FUNCUBE_V1 == _type )
     _src_v1->set_freq( float(freq) );
@@ -263,6 +323,18 @@ double fcd_source_c::get_center_freq( size_t chan )
 
 double fcd_source_c::set_freq_corr( double ppm, size_t chan )
 {
+#ifdef HAVE_FCD_DIRECT
+  if ( _direct )
+  {
+    _correct = ppm;
+
+    if ( _freq )
+      set_center_freq( _freq, chan );
+
+    return get_freq_corr( chan );
+  }
+#endif
+
 #ifdef HAVE_FCD
   if ( FUNCUBE_V1 == _type )
     _src_v1->set_freq_corr( ppm );
@@ -343,6 +415,30 @@ double fcd_source_c::set_gain( double gain, size_t chan )
 
 double fcd_source_c::set_gain( double gain, const std::string & name, size_t chan )
 {
+#ifdef HAVE_FCD_DIRECT
+  if ( _direct )
+  {
+    if ( "LNA" == name )
+    {
+      _lna_gain = ( FUNCUBE_V2 == _type ) ? ( gain > 0 ? 1 : 0 ) : gain;
+      _src_direct->set_lna_gain( _lna_gain );
+    }
+    else if ( "MIX" == name )
+    {
+      _mix_gain = ( FUNCUBE_V2 == _type ) ? ( gain > 0 ? 1 : 0 )
+                                          : ( gain > 4 ? 12 : 4 );
+      _src_direct->set_mixer_gain( _mix_gain );
+    }
+    else if ( "BB" == name )
+    {
+      _bb_gain = gain;
+      _src_direct->set_if_gain( _bb_gain );
+    }
+
+    return get_gain( name, chan );
+  }
+#endif
+
 #ifdef HAVE_FCD
   if ( FUNCUBE_V1 == _type )
   {
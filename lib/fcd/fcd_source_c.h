@@ -30,6 +30,10 @@
 #include <fcdproplus/fcdproplus.h>
 #endif
 
+#ifdef HAVE_FCD_DIRECT
+#include "fcd_direct_c.h"
+#endif
+
 #include "source_iface.h"
 
 class fcd_source_c;
@@ -92,6 +96,10 @@ private:
 #ifdef HAVE_FCDPP
   gr::fcdproplus::fcdproplus::sptr _src_v2;
 #endif
+#ifdef HAVE_FCD_DIRECT
+  fcd_direct_c_sptr _src_direct;
+#endif
+  bool _direct;
   double _lna_gain, _mix_gain, _bb_gain, _freq;
   int _correct;
 };
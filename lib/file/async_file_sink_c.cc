@@ -0,0 +1,221 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include <gnuradio/io_signature.h>
+
+#include "async_file_sink_c.h"
+
+/* slot size; a multiple of any sane filesystem block size, as required
+ * for O_DIRECT writes */
+#define SLOT_LEN   (1024 * 1024)
+/* O_DIRECT also constrains the memory alignment of the slots */
+#define SLOT_ALIGN 4096
+
+async_file_sink_c_sptr make_async_file_sink_c( const std::string &filename,
+                                               size_t itemsize,
+                                               bool append,
+                                               unsigned int num_buffers,
+                                               bool direct )
+{
+  return gnuradio::get_initial_sptr(
+      new async_file_sink_c(filename, itemsize, append, num_buffers,
+                            direct) );
+}
+
+async_file_sink_c::async_file_sink_c( const std::string &filename,
+                                      size_t itemsize,
+                                      bool append,
+                                      unsigned int num_buffers,
+                                      bool direct )
+  : gr::sync_block("async_file_sink_c",
+                   gr::io_signature::make(1, 1, itemsize),
+                   gr::io_signature::make(0, 0, 0)),
+    _itemsize(itemsize),
+    _fd(-1),
+    _direct(direct),
+    _ring(NULL),
+    _fill(0),
+    _running(true),
+    _overruns(0)
+{
+  int flags = O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC);
+
+#ifdef O_DIRECT
+  if (_direct)
+    flags |= O_DIRECT;
+#else
+  if (_direct) {
+    std::cerr << "WARNING: O_DIRECT is not supported on this platform."
+              << std::endl;
+    _direct = false;
+  }
+#endif
+
+  _fd = open( filename.c_str(), flags, 0644 );
+
+#ifdef O_DIRECT
+  if (_fd < 0 && _direct && EINVAL == errno) {
+    /* filesystem without O_DIRECT support (e.g. tmpfs) */
+    std::cerr << "WARNING: O_DIRECT is not supported here, "
+              << "falling back to buffered writes." << std::endl;
+    _direct = false;
+    flags &= ~O_DIRECT;
+    _fd = open( filename.c_str(), flags, 0644 );
+  }
+#endif
+
+  if (_fd < 0)
+    throw std::runtime_error("Can't open " + filename + ": " +
+                             std::string(strerror(errno)));
+
+  if (0 == num_buffers)
+    num_buffers = 64;
+
+  _ring = new ring_buffer(num_buffers, SLOT_LEN, SLOT_ALIGN);
+
+  _thread = gr::thread::thread(_writer_task, this);
+}
+
+async_file_sink_c::~async_file_sink_c()
+{
+  _running = false;
+  _ring->notify();
+  _thread.join();
+
+  /* drain the slots the writer did not get to anymore */
+  unsigned int len = 0;
+  unsigned char *buf;
+
+  while ( (buf = (unsigned char *)_ring->read_ptr(&len)) ) {
+    ssize_t written = write( _fd, buf, len );
+    if (written < 0) {
+      perror( "async_file_sink_c write" );
+      break;
+    }
+    _ring->read_done();
+  }
+
+  /* flush the partially filled slot; its length is no longer block
+   * aligned, so leave the O_DIRECT path first */
+  if (_fill) {
+#ifdef O_DIRECT
+    if (_direct)
+      fcntl( _fd, F_SETFL, fcntl( _fd, F_GETFL ) & ~O_DIRECT );
+#endif
+    unsigned char *buf = (unsigned char *)_ring->write_ptr();
+    if (buf) {
+      ssize_t written = write( _fd, buf, _fill );
+      if (written < 0)
+        perror( "async_file_sink_c write" );
+    }
+  }
+
+  if (get_num_overruns())
+    std::cerr << "async_file_sink_c dropped " << get_num_overruns()
+              << " items, the disk could not keep up" << std::endl;
+
+  close(_fd);
+
+  delete _ring;
+}
+
+void async_file_sink_c::_writer_task( async_file_sink_c *obj )
+{
+  obj->writer_task();
+}
+
+void async_file_sink_c::writer_task()
+{
+  while (_running) {
+    _ring->wait_for(1, _running);
+
+    unsigned int len = 0;
+    unsigned char *buf = (unsigned char *)_ring->read_ptr(&len);
+
+    if (!buf)
+      continue;
+
+    unsigned int nwritten = 0;
+
+    while (nwritten < len) {
+      ssize_t ret = write( _fd, buf + nwritten, len - nwritten );
+
+      if (ret < 0) {
+        if (EINTR == errno)
+          continue;
+
+        perror( "async_file_sink_c write" );
+        _running = false;
+        break;
+      }
+
+      nwritten += ret;
+    }
+
+    _ring->read_done();
+  }
+}
+
+int async_file_sink_c::work( int noutput_items,
+                             gr_vector_const_void_star &input_items,
+                             gr_vector_void_star &output_items )
+{
+  const unsigned char *in = (const unsigned char *)input_items[0];
+  unsigned int remaining = noutput_items * _itemsize;
+
+  while (remaining) {
+    unsigned char *buf = (unsigned char *)_ring->write_ptr();
+
+    if (!buf) {
+      /* never block on storage: drop the newest samples and account
+       * for them, write_ptr() has reported the overrun already */
+      _overruns.fetch_add(remaining / _itemsize,
+                          boost::memory_order_relaxed);
+      break;
+    }
+
+    unsigned int ncopy = std::min( remaining, SLOT_LEN - _fill );
+
+    memcpy( buf + _fill, in, ncopy );
+
+    _fill += ncopy;
+    in += ncopy;
+    remaining -= ncopy;
+
+    if (SLOT_LEN == _fill) {
+      _ring->write_done(SLOT_LEN);
+      _fill = 0;
+    }
+  }
+
+  return noutput_items;
+}
+
+#endif /* _WIN32 */
@@ -0,0 +1,97 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef ASYNC_FILE_SINK_C_H
+#define ASYNC_FILE_SINK_C_H
+
+#include <gnuradio/sync_block.h>
+#include <gnuradio/thread/thread.h>
+
+#include <boost/atomic.hpp>
+
+#include <string>
+
+#include "ring_buffer.h"
+
+class async_file_sink_c;
+
+typedef boost::shared_ptr< async_file_sink_c > async_file_sink_c_sptr;
+
+async_file_sink_c_sptr make_async_file_sink_c( const std::string &filename,
+                                               size_t itemsize,
+                                               bool append,
+                                               unsigned int num_buffers,
+                                               bool direct );
+
+/*!
+ * \brief Records a stream through a dedicated writer thread.
+ *
+ * work() only copies into a ring of preallocated slots and never blocks
+ * on storage; the writer thread behind it issues the large writes. When
+ * the disk cannot keep up the newest samples are dropped and counted
+ * instead of stalling the flowgraph. With direct=true the file is opened
+ * O_DIRECT and written from suitably aligned slots, bypassing the page
+ * cache. Only built on POSIX platforms.
+ */
+class async_file_sink_c : public gr::sync_block
+{
+private:
+  friend async_file_sink_c_sptr make_async_file_sink_c(
+      const std::string &filename, size_t itemsize, bool append,
+      unsigned int num_buffers, bool direct );
+
+  async_file_sink_c( const std::string &filename, size_t itemsize,
+                     bool append, unsigned int num_buffers, bool direct );
+
+public:
+  ~async_file_sink_c();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  /*! Number of items dropped because the disk could not keep up. */
+  uint64_t get_num_overruns( void )
+  {
+    return _overruns.load(boost::memory_order_relaxed);
+  }
+
+  void reset_num_overruns( void )
+  {
+    _overruns.store(0, boost::memory_order_relaxed);
+  }
+
+private:
+  static void _writer_task( async_file_sink_c *obj );
+  void writer_task();
+
+  size_t _itemsize;
+  int _fd;
+  bool _direct;
+
+  ring_buffer *_ring;
+  unsigned int _fill; /* bytes staged in the current slot */
+
+  gr::thread::thread _thread;
+  bool _running;
+
+  boost::atomic<uint64_t> _overruns;
+};
+
+#endif /* ASYNC_FILE_SINK_C_H */
@@ -26,10 +26,14 @@
 #include <boost/format.hpp>
 
 #include <gnuradio/io_signature.h>
+#include <gnuradio/blocks/complex_to_interleaved_char.h>
+#include <gnuradio/blocks/complex_to_interleaved_short.h>
+#include <gnuradio/blocks/multiply_const_cc.h>
 
 #include "file_sink_c.h"
 
 #include "arg_helpers.h"
+#include "sigmf.h"
 
 using namespace boost::assign;
 
@@ -46,6 +50,13 @@ file_sink_c::file_sink_c(const std::string &args) :
   std::string filename;
   bool append = false;
   bool throttle = false;
+  bool use_async = false;
+  bool direct = false;
+  bool use_sigmf = false;
+  bool use_zstd = false;
+  int zlevel = 1;
+  unsigned int buffers = 0;
+  std::string format = "cf32_le";
   _freq = 0;
   _rate = 0;
 
@@ -66,9 +77,58 @@ file_sink_c::file_sink_c(const std::string &args) :
   if (dict.count("append"))
     append = ("true" == dict["append"] ? true : false);
 
+  if (dict.count("async"))
+    use_async = ("true" == dict["async"] || "1" == dict["async"]);
+
+  if (dict.count("odirect"))
+    direct = ("true" == dict["odirect"] || "1" == dict["odirect"]);
+
+  if (dict.count("buffers"))
+    buffers = boost::lexical_cast< unsigned int >( dict["buffers"] );
+
+  if (direct) /* O_DIRECT only makes sense on the writer thread path */
+    use_async = true;
+
+  use_sigmf = sigmf_is_recording( filename );
+
+  if (dict.count("sigmf"))
+    use_sigmf = ("true" == dict["sigmf"] || "1" == dict["sigmf"]);
+
+  if (dict.count("format"))
+    format = dict["format"];
+
+  /* a .zst suffix selects the compressed container, zstd=true forces
+   * it for any name; zlevel tunes the speed/ratio tradeoff, the
+   * default of 1 favors keeping up with the stream */
+  if (filename.length() > 4 &&
+      filename.compare( filename.length() - 4, 4, ".zst" ) == 0)
+    use_zstd = true;
+
+  if (dict.count("zstd"))
+    use_zstd = ("true" == dict["zstd"] || "1" == dict["zstd"]);
+
+  if (dict.count("zlevel"))
+    zlevel = boost::lexical_cast< int >( dict["zlevel"] );
+
+  /* accept the UHD spellings, store the SigMF ones */
+  if ( "ci16" == format || "cs16" == format )
+    format = "ci16_le";
+  else if ( "cs8" == format )
+    format = "ci8";
+  else if ( "cf32" == format )
+    format = "cf32_le";
+
   if (!filename.length())
     throw std::runtime_error("No file name specified.");
 
+  if (use_sigmf) {
+    std::string base = sigmf_base( filename );
+
+    filename = sigmf_data_path( base );
+    _sigmf_meta_path = sigmf_meta_path( base );
+    _sigmf_datatype = format;
+  }
+
   if (_freq < 0)
     throw std::runtime_error("Parameter 'freq' may not be negative.");
 
@@ -77,22 +137,110 @@ file_sink_c::file_sink_c(const std::string &args) :
 
   _file_rate = _rate;
 
-  _sink = gr::blocks::file_sink::make( sizeof(gr_complex),
-                                           filename.c_str(),
-                                           append);
+#ifdef _WIN32
+  if (use_async) {
+    std::cerr << "WARNING: Parameter 'async' is not supported on this platform."
+              << std::endl;
+    use_async = false;
+  }
+#endif
+
+  size_t itemsize = sizeof(gr_complex);
+
+  if ( "ci16_le" == format )
+    itemsize = sizeof(short);
+  else if ( "ci8" == format )
+    itemsize = sizeof(char);
+  else if ( "cf32_le" != format )
+    throw std::runtime_error("Unsupported format " + format);
+
+  gr::basic_block_sptr sink;
+
+#if defined(HAVE_LIBZSTD) && !defined(_WIN32)
+  if (use_zstd) {
+    /* the compression thread doubles as the writer thread, so the
+     * async path would only add a second hop */
+    _zstd_sink = make_zstd_file_sink_c( filename, itemsize,
+                                        append, buffers, zlevel );
+    sink = _zstd_sink;
+    use_async = false;
+  }
+#else
+  if (use_zstd)
+    throw std::runtime_error("Compressed capture is not supported "
+                             "in this build, it requires libzstd.");
+#endif
+
+#ifndef _WIN32
+  if (use_async) {
+    /* a writer thread takes the storage stalls, work() never blocks */
+    _async_sink = make_async_file_sink_c( filename, itemsize,
+                                          append, buffers, direct );
+    sink = _async_sink;
+  }
+#endif
+
+  if (!use_async && !use_zstd) {
+    _sink = gr::blocks::file_sink::make( itemsize,
+                                         filename.c_str(),
+                                         append);
+    sink = _sink;
+  }
 
   _throttle = gr::blocks::throttle::make( sizeof(gr_complex), _file_rate );
 
+  gr::basic_block_sptr last = self();
+
   if (throttle) {
-    connect( self(), 0, _throttle, 0 );
-    connect( _throttle, 0, _sink, 0 );
-  } else {
-    connect( self(), 0, _sink, 0 );
+    connect( last, 0, _throttle, 0 );
+    last = _throttle;
+  }
+
+  /* store the native datatype, the 4x smaller integer formats often
+   * make the difference between a capture that drops and one that
+   * does not */
+  if ( sizeof(short) == itemsize ) {
+    gr::blocks::multiply_const_cc::sptr scale =
+        gr::blocks::multiply_const_cc::make( gr_complex(32767.0f, 0) );
+    gr::blocks::complex_to_interleaved_short::sptr conv =
+        gr::blocks::complex_to_interleaved_short::make();
+
+    connect( last, 0, scale, 0 );
+    connect( scale, 0, conv, 0 );
+    last = conv;
+  } else if ( sizeof(char) == itemsize ) {
+    gr::blocks::multiply_const_cc::sptr scale =
+        gr::blocks::multiply_const_cc::make( gr_complex(127.0f, 0) );
+    gr::blocks::complex_to_interleaved_char::sptr conv =
+        gr::blocks::complex_to_interleaved_char::make();
+
+    connect( last, 0, scale, 0 );
+    connect( scale, 0, conv, 0 );
+    last = conv;
   }
+
+  connect( last, 0, sink, 0 );
+
+  if (use_sigmf)
+    write_sigmf_meta();
+}
+
+void file_sink_c::write_sigmf_meta( void )
+{
+  sigmf_meta_t meta;
+
+  meta.datatype = _sigmf_datatype;
+  meta.sample_rate = _rate;
+  meta.frequency = _freq;
+
+  sigmf_write_meta( _sigmf_meta_path, meta );
 }
 
 file_sink_c::~file_sink_c()
 {
+  /* rate or frequency may have been changed after construction */
+  if ( _sigmf_meta_path.length() )
+    write_sigmf_meta();
 }
 
 std::string file_sink_c::name()
@@ -120,6 +268,34 @@ size_t file_sink_c::get_num_channels( void )
   return 1;
 }
 
+uint64_t file_sink_c::get_num_overflows( void )
+{
+#ifndef _WIN32
+  if ( _async_sink )
+    return _async_sink->get_num_overruns();
+#endif
+
+#ifdef HAVE_LIBZSTD
+  if ( _zstd_sink )
+    return _zstd_sink->get_num_overruns();
+#endif
+
+  return 0;
+}
+
+void file_sink_c::reset_stream_stats( void )
+{
+#ifndef _WIN32
+  if ( _async_sink )
+    _async_sink->reset_num_overruns();
+#endif
+
+#ifdef HAVE_LIBZSTD
+  if ( _zstd_sink )
+    _zstd_sink->reset_num_overruns();
+#endif
+}
+
 osmosdr::meta_range_t file_sink_c::get_sample_rates( void )
 {
   osmosdr::meta_range_t range;
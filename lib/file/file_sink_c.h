@@ -25,6 +25,11 @@
 #include <gnuradio/blocks/throttle.h>
 
 #include "sink_iface.h"
+#include "async_file_sink_c.h"
+
+#ifdef HAVE_LIBZSTD
+#include "zstd_file_sink_c.h"
+#endif
 
 class file_sink_c;
 
@@ -50,6 +55,9 @@ public:
 
   size_t get_num_channels( void );
 
+  uint64_t get_num_overflows( void );
+  void reset_stream_stats( void );
+
   osmosdr::meta_range_t get_sample_rates( void );
   double set_sample_rate( double rate );
   double get_sample_rate( void );
@@ -73,8 +81,16 @@ public:
   std::string get_antenna( size_t chan = 0 );
 
 private:
+  void write_sigmf_meta( void );
+
   gr::blocks::file_sink::sptr _sink;
+  async_file_sink_c_sptr _async_sink;
+#ifdef HAVE_LIBZSTD
+  zstd_file_sink_c_sptr _zstd_sink;
+#endif
   gr::blocks::throttle::sptr _throttle;
+  std::string _sigmf_meta_path; /* empty unless in SigMF mode */
+  std::string _sigmf_datatype;
   double _file_rate;
   double _freq, _rate;
 };
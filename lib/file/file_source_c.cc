@@ -26,10 +26,14 @@
 #include <boost/format.hpp>
 
 #include <gnuradio/io_signature.h>
+#include <gnuradio/blocks/interleaved_char_to_complex.h>
+#include <gnuradio/blocks/interleaved_short_to_complex.h>
+#include <gnuradio/blocks/multiply_const_cc.h>
 
 #include "file_source_c.h"
 
 #include "arg_helpers.h"
+#include "sigmf.h"
 
 using namespace boost::assign;
 
@@ -46,6 +50,11 @@ file_source_c::file_source_c(const std::string &args) :
   std::string filename;
   bool repeat = true;
   bool throttle = true;
+  bool use_mmap = false;
+  bool use_sigmf = false;
+  bool use_zstd = false;
+  std::string datatype = "cf32_le";
+  _items_per_sample = 1;
   _freq = 0;
   _rate = 0;
 
@@ -66,9 +75,44 @@ file_source_c::file_source_c(const std::string &args) :
   if (dict.count("throttle"))
     throttle = ("true" == dict["throttle"] ? true : false);
 
+  if (dict.count("mmap"))
+    use_mmap = ("true" == dict["mmap"] || "1" == dict["mmap"]);
+
+  /* a .zst suffix selects the compressed container, zstd=true forces
+   * it for any name */
+  if (filename.length() > 4 &&
+      filename.compare( filename.length() - 4, 4, ".zst" ) == 0)
+    use_zstd = true;
+
+  if (dict.count("zstd"))
+    use_zstd = ("true" == dict["zstd"] || "1" == dict["zstd"]);
+
+  use_sigmf = sigmf_is_recording( filename );
+
+  if (dict.count("sigmf"))
+    use_sigmf = ("true" == dict["sigmf"] || "1" == dict["sigmf"]);
+
   if (!filename.length())
     throw std::runtime_error("No file name specified.");
 
+  if (use_sigmf) {
+    std::string base = sigmf_base( filename );
+    sigmf_meta_t meta;
+
+    if ( !sigmf_read_meta( sigmf_meta_path( base ), meta ) )
+      throw std::runtime_error("Can't read " + sigmf_meta_path( base ));
+
+    filename = sigmf_data_path( base );
+    datatype = meta.datatype;
+
+    /* the recording knows its own tuning, explicit args only override */
+    if (0 == _rate)
+      _rate = meta.sample_rate;
+
+    if (0 == _freq)
+      _freq = meta.frequency;
+  }
+
   if (_freq < 0)
     throw std::runtime_error("Parameter 'freq' may not be negative.");
 
@@ -77,17 +121,87 @@ file_source_c::file_source_c(const std::string &args) :
 
   _file_rate = _rate;
 
-  _source = gr::blocks::file_source::make( sizeof(gr_complex),
-                                           filename.c_str(),
-                                           repeat );
+#ifdef _WIN32
+  if (use_mmap) {
+    std::cerr << "WARNING: Parameter 'mmap' is not supported on this platform."
+              << std::endl;
+    use_mmap = false;
+  }
+#endif
+
+  size_t itemsize = sizeof(gr_complex);
+
+  if ( "ci16_le" == datatype || "ci16" == datatype || "cs16" == datatype ) {
+    itemsize = sizeof(short);
+    _items_per_sample = 2;
+  } else if ( "ci8" == datatype || "cs8" == datatype ) {
+    itemsize = sizeof(char);
+    _items_per_sample = 2;
+  } else if ( "cf32_le" != datatype && "cf32" != datatype ) {
+    throw std::runtime_error("Unsupported SigMF datatype " + datatype);
+  }
+
+  gr::basic_block_sptr source;
+
+#if defined(HAVE_LIBZSTD) && !defined(_WIN32)
+  if (use_zstd) {
+    /* frames decompress independently, so replay pulls a third of the
+     * bytes and seeks still land on the right sample */
+    _zstd_source = make_zstd_file_source_c( filename, itemsize, repeat );
+    source = _zstd_source;
+    use_mmap = false;
+  }
+#else
+  if (use_zstd)
+    throw std::runtime_error("Compressed replay is not supported "
+                             "in this build, it requires libzstd.");
+#endif
+
+#ifndef _WIN32
+  if (use_mmap) {
+    /* map the capture instead of read()ing it through stdio, keeping
+     * large replays bounded by the disk rather than buffer copies */
+    _mmap_source = make_mmap_source_c( filename, itemsize, repeat );
+    source = _mmap_source;
+  }
+#endif
+
+  if (!use_mmap && !use_zstd) {
+    _source = gr::blocks::file_source::make( itemsize,
+                                             filename.c_str(),
+                                             repeat );
+    source = _source;
+  }
+
+  /* integer captures are expanded to float on the fly, the disk only
+   * ever sees the native datatype */
+  if ( sizeof(short) == itemsize ) {
+    gr::blocks::interleaved_short_to_complex::sptr conv =
+        gr::blocks::interleaved_short_to_complex::make();
+    gr::blocks::multiply_const_cc::sptr scale =
+        gr::blocks::multiply_const_cc::make( gr_complex(1.0f/32768.0f, 0) );
+
+    connect( source, 0, conv, 0 );
+    connect( conv, 0, scale, 0 );
+    source = scale;
+  } else if ( sizeof(char) == itemsize ) {
+    gr::blocks::interleaved_char_to_complex::sptr conv =
+        gr::blocks::interleaved_char_to_complex::make();
+    gr::blocks::multiply_const_cc::sptr scale =
+        gr::blocks::multiply_const_cc::make( gr_complex(1.0f/128.0f, 0) );
+
+    connect( source, 0, conv, 0 );
+    connect( conv, 0, scale, 0 );
+    source = scale;
+  }
 
   _throttle = gr::blocks::throttle::make( sizeof(gr_complex), _file_rate );
 
   if (throttle) {
-    connect( _source, 0, _throttle, 0 );
+    connect( source, 0, _throttle, 0 );
     connect( _throttle, 0, self(), 0 );
   } else {
-    connect( _source, 0, self(), 0 );
+    connect( source, 0, self(), 0 );
   }
 }
 
@@ -122,9 +236,32 @@ size_t file_source_c::get_num_channels( void )
 
 bool file_source_c::seek( long seek_point, int whence , size_t chan )
 {
+    /* seek in complex samples, whatever the file item is */
+    seek_point *= _items_per_sample;
+
+#ifdef HAVE_LIBZSTD
+    if ( _zstd_source )
+      return _zstd_source->seek( seek_point, whence );
+#endif
+
+    if ( _mmap_source )
+      return _mmap_source->seek( seek_point, whence );
+
     return _source->seek( seek_point, whence );
 }
 
+bool file_source_c::seek_time( double seconds, size_t chan )
+{
+    if ( seconds < 0 || 0 == _file_rate )
+      return false;
+
+    /* our captures are raw fixed rate streams (plain IQ or a SigMF
+     * data file), so a time offset maps to a sample offset by exact
+     * arithmetic against the file's original rate, no scanning or
+     * sidecar index required even for very long recordings */
+    return seek( (long)(seconds * _file_rate + 0.5), SEEK_SET, chan );
+}
+
 osmosdr::meta_range_t file_source_c::get_sample_rates( void )
 {
   osmosdr::meta_range_t range;
@@ -25,6 +25,11 @@
 #include <gnuradio/blocks/throttle.h>
 
 #include "source_iface.h"
+#include "mmap_source_c.h"
+
+#ifdef HAVE_LIBZSTD
+#include "zstd_file_source_c.h"
+#endif
 
 class file_source_c;
 
@@ -51,6 +56,7 @@ public:
   size_t get_num_channels( void );
 
   bool seek( long seek_point, int whence, size_t chan );
+  bool seek_time( double seconds, size_t chan );
 
   osmosdr::meta_range_t get_sample_rates( void );
   double set_sample_rate( double rate );
@@ -76,7 +82,12 @@ public:
 
 private:
   gr::blocks::file_source::sptr _source;
+  mmap_source_c_sptr _mmap_source;
+#ifdef HAVE_LIBZSTD
+  zstd_file_source_c_sptr _zstd_source;
+#endif
   gr::blocks::throttle::sptr _throttle;
+  unsigned int _items_per_sample; /* file items per complex sample */
   double _file_rate;
   double _freq, _rate;
 };
@@ -0,0 +1,150 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <gnuradio/io_signature.h>
+
+#include "mmap_source_c.h"
+
+mmap_source_c_sptr make_mmap_source_c( const std::string &filename,
+                                       size_t itemsize,
+                                       bool repeat )
+{
+  return gnuradio::get_initial_sptr(
+      new mmap_source_c(filename, itemsize, repeat) );
+}
+
+mmap_source_c::mmap_source_c( const std::string &filename,
+                              size_t itemsize,
+                              bool repeat )
+  : gr::sync_block("mmap_source_c",
+                   gr::io_signature::make(0, 0, 0),
+                   gr::io_signature::make(1, 1, itemsize)),
+    _itemsize(itemsize),
+    _repeat(repeat),
+    _map(NULL),
+    _map_len(0),
+    _num_items(0),
+    _offset(0)
+{
+  int fd = open( filename.c_str(), O_RDONLY );
+  if ( fd < 0 )
+    throw std::runtime_error("Can't open " + filename + ": " +
+                             std::string(strerror(errno)));
+
+  struct stat st;
+  if ( fstat( fd, &st ) < 0 )
+  {
+    close( fd );
+    throw std::runtime_error("Can't stat " + filename + ": " +
+                             std::string(strerror(errno)));
+  }
+
+  _map_len = st.st_size;
+  _num_items = _map_len / _itemsize;
+
+  if ( 0 == _num_items )
+  {
+    close( fd );
+    throw std::runtime_error("File " + filename +
+                             " does not hold a single item.");
+  }
+
+  _map = (unsigned char *) mmap( NULL, _map_len, PROT_READ, MAP_PRIVATE,
+                                 fd, 0 );
+
+  /* the mapping holds its own reference to the file */
+  close( fd );
+
+  if ( MAP_FAILED == _map )
+  {
+    _map = NULL;
+    throw std::runtime_error("Can't mmap " + filename + ": " +
+                             std::string(strerror(errno)));
+  }
+
+  madvise( _map, _map_len, MADV_SEQUENTIAL );
+}
+
+mmap_source_c::~mmap_source_c()
+{
+  if ( _map )
+    munmap( _map, _map_len );
+}
+
+bool mmap_source_c::seek( long seek_point, int whence )
+{
+  long pos = seek_point;
+
+  if ( SEEK_CUR == whence )
+    pos += _offset;
+  else if ( SEEK_END == whence )
+    pos += _num_items;
+
+  if ( pos < 0 || (size_t)pos > _num_items )
+    return false;
+
+  _offset = pos;
+
+  return true;
+}
+
+int mmap_source_c::work( int noutput_items,
+                         gr_vector_const_void_star &input_items,
+                         gr_vector_void_star &output_items )
+{
+  char *out = (char *)output_items[0];
+  int produced = 0;
+
+  while ( produced < noutput_items )
+  {
+    if ( _offset >= _num_items )
+    {
+      if ( ! _repeat )
+        break;
+
+      _offset = 0;
+    }
+
+    size_t nout = std::min( (size_t)(noutput_items - produced),
+                            _num_items - _offset );
+
+    memcpy( out + produced * _itemsize,
+            _map + _offset * _itemsize,
+            nout * _itemsize );
+
+    _offset += nout;
+    produced += nout;
+  }
+
+  return produced ? produced : WORK_DONE;
+}
+
+#endif /* _WIN32 */
@@ -0,0 +1,72 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef MMAP_SOURCE_C_H
+#define MMAP_SOURCE_C_H
+
+#include <gnuradio/sync_block.h>
+
+#include <string>
+
+class mmap_source_c;
+
+typedef boost::shared_ptr< mmap_source_c > mmap_source_c_sptr;
+
+mmap_source_c_sptr make_mmap_source_c( const std::string &filename,
+                                       size_t itemsize,
+                                       bool repeat );
+
+/*!
+ * \brief Replays a capture through a memory mapping of the whole file.
+ *
+ * Unlike gr::blocks::file_source there is no read() path and no stdio
+ * buffer in between: the kernel pages the capture straight into the page
+ * cache and work() copies from there into the output buffer, with
+ * madvise(MADV_SEQUENTIAL) hinting the readahead. Only built on POSIX
+ * platforms.
+ */
+class mmap_source_c : public gr::sync_block
+{
+private:
+  friend mmap_source_c_sptr make_mmap_source_c( const std::string &filename,
+                                                size_t itemsize,
+                                                bool repeat );
+
+  mmap_source_c( const std::string &filename, size_t itemsize, bool repeat );
+
+public:
+  ~mmap_source_c();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  bool seek( long seek_point, int whence );
+
+private:
+  size_t _itemsize;
+  bool _repeat;
+
+  unsigned char *_map;
+  size_t _map_len;   /* mapping length in bytes */
+  size_t _num_items; /* number of whole items in the file */
+  size_t _offset;    /* read position in items */
+};
+
+#endif /* MMAP_SOURCE_C_H */
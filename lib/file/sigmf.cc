@@ -0,0 +1,139 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/format.hpp>
+
+#include "sigmf.h"
+
+static const char *sigmf_exts[] = { ".sigmf-meta", ".sigmf-data", ".sigmf" };
+
+bool sigmf_is_recording( const std::string &filename )
+{
+  for ( size_t i = 0; i < sizeof(sigmf_exts) / sizeof(sigmf_exts[0]); i++ )
+    if ( boost::algorithm::ends_with( filename, sigmf_exts[i] ) )
+      return true;
+
+  return false;
+}
+
+std::string sigmf_base( const std::string &filename )
+{
+  for ( size_t i = 0; i < sizeof(sigmf_exts) / sizeof(sigmf_exts[0]); i++ )
+    if ( boost::algorithm::ends_with( filename, sigmf_exts[i] ) )
+      return filename.substr( 0, filename.length() -
+                                 strlen( sigmf_exts[i] ) );
+
+  return filename;
+}
+
+std::string sigmf_data_path( const std::string &base )
+{
+  return base + ".sigmf-data";
+}
+
+std::string sigmf_meta_path( const std::string &base )
+{
+  return base + ".sigmf-meta";
+}
+
+/* Find "key" in text and return what follows the colon, stripped of
+ * whitespace and quotes. This is not a JSON parser, but it copes with
+ * every .sigmf-meta file the known recorders emit and saves us a
+ * library dependency for three fields. */
+static bool lookup_value( const std::string &text, const std::string &key,
+                          std::string &value )
+{
+  size_t pos = text.find( "\"" + key + "\"" );
+
+  if ( std::string::npos == pos )
+    return false;
+
+  pos = text.find( ":", pos );
+
+  if ( std::string::npos == pos )
+    return false;
+
+  size_t end = text.find_first_of( ",}\n", ++pos );
+
+  if ( std::string::npos == end )
+    return false;
+
+  value = text.substr( pos, end - pos );
+  boost::algorithm::trim( value );
+  boost::algorithm::trim_if( value, boost::algorithm::is_any_of( "\"" ) );
+
+  return value.length() > 0;
+}
+
+bool sigmf_read_meta( const std::string &path, sigmf_meta_t &meta )
+{
+  std::ifstream file( path.c_str() );
+
+  if ( !file.is_open() )
+    return false;
+
+  std::stringstream text;
+  text << file.rdbuf();
+
+  std::string value;
+
+  if ( !lookup_value( text.str(), "core:datatype", meta.datatype ) )
+    return false;
+
+  if ( lookup_value( text.str(), "core:sample_rate", value ) )
+    meta.sample_rate = atof( value.c_str() );
+
+  if ( lookup_value( text.str(), "core:frequency", value ) )
+    meta.frequency = atof( value.c_str() );
+
+  return true;
+}
+
+void sigmf_write_meta( const std::string &path, const sigmf_meta_t &meta )
+{
+  std::ofstream file( path.c_str(), std::ios::trunc );
+
+  if ( !file.is_open() )
+    return;
+
+  file << "{\n"
+       << "    \"global\": {\n"
+       << "        \"core:datatype\": \"" << meta.datatype << "\",\n"
+       << boost::format("        \"core:sample_rate\": %.0f,\n")
+          % meta.sample_rate
+       << "        \"core:version\": \"0.0.2\",\n"
+       << "        \"core:recorder\": \"gr-osmosdr\"\n"
+       << "    },\n"
+       << "    \"captures\": [\n"
+       << "        {\n"
+       << "            \"core:sample_start\": 0,\n"
+       << boost::format("            \"core:frequency\": %.0f\n")
+          % meta.frequency
+       << "        }\n"
+       << "    ],\n"
+       << "    \"annotations\": []\n"
+       << "}\n";
+}
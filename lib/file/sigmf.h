@@ -0,0 +1,56 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef SIGMF_H
+#define SIGMF_H
+
+#include <string>
+
+/*!
+ * The subset of a SigMF recording we care about: the on-disk sample
+ * format and the tuning the capture was made with.
+ */
+struct sigmf_meta_t
+{
+  sigmf_meta_t() : sample_rate(0), frequency(0) {}
+
+  std::string datatype; /* "cf32_le", "ci16_le" or "ci8" */
+  double sample_rate;
+  double frequency;
+};
+
+/*! True if filename carries one of the SigMF extensions. */
+bool sigmf_is_recording( const std::string &filename );
+
+/*! Strips a .sigmf/.sigmf-data/.sigmf-meta extension if present. */
+std::string sigmf_base( const std::string &filename );
+
+std::string sigmf_data_path( const std::string &base );
+std::string sigmf_meta_path( const std::string &base );
+
+/*!
+ * Reads the fields above from a .sigmf-meta file. Returns false if the
+ * file can not be opened or contains no datatype.
+ */
+bool sigmf_read_meta( const std::string &path, sigmf_meta_t &meta );
+
+/*! Writes a minimal .sigmf-meta file describing a single capture. */
+void sigmf_write_meta( const std::string &path, const sigmf_meta_t &meta );
+
+#endif /* SIGMF_H */
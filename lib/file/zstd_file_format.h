@@ -0,0 +1,52 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef ZSTD_FILE_FORMAT_H
+#define ZSTD_FILE_FORMAT_H
+
+#include <stdint.h>
+
+/* layout of a compressed capture:
+ *
+ *   8 bytes magic "OSMZSTD1"
+ *   uint32 LE  raw frame length in bytes
+ *   frames, each:
+ *     uint32 LE  compressed payload length
+ *     uint32 LE  raw length (equals the header value except for the
+ *                last, possibly short, frame)
+ *     payload    independent zstd block
+ *
+ * every frame decompresses on its own, and since all but the last hold
+ * the same number of raw bytes a sample offset maps to a frame index by
+ * plain division - that is what keeps the container seekable */
+
+#define ZSTD_FILE_MAGIC     "OSMZSTD1"
+#define ZSTD_FILE_MAGIC_LEN 8
+
+/* raw bytes per frame; small enough to keep seeks and the decompression
+ * working set cheap, large enough for a good ratio */
+#define ZSTD_FILE_FRAME_LEN (256 * 1024)
+
+typedef struct
+{
+  uint32_t zlen;   /* compressed payload length */
+  uint32_t rawlen; /* decompressed length */
+} zstd_frame_header_t;
+
+#endif /* ZSTD_FILE_FORMAT_H */
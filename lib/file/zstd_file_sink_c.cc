@@ -0,0 +1,258 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include <zstd.h>
+
+#include <gnuradio/io_signature.h>
+
+#include "zstd_file_sink_c.h"
+#include "zstd_file_format.h"
+
+zstd_file_sink_c_sptr make_zstd_file_sink_c( const std::string &filename,
+                                             size_t itemsize,
+                                             bool append,
+                                             unsigned int num_buffers,
+                                             int level )
+{
+  return gnuradio::get_initial_sptr(
+      new zstd_file_sink_c(filename, itemsize, append, num_buffers,
+                           level) );
+}
+
+zstd_file_sink_c::zstd_file_sink_c( const std::string &filename,
+                                    size_t itemsize,
+                                    bool append,
+                                    unsigned int num_buffers,
+                                    int level )
+  : gr::sync_block("zstd_file_sink_c",
+                   gr::io_signature::make(1, 1, itemsize),
+                   gr::io_signature::make(0, 0, 0)),
+    _itemsize(itemsize),
+    _fd(-1),
+    _level(level),
+    _ring(NULL),
+    _fill(0),
+    _zbuf(NULL),
+    _zbuf_len(0),
+    _running(true),
+    _overruns(0)
+{
+  int flags = O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC);
+
+  _fd = open( filename.c_str(), flags, 0644 );
+
+  if (_fd < 0)
+    throw std::runtime_error("Can't open " + filename + ": " +
+                             std::string(strerror(errno)));
+
+  bool write_header = true;
+
+  if (append) {
+    /* appending to an existing container continues its frame stream;
+     * verify we actually extend one with our parameters */
+    char magic[ZSTD_FILE_MAGIC_LEN];
+    uint32_t frame_len;
+    int fd = open( filename.c_str(), O_RDONLY );
+
+    if (fd >= 0) {
+      if (read( fd, magic, sizeof(magic) ) == (ssize_t)sizeof(magic)) {
+        if (memcmp( magic, ZSTD_FILE_MAGIC, sizeof(magic) ) ||
+            read( fd, &frame_len, sizeof(frame_len) ) !=
+                (ssize_t)sizeof(frame_len) ||
+            ZSTD_FILE_FRAME_LEN != frame_len) {
+          close( fd );
+          close( _fd );
+          throw std::runtime_error(filename +
+                                   " is not an appendable capture");
+        }
+        write_header = false;
+      }
+      close( fd );
+    }
+  }
+
+  if (write_header) {
+    uint32_t frame_len = ZSTD_FILE_FRAME_LEN;
+
+    if (write( _fd, ZSTD_FILE_MAGIC, ZSTD_FILE_MAGIC_LEN ) < 0 ||
+        write( _fd, &frame_len, sizeof(frame_len) ) < 0) {
+      close( _fd );
+      throw std::runtime_error("Can't write header of " + filename + ": " +
+                               std::string(strerror(errno)));
+    }
+  }
+
+  if (0 == num_buffers)
+    num_buffers = 64;
+
+  _ring = new ring_buffer(num_buffers, ZSTD_FILE_FRAME_LEN);
+
+  /* one frame bound plus room for the frame header in front, so header
+   * and payload go out in a single write */
+  _zbuf_len = ZSTD_compressBound(ZSTD_FILE_FRAME_LEN);
+  _zbuf = new unsigned char[sizeof(zstd_frame_header_t) + _zbuf_len];
+
+  _thread = gr::thread::thread(_writer_task, this);
+}
+
+zstd_file_sink_c::~zstd_file_sink_c()
+{
+  _running = false;
+  _ring->notify();
+  _thread.join();
+
+  /* compress and flush the slots the writer did not get to anymore */
+  unsigned int len = 0;
+  unsigned char *buf;
+
+  while ( (buf = (unsigned char *)_ring->read_ptr(&len)) ) {
+    write_frame( buf, len );
+    _ring->read_done();
+  }
+
+  /* the partially filled slot becomes the final short frame */
+  if (_fill) {
+    unsigned char *buf = (unsigned char *)_ring->write_ptr();
+    if (buf)
+      write_frame( buf, _fill );
+  }
+
+  if (get_num_overruns())
+    std::cerr << "zstd_file_sink_c dropped " << get_num_overruns()
+              << " items, compression or the disk could not keep up"
+              << std::endl;
+
+  close(_fd);
+
+  delete [] _zbuf;
+  delete _ring;
+}
+
+void zstd_file_sink_c::write_frame( const unsigned char *buf,
+                                    unsigned int len )
+{
+  zstd_frame_header_t header;
+
+  size_t zlen = ZSTD_compress( _zbuf + sizeof(header), _zbuf_len,
+                               buf, len, _level );
+
+  if (ZSTD_isError( zlen )) {
+    std::cerr << "zstd_file_sink_c: " << ZSTD_getErrorName( zlen )
+              << std::endl;
+    _running = false;
+    return;
+  }
+
+  header.zlen = zlen;
+  header.rawlen = len;
+
+  /* header and payload leave in one write so a crash cannot leave a
+   * header without its frame behind */
+  memcpy( _zbuf, &header, sizeof(header) );
+
+  unsigned int total = sizeof(header) + zlen;
+  unsigned int nwritten = 0;
+
+  while (nwritten < total) {
+    ssize_t ret = write( _fd, _zbuf + nwritten, total - nwritten );
+
+    if (ret < 0) {
+      if (EINTR == errno)
+        continue;
+
+      perror( "zstd_file_sink_c write" );
+      _running = false;
+      break;
+    }
+
+    nwritten += ret;
+  }
+}
+
+void zstd_file_sink_c::_writer_task( zstd_file_sink_c *obj )
+{
+  obj->writer_task();
+}
+
+void zstd_file_sink_c::writer_task()
+{
+  while (_running) {
+    _ring->wait_for(1, _running);
+
+    unsigned int len = 0;
+    unsigned char *buf = (unsigned char *)_ring->read_ptr(&len);
+
+    if (!buf)
+      continue;
+
+    write_frame( buf, len );
+
+    _ring->read_done();
+  }
+}
+
+int zstd_file_sink_c::work( int noutput_items,
+                            gr_vector_const_void_star &input_items,
+                            gr_vector_void_star &output_items )
+{
+  const unsigned char *in = (const unsigned char *)input_items[0];
+  unsigned int remaining = noutput_items * _itemsize;
+
+  while (remaining) {
+    unsigned char *buf = (unsigned char *)_ring->write_ptr();
+
+    if (!buf) {
+      /* never block on the codec or storage: drop the newest samples
+       * and account for them, write_ptr() has reported the overrun
+       * already */
+      _overruns.fetch_add(remaining / _itemsize,
+                          boost::memory_order_relaxed);
+      break;
+    }
+
+    unsigned int ncopy = std::min( remaining,
+                                   (unsigned int)ZSTD_FILE_FRAME_LEN - _fill );
+
+    memcpy( buf + _fill, in, ncopy );
+
+    _fill += ncopy;
+    in += ncopy;
+    remaining -= ncopy;
+
+    if (ZSTD_FILE_FRAME_LEN == _fill) {
+      _ring->write_done(ZSTD_FILE_FRAME_LEN);
+      _fill = 0;
+    }
+  }
+
+  return noutput_items;
+}
+
+#endif /* _WIN32 */
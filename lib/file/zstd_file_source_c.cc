@@ -0,0 +1,214 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include <zstd.h>
+
+#include <gnuradio/io_signature.h>
+
+#include "zstd_file_source_c.h"
+#include "zstd_file_format.h"
+
+zstd_file_source_c_sptr make_zstd_file_source_c( const std::string &filename,
+                                                 size_t itemsize,
+                                                 bool repeat )
+{
+  return gnuradio::get_initial_sptr(
+      new zstd_file_source_c(filename, itemsize, repeat) );
+}
+
+zstd_file_source_c::zstd_file_source_c( const std::string &filename,
+                                        size_t itemsize,
+                                        bool repeat )
+  : gr::sync_block("zstd_file_source_c",
+                   gr::io_signature::make(0, 0, 0),
+                   gr::io_signature::make(1, 1, itemsize)),
+    _itemsize(itemsize),
+    _repeat(repeat),
+    _fd(-1),
+    _frame_len(0),
+    _total_raw(0),
+    _zbuf(NULL),
+    _zbuf_len(0),
+    _rbuf(NULL),
+    _cur_frame(0),
+    _offset(0)
+{
+  _fd = open( filename.c_str(), O_RDONLY );
+  if (_fd < 0)
+    throw std::runtime_error("Can't open " + filename + ": " +
+                             std::string(strerror(errno)));
+
+  char magic[ZSTD_FILE_MAGIC_LEN];
+
+  if (read( _fd, magic, sizeof(magic) ) != (ssize_t)sizeof(magic) ||
+      memcmp( magic, ZSTD_FILE_MAGIC, sizeof(magic) ) ||
+      read( _fd, &_frame_len, sizeof(_frame_len) ) !=
+          (ssize_t)sizeof(_frame_len) ||
+      0 == _frame_len) {
+    close( _fd );
+    throw std::runtime_error(filename + " is not a compressed capture");
+  }
+
+  /* scan the frame headers once; this touches a few bytes per 256K of
+   * raw data, so even multi-hour captures index in a moment */
+  zstd_frame_header_t header;
+  uint64_t pos = ZSTD_FILE_MAGIC_LEN + sizeof(_frame_len);
+  size_t max_zlen = 0;
+
+  while (read( _fd, &header, sizeof(header) ) == (ssize_t)sizeof(header)) {
+    if (0 == header.rawlen || header.rawlen > _frame_len)
+      break; /* do not trust a corrupt header */
+
+    _frame_offsets.push_back( pos );
+    _frame_rawlens.push_back( header.rawlen );
+    _frame_starts.push_back( _total_raw );
+    _total_raw += header.rawlen;
+    max_zlen = std::max( max_zlen, (size_t)header.zlen );
+
+    pos += sizeof(header) + header.zlen;
+    if (lseek( _fd, pos, SEEK_SET ) < 0)
+      break;
+  }
+
+  if (_frame_offsets.empty()) {
+    close( _fd );
+    throw std::runtime_error(filename + " does not hold a single frame.");
+  }
+
+  /* ignore a trailing partial item in the last frame */
+  _total_raw -= _total_raw % _itemsize;
+
+  _zbuf_len = max_zlen;
+  _zbuf = new unsigned char[_zbuf_len];
+  _rbuf = new unsigned char[_frame_len];
+  _cur_frame = _frame_offsets.size(); /* nothing decompressed yet */
+}
+
+zstd_file_source_c::~zstd_file_source_c()
+{
+  if (_fd >= 0)
+    close( _fd );
+
+  delete [] _zbuf;
+  delete [] _rbuf;
+}
+
+bool zstd_file_source_c::load_frame( size_t frame )
+{
+  if (frame == _cur_frame)
+    return true;
+
+  zstd_frame_header_t header;
+
+  if (lseek( _fd, _frame_offsets[frame], SEEK_SET ) < 0 ||
+      read( _fd, &header, sizeof(header) ) != (ssize_t)sizeof(header) ||
+      header.zlen > _zbuf_len ||
+      read( _fd, _zbuf, header.zlen ) != (ssize_t)header.zlen) {
+    std::cerr << "zstd_file_source_c: truncated frame "
+              << frame << std::endl;
+    return false;
+  }
+
+  size_t rawlen = ZSTD_decompress( _rbuf, _frame_len, _zbuf, header.zlen );
+
+  if (ZSTD_isError( rawlen ) || rawlen != header.rawlen) {
+    std::cerr << "zstd_file_source_c: corrupt frame " << frame;
+    if (ZSTD_isError( rawlen ))
+      std::cerr << ": " << ZSTD_getErrorName( rawlen );
+    std::cerr << std::endl;
+    return false;
+  }
+
+  _cur_frame = frame;
+
+  return true;
+}
+
+bool zstd_file_source_c::seek( long seek_point, int whence )
+{
+  uint64_t num_items = _total_raw / _itemsize;
+  long pos = seek_point;
+
+  if ( SEEK_CUR == whence )
+    pos += _offset / _itemsize;
+  else if ( SEEK_END == whence )
+    pos += num_items;
+
+  if ( pos < 0 || (uint64_t)pos > num_items )
+    return false;
+
+  _offset = (uint64_t)pos * _itemsize;
+
+  return true;
+}
+
+int zstd_file_source_c::work( int noutput_items,
+                              gr_vector_const_void_star &input_items,
+                              gr_vector_void_star &output_items )
+{
+  char *out = (char *)output_items[0];
+  uint64_t remaining = (uint64_t)noutput_items * _itemsize;
+  uint64_t produced = 0;
+
+  while (remaining) {
+    if (_offset >= _total_raw) {
+      if ( ! _repeat )
+        break;
+
+      _offset = 0;
+    }
+
+    /* a capture extended with append= holds a short frame mid file, so
+     * the position maps to a frame through the cumulative raw offsets */
+    size_t frame = std::upper_bound( _frame_starts.begin(),
+                                     _frame_starts.end(), _offset ) -
+                   _frame_starts.begin() - 1;
+    uint64_t frame_start = _frame_starts[frame];
+
+    if ( ! load_frame( frame ) )
+      break;
+
+    /* _offset < _frame_starts[frame] + rawlen by construction of the
+     * index, so the copy always makes progress and stays in _rbuf */
+    uint64_t frame_pos = _offset - frame_start;
+    uint64_t ncopy = std::min( remaining,
+                               (uint64_t)_frame_rawlens[frame] - frame_pos );
+
+    memcpy( out + produced, _rbuf + frame_pos, ncopy );
+
+    _offset += ncopy;
+    produced += ncopy;
+    remaining -= ncopy;
+  }
+
+  return produced ? produced / _itemsize : WORK_DONE;
+}
+
+#endif /* _WIN32 */
@@ -0,0 +1,88 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef ZSTD_FILE_SOURCE_C_H
+#define ZSTD_FILE_SOURCE_C_H
+
+#include <gnuradio/sync_block.h>
+
+#include <string>
+#include <vector>
+
+class zstd_file_source_c;
+
+typedef boost::shared_ptr< zstd_file_source_c > zstd_file_source_c_sptr;
+
+zstd_file_source_c_sptr make_zstd_file_source_c( const std::string &filename,
+                                                 size_t itemsize,
+                                                 bool repeat );
+
+/*!
+ * \brief Replays a framed zstd capture written by zstd_file_sink_c.
+ *
+ * The frame headers are scanned once at open into an offset index, so
+ * seeks jump straight to the right frame and only that frame gets
+ * decompressed; sequential replay decompresses one frame at a time into
+ * a scratch buffer and copies from there. Only built on POSIX
+ * platforms.
+ */
+class zstd_file_source_c : public gr::sync_block
+{
+private:
+  friend zstd_file_source_c_sptr make_zstd_file_source_c(
+      const std::string &filename, size_t itemsize, bool repeat );
+
+  zstd_file_source_c( const std::string &filename, size_t itemsize,
+                      bool repeat );
+
+public:
+  ~zstd_file_source_c();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  bool seek( long seek_point, int whence );
+
+private:
+  bool load_frame( size_t frame );
+
+  size_t _itemsize;
+  bool _repeat;
+
+  int _fd;
+  uint32_t _frame_len; /* raw bytes per frame, from the file header */
+
+  /* file offset of each frame header, scanned at open */
+  std::vector<uint64_t> _frame_offsets;
+  std::vector<uint32_t> _frame_rawlens;
+  /* cumulative raw start offset of each frame; an appended capture
+   * buries a short frame mid file, so positions cannot map to frames
+   * by plain division */
+  std::vector<uint64_t> _frame_starts;
+  uint64_t _total_raw; /* decompressed capture size in bytes */
+
+  unsigned char *_zbuf; /* compressed frame staging */
+  size_t _zbuf_len;
+  unsigned char *_rbuf; /* decompressed frame */
+  size_t _cur_frame;    /* frame held in _rbuf, or frame count if none */
+  uint64_t _offset;     /* read position in raw bytes */
+};
+
+#endif /* ZSTD_FILE_SOURCE_C_H */
@@ -1,5 +1,8 @@
 #include "freesrp_sink_c.h"
 
+#include <thread>
+#include <chrono>
+
 using namespace FreeSRP;
 using namespace std;
 
@@ -22,6 +25,11 @@ static const int MAX_IN = 1;   // maximum number of input streams
 static const int MIN_OUT = 0;  // minimum number of output streams
 static const int MAX_OUT = 0;  // maximum number of output streams
 
+// samples per ring slot, work() hands over whole slots so the atomic
+// cost is paid once per block instead of once per sample
+static const size_t SAMPLES_PER_BUF = 4096;
+static const size_t BYTES_PER_SAMPLE = 2 * sizeof(int16_t);
+
 freesrp_sink_c::freesrp_sink_c (const string & args) : gr::sync_block("freesrp_sink_c",
                                                        gr::io_signature::make (MIN_IN, MAX_IN, sizeof (gr_complex)),
                                                        gr::io_signature::make (MIN_OUT, MAX_OUT, sizeof (gr_complex))),
@@ -31,6 +39,20 @@ freesrp_sink_c::freesrp_sink_c (const string & args) : gr::sync_block("freesrp_s
     {
         throw runtime_error("FreeSRP not initialized!");
     }
+
+    unsigned int buf_num = FREESRP_RX_TX_QUEUE_SIZE / SAMPLES_PER_BUF;
+
+    if(buf_num < 4)
+    {
+        buf_num = 4;
+    }
+
+    _ring = new ring_buffer(buf_num, SAMPLES_PER_BUF * BYTES_PER_SAMPLE);
+}
+
+freesrp_sink_c::~freesrp_sink_c ()
+{
+    delete _ring;
 }
 
 bool freesrp_sink_c::start()
@@ -40,6 +62,10 @@ bool freesrp_sink_c::start()
     {
         return false;
     }
+
+    _buf_offset = 0;
+    _running = true;
+
     _srp->start_tx(std::bind(&freesrp_sink_c::freesrp_tx_callback, this, std::placeholders::_1));
     return true;
 }
@@ -48,55 +74,80 @@ bool freesrp_sink_c::stop()
 {
     _srp->send_cmd({SET_DATAPATH_EN, 0});
     _srp->stop_tx();
+
+    _running = false;
+
     return true;
 }
 
 void freesrp_sink_c::freesrp_tx_callback(vector<sample>& samples)
 {
-    unique_lock<std::mutex> lk(_buf_mut);
+    size_t pos = 0;
 
-    for(sample &s : samples)
+    while(pos < samples.size())
     {
-        if(!_buf_queue.try_dequeue(s))
+        unsigned int buf_len = 0;
+        int16_t *buf = (int16_t *) _ring->read_ptr(&buf_len);
+
+        if(buf == nullptr)
+        {
+            // ring ran dry, the remainder is padded with silence
+            break;
+        }
+
+        size_t avail = (buf_len - _buf_offset) / BYTES_PER_SAMPLE;
+        size_t chunk = min(samples.size() - pos, avail);
+        const int16_t *src = buf + _buf_offset / sizeof(int16_t);
+
+        for(size_t i = 0; i < chunk; ++i)
         {
-            s.i = 0;
-            s.q = 0;
+            samples[pos + i].i = src[i * 2 + 0];
+            samples[pos + i].q = src[i * 2 + 1];
         }
-        else
+
+        pos += chunk;
+        _buf_offset += chunk * BYTES_PER_SAMPLE;
+
+        if(_buf_offset >= buf_len)
         {
-            _buf_available_space++;
+            _ring->read_done();
+            _buf_offset = 0;
         }
     }
 
-    _buf_cond.notify_one();
+    for(; pos < samples.size(); ++pos)
+    {
+        samples[pos].i = 0;
+        samples[pos].q = 0;
+    }
 }
 
 int freesrp_sink_c::work(int noutput_items, gr_vector_const_void_star& input_items, gr_vector_void_star& output_items)
 {
     const gr_complex *in = (const gr_complex *) input_items[0];
+    int consumed = 0;
 
-    unique_lock<std::mutex> lk(_buf_mut);
-
-    // Wait until enough space is available
-    while(_buf_available_space < (unsigned int) noutput_items)
+    while(consumed < noutput_items)
     {
-        _buf_cond.wait(lk);
-    }
-
-    for(int i = 0; i < noutput_items; ++i)
-    {
-        sample s;
-        s.i = (int16_t) (real(in[i]) * 2047.0f);
-        s.q = (int16_t) (imag(in[i]) * 2047.0f);
-
-        if(!_buf_queue.try_enqueue(s))
+        // ring full means the radio is behind, wait for it to catch up
+        while(_ring->used() == _ring->buf_num() && _running)
         {
-            throw runtime_error("Failed to add sample to buffer. This should never happen. Available space reported to be " + to_string(_buf_available_space) + " samples, noutput_items=" + to_string(noutput_items) + ", i=" + to_string(i));
+            this_thread::sleep_for(chrono::milliseconds(1));
         }
-        else
+
+        if(!_running)
         {
-            _buf_available_space--;
+            return WORK_DONE;
         }
+
+        int16_t *buf = (int16_t *) _ring->write_ptr();
+        size_t chunk = min((size_t)(noutput_items - consumed), SAMPLES_PER_BUF);
+
+        // one vectorized pass over the block instead of a scalar loop
+        _converter.fc32_s16(buf, &in[consumed], chunk, 2047.0f);
+
+        _ring->write_done(chunk * BYTES_PER_SAMPLE);
+        consumed += chunk;
     }
 
     return noutput_items;
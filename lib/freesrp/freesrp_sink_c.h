@@ -27,12 +27,10 @@
 
 #include "osmosdr/ranges.h"
 #include "sink_iface.h"
+#include "ring_buffer.h"
+#include "converter.h"
 
 #include "freesrp_common.h"
-#include "readerwriterqueue/readerwriterqueue.h"
-
-#include <mutex>
-#include <condition_variable>
 
 #include <freesrp.hpp>
 
@@ -73,6 +71,7 @@ private:
     freesrp_sink_c (const std::string & args);  	// private constructor
 
 public:
+    ~freesrp_sink_c ();	// public destructor
 
     // From freesrp_common:
     static std::vector<std::string> get_devices() { return freesrp_common::get_devices(); };
@@ -121,10 +120,9 @@ private:
 
     bool _running = false;
 
-    std::mutex _buf_mut{};
-    std::condition_variable _buf_cond{};
-    size_t _buf_available_space = FREESRP_RX_TX_QUEUE_SIZE;
-    moodycamel::ReaderWriterQueue<::FreeSRP::sample> _buf_queue{FREESRP_RX_TX_QUEUE_SIZE};
+    ring_buffer *_ring = nullptr;
+    unsigned int _buf_offset = 0; /* consumer offset into the front slot */
+    sample_converter _converter;
 };
 
 #endif /* INCLUDED_FREESRP_SINK_C_H */
@@ -22,6 +22,11 @@ static const int MAX_IN = 0;	// maximum number of input streams
 static const int MIN_OUT = 1;	// minimum number of output streams
 static const int MAX_OUT = 1;	// maximum number of output streams
 
+// samples per ring slot, the callback hands over whole slots so the
+// atomic cost is paid once per block instead of once per sample
+static const size_t SAMPLES_PER_BUF = 4096;
+static const size_t BYTES_PER_SAMPLE = 2 * sizeof(int16_t);
+
 freesrp_source_c::freesrp_source_c (const string & args) : gr::sync_block ("freesrp_source_c",
                                                                 gr::io_signature::make (MIN_IN, MAX_IN, sizeof (gr_complex)),
                                                                 gr::io_signature::make (MIN_OUT, MAX_OUT, sizeof (gr_complex))),
@@ -31,6 +36,20 @@ freesrp_source_c::freesrp_source_c (const string & args) : gr::sync_block ("free
     {
         throw runtime_error("FreeSRP not initialized!");
     }
+
+    unsigned int buf_num = FREESRP_RX_TX_QUEUE_SIZE / SAMPLES_PER_BUF;
+
+    if(buf_num < 4)
+    {
+        buf_num = 4;
+    }
+
+    _ring = new ring_buffer(buf_num, SAMPLES_PER_BUF * BYTES_PER_SAMPLE);
+}
+
+freesrp_source_c::~freesrp_source_c ()
+{
+    delete _ring;
 }
 
 bool freesrp_source_c::start()
@@ -40,10 +59,12 @@ bool freesrp_source_c::start()
     {
         return false;
     }
-    _srp->start_rx(std::bind(&freesrp_source_c::freesrp_rx_callback, this, std::placeholders::_1));
 
+    _buf_offset = 0;
     _running = true;
 
+    _srp->start_rx(std::bind(&freesrp_source_c::freesrp_rx_callback, this, std::placeholders::_1));
+
     return true;
 }
 
@@ -53,66 +74,85 @@ bool freesrp_source_c::stop()
     _srp->stop_rx();
 
     _running = false;
+    _ring->notify();
 
     return true;
 }
 
 void freesrp_source_c::freesrp_rx_callback(const vector<sample> &samples)
 {
-    unique_lock<std::mutex> lk(_buf_mut);
+    size_t pos = 0;
 
-    for(const sample &s : samples)
+    while(pos < samples.size())
     {
-        if(!_buf_queue.try_enqueue(s))
+        int16_t *buf = (int16_t *) _ring->write_ptr();
+
+        if(buf == nullptr)
         {
-	    if(!_ignore_overflow)
-	    {
-		throw runtime_error("RX buffer overflow");
-	    }
+            // ring full, the remainder of the transfer is dropped
+            if(!_ignore_overflow)
+            {
+                throw runtime_error("RX buffer overflow");
+            }
+
+            return;
         }
-        else
+
+        size_t chunk = min(samples.size() - pos, SAMPLES_PER_BUF);
+
+        // stage the raw ADC words, work() expands them in one go
+        for(size_t i = 0; i < chunk; ++i)
         {
-            _buf_num_samples++;
+            buf[i * 2 + 0] = samples[pos + i].i;
+            buf[i * 2 + 1] = samples[pos + i].q;
         }
-    }
 
-    _buf_cond.notify_one();
+        _ring->write_done(chunk * BYTES_PER_SAMPLE);
+        pos += chunk;
+    }
 }
 
 int freesrp_source_c::work(int noutput_items, gr_vector_const_void_star& input_items, gr_vector_void_star& output_items)
 {
     gr_complex *out = static_cast<gr_complex *>(output_items[0]);
+    int produced = 0;
 
-    unique_lock<std::mutex> lk(_buf_mut);
+    _ring->wait_for(1, _running);
 
     if(!_running)
     {
 	return WORK_DONE;
     }
 
-    // Wait until enough samples collected
-    while(_buf_num_samples < (unsigned int) noutput_items)
+    while(produced < noutput_items)
     {
-        _buf_cond.wait(lk);
-    }
+        unsigned int buf_len = 0;
+        int16_t *buf = (int16_t *) _ring->read_ptr(&buf_len);
 
-    for(int i = 0; i < noutput_items; ++i)
-    {
-        sample s;
-        if(!_buf_queue.try_dequeue(s))
+        if(buf == nullptr)
         {
-            // This should not be happening
-            throw runtime_error("Failed to get sample from buffer. This should never happen. Number of available samples reported to be " + to_string(_buf_num_samples) + ", noutput_items=" + to_string(noutput_items) + ", i=" + to_string(i));
+            // ring ran empty, deliver the partial chunk
+            break;
         }
-        else
+
+        int samp_avail = (buf_len - _buf_offset) / BYTES_PER_SAMPLE;
+        int nout = min(noutput_items - produced, samp_avail);
+
+        // one vectorized pass over the block instead of a scalar loop
+        _converter.s16_fc32(&out[produced], buf + _buf_offset / sizeof(int16_t),
+                            nout, 2048.0f);
+
+        produced += nout;
+        _buf_offset += nout * BYTES_PER_SAMPLE;
+
+        if(_buf_offset >= buf_len)
         {
-            _buf_num_samples--;
+            _ring->read_done();
+            _buf_offset = 0;
         }
-
-        out[i] = gr_complex(((float) s.i) / 2048.0f, ((float) s.q) / 2048.0f);
     }
 
-    return noutput_items;
+    return produced;
 }
 
 double freesrp_source_c::set_sample_rate( double rate )
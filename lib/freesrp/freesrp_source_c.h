@@ -27,16 +27,13 @@
 
 #include "osmosdr/ranges.h"
 #include "source_iface.h"
+#include "ring_buffer.h"
+#include "converter.h"
 
 #include "freesrp_common.h"
 
-#include "readerwriterqueue/readerwriterqueue.h"
-
 #include <freesrp.hpp>
 
-#include <mutex>
-#include <condition_variable>
-
 class freesrp_source_c;
 
 /*
@@ -74,10 +71,14 @@ private:
     freesrp_source_c (const std::string & args);  	// private constructor
 
 public:
+    ~freesrp_source_c ();	// public destructor
 
     // From freesrp_common:
     static std::vector<std::string> get_devices() { return freesrp_common::get_devices(); };
     size_t get_num_channels( void ) { return freesrp_common::get_num_channels(); }
+    uint64_t get_num_overflows( void ) { return _ring->num_overruns(); }
+    void reset_stream_stats( void ) { _ring->reset_overruns(); }
+    double get_buffer_level( void ) { return _ring->used() / (double) _ring->buf_num(); }
     osmosdr::meta_range_t get_sample_rates( void ) { return freesrp_common::get_sample_rates(); }
     osmosdr::freq_range_t get_freq_range( size_t chan = 0 ) { return freesrp_common::get_freq_range(chan); }
     osmosdr::freq_range_t get_bandwidth_range( size_t chan = 0 ) { return freesrp_common::get_bandwidth_range(chan); }
@@ -122,10 +123,9 @@ private:
 
     bool _running = false;
 
-    std::mutex _buf_mut{};
-    std::condition_variable _buf_cond{};
-    size_t _buf_num_samples = 0;
-    moodycamel::ReaderWriterQueue<FreeSRP::sample> _buf_queue{FREESRP_RX_TX_QUEUE_SIZE};
+    ring_buffer *_ring = nullptr;
+    unsigned int _buf_offset = 0; /* consumer offset into the front slot */
+    sample_converter _converter;
 };
 
 #endif /* INCLUDED_FREESRP_SOURCE_C_H */
@@ -31,13 +31,10 @@
 #include <stdexcept>
 #include <iostream>
 #include <algorithm>
-#ifdef USE_AVX
-#include <immintrin.h>
-#elif USE_SSE2
-#include <emmintrin.h>
-#endif
+#include <volk/volk.h>
 
 #include <boost/assign.hpp>
+#include <boost/foreach.hpp>
 #include <boost/format.hpp>
 #include <boost/detail/endian.hpp>
 #include <boost/algorithm/string.hpp>
@@ -158,6 +155,11 @@ hackrf_sink_c::hackrf_sink_c (const std::string &args)
         gr::io_signature::make(MIN_OUT, MAX_OUT, sizeof (gr_complex))),
     _dev(NULL),
     _buf(NULL),
+    _underflows(0),
+    _burst_mode(false),
+    _in_burst(false),
+    _tx_active(false),
+    _burst_remaining(0),
     _sample_rate(0),
     _center_freq(0),
     _freq_corr(0),
@@ -182,6 +184,9 @@ hackrf_sink_c::hackrf_sink_c (const std::string &args)
   if (0 == _buf_num)
     _buf_num = BUF_NUM;
 
+  if (dict.count("burst"))
+    _burst_mode = boost::lexical_cast< bool >( dict["burst"] );
+
   {
     boost::mutex::scoped_lock lock( _usage_mutex );
 
@@ -244,14 +249,26 @@ hackrf_sink_c::hackrf_sink_c (const std::string &args)
     }
   }
 
-  _buf = (int8_t *) malloc( BUF_LEN );
+  _buf = (int8_t *) volk_malloc( BUF_LEN, volk_get_alignment() );
 
   cb_init( &_cbuf, _buf_num, BUF_LEN );
 
 //  _thread = gr::thread::thread(_hackrf_wait, this);
 
-  ret = hackrf_start_tx( _dev, _hackrf_tx_callback, (void *)this );
-  HACKRF_THROW_ON_ERROR(ret, "Failed to start TX streaming")
+  if ( _burst_mode ) {
+    /* the transmitter goes on the air with the first tx_sob tag */
+    std::cerr << "Transmitting tagged bursts only." << std::endl;
+  } else {
+    ret = hackrf_start_tx( _dev, _hackrf_tx_callback, (void *)this );
+    HACKRF_THROW_ON_ERROR(ret, "Failed to start TX streaming")
+    _tx_active = true;
+  }
+
+  /* Set up constraints: produce in aligned full SIMD widths so the
+   * conversion kernels never have to run a scalar tail */
+  int const alignment_multiple = volk_get_alignment() / sizeof(gr_complex);
+  set_alignment(std::max(1, alignment_multiple));
+  set_output_multiple(std::max(1, alignment_multiple));
 }
 
 /*
@@ -261,10 +278,14 @@ hackrf_sink_c::~hackrf_sink_c ()
 {
   if (_dev) {
 //    _thread.join();
-    int ret = hackrf_stop_tx( _dev );
-    if ( ret != HACKRF_SUCCESS )
+    int ret;
+    if ( _tx_active )
     {
-      std::cerr << HACKRF_FORMAT_ERROR(ret, "Failed to stop TX streaming") << std::endl;
+      ret = hackrf_stop_tx( _dev );
+      if ( ret != HACKRF_SUCCESS )
+      {
+        std::cerr << HACKRF_FORMAT_ERROR(ret, "Failed to stop TX streaming") << std::endl;
+      }
     }
     ret = hackrf_close( _dev );
     if ( ret != HACKRF_SUCCESS )
@@ -283,7 +304,7 @@ hackrf_sink_c::~hackrf_sink_c ()
     }
   }
 
-  free(_buf);
+  volk_free(_buf);
   _buf = NULL;
 
   cb_free( &_cbuf );
@@ -306,6 +327,7 @@ int hackrf_sink_c::hackrf_tx_callback(unsigned char *buffer, uint32_t length)
 
     if ( ! cb_pop_front( &_cbuf, buffer ) ) {
       memset(buffer, 0, length);
+      _underflows.fetch_add(1, boost::memory_order_relaxed);
       std::cerr << "U" << std::flush;
     } else {
 //      std::cerr << "-" << std::flush;
@@ -325,12 +347,74 @@ void hackrf_sink_c::hackrf_wait()
 {
 }
 
+bool hackrf_sink_c::tx_start()
+{
+  if ( _tx_active )
+    return true;
+
+  int ret = hackrf_start_tx( _dev, _hackrf_tx_callback, (void *)this );
+  if ( ret != HACKRF_SUCCESS ) {
+    std::cerr << HACKRF_FORMAT_ERROR(ret, "Failed to start TX streaming") << std::endl;
+    return false;
+  }
+
+  _tx_active = true;
+  return true;
+}
+
+bool hackrf_sink_c::tx_stop()
+{
+  if ( ! _tx_active )
+    return true;
+
+  int ret = hackrf_stop_tx( _dev );
+  if ( ret != HACKRF_SUCCESS ) {
+    std::cerr << HACKRF_FORMAT_ERROR(ret, "Failed to stop TX streaming") << std::endl;
+    return false;
+  }
+
+  _tx_active = false;
+  return true;
+}
+
+/* Pad the staging buffer to a full transfer, let the usb thread drain
+ * the queue and take the transmitter off the air, so an idle slot costs
+ * no usb bandwidth at all. */
+void hackrf_sink_c::finish_burst()
+{
+  if ( _buf_used ) {
+    memset( _buf + _buf_used, 0, BUF_LEN - _buf_used );
+
+    {
+      boost::mutex::scoped_lock lock( _buf_mutex );
+
+      while ( ! cb_has_room(&_cbuf) )
+        _buf_cond.wait( lock );
+
+      cb_push_back( &_cbuf, _buf );
+    }
+
+    _buf_used = 0;
+  }
+
+  {
+    boost::mutex::scoped_lock lock( _buf_mutex );
+
+    while ( _cbuf.count ) /* the callback notifies on every pop */
+      _buf_cond.wait( lock );
+  }
+
+  tx_stop();
+}
+
 bool hackrf_sink_c::start()
 {
   if ( ! _dev )
     return false;
 
   _buf_used = 0;
+  _in_burst = false;
+  _burst_remaining = 0;
 #if 0
   int ret = hackrf_start_tx( _dev, _hackrf_tx_callback, (void *)this );
   if ( ret != HACKRF_SUCCESS ) {
@@ -345,6 +429,9 @@ bool hackrf_sink_c::stop()
 {
   if ( ! _dev )
     return false;
+
+  if ( _burst_mode ) /* off the air until the next tx_sob */
+    tx_stop();
 #if 0
   int ret = hackrf_stop_tx( _dev );
   if ( ret != HACKRF_SUCCESS ) {
@@ -355,73 +442,66 @@ bool hackrf_sink_c::stop()
   return true;
 }
 
-#ifdef USE_AVX
-void convert_avx(const float* inbuf, int8_t* outbuf,const unsigned int count)
+int hackrf_sink_c::work( int noutput_items,
+                         gr_vector_const_void_star &input_items,
+                         gr_vector_void_star &output_items )
 {
-  __m256 mulme = _mm256_set_ps(127.0f, 127.0f, 127.0f, 127.0f, 127.0f, 127.0f, 127.0f, 127.0f);
-  for(unsigned int i=0; i<count;i++){
-
-  __m256i itmp3 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(&inbuf[i*16+0]), mulme));
-  __m256i itmp4 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(&inbuf[i*16+8]), mulme));
+  const gr_complex *in = (const gr_complex *) input_items[0];
+  bool burst_ends = false;
 
-  __m128i a1 = _mm256_extractf128_si256(itmp3, 1);
-  __m128i a0 = _mm256_castsi256_si128(itmp3);
-  __m128i a3 = _mm256_extractf128_si256(itmp4, 1);
-  __m128i a2 = _mm256_castsi256_si128(itmp4);
+  if ( _burst_mode ) {
+    uint64_t base = nitems_read(0);
+    std::vector<gr::tag_t> tags;
 
-  __m128i outshorts1 = _mm_packs_epi32(a0, a1);
-  __m128i outshorts2 = _mm_packs_epi32(a2, a3);
+    /* the runtime keeps these ordered by offset, see the note in
+     * bladerf_sink_c::transmit_with_tags() */
+    get_tags_in_window( tags, 0, 0, noutput_items );
 
-  __m128i outbytes = _mm_packs_epi16(outshorts1, outshorts2);
+    if ( ! _in_burst ) {
+      /* idle slot: consume the padding, it never reaches the usb */
+      uint64_t start = base + noutput_items;
 
-  _mm_storeu_si128 ((__m128i*)&outbuf[i*16], outbytes);
-  }
-}
-
-#elif USE_SSE2
-void convert_sse2(const float* inbuf, int8_t* outbuf,const unsigned int count)
-{
-  const register __m128 mulme = _mm_set_ps( 127.0f, 127.0f, 127.0f, 127.0f );
-  __m128 itmp1,itmp2,itmp3,itmp4;
-  __m128i otmp1,otmp2,otmp3,otmp4;
+      BOOST_FOREACH( gr::tag_t tag, tags ) {
+        std::string key = pmt::symbol_to_string(tag.key);
 
-  __m128i outshorts1,outshorts2;
-  __m128i outbytes;
+        if ( "tx_sob" == key || "packet_len" == key ) {
+          start = tag.offset;
 
-  for(unsigned int i=0; i<count;i++){
+          if ( "packet_len" == key ) /* burst length known up front */
+            _burst_remaining = pmt::to_long(tag.value);
 
-  itmp1 = _mm_mul_ps(_mm_loadu_ps(&inbuf[i*16+0]), mulme);
-  itmp2 = _mm_mul_ps(_mm_loadu_ps(&inbuf[i*16+4]), mulme);
-  itmp3 = _mm_mul_ps(_mm_loadu_ps(&inbuf[i*16+8]), mulme);
-  itmp4 = _mm_mul_ps(_mm_loadu_ps(&inbuf[i*16+12]), mulme);
+          break;
+        }
+      }
 
-  otmp1 = _mm_cvtps_epi32(itmp1);
-  otmp2 = _mm_cvtps_epi32(itmp2);
-  otmp3 = _mm_cvtps_epi32(itmp3);
-  otmp4 = _mm_cvtps_epi32(itmp4);
+      if ( start > base ) {
+        consume_each( (int)(start - base) );
+        return 0;
+      }
 
-  outshorts1 = _mm_packs_epi32(otmp1, otmp2);
-  outshorts2 = _mm_packs_epi32(otmp3, otmp4);
+      /* prime the transmitter just in time for the first samples */
+      if ( ! tx_start() )
+        return WORK_DONE;
 
-  outbytes = _mm_packs_epi16(outshorts1, outshorts2);
+      _in_burst = true;
+    }
 
-  _mm_storeu_si128 ((__m128i*)&outbuf[i*16], outbytes);
-  }
-}
-#endif
+    /* truncate the call at the burst end so the buffer logic below
+     * never mixes samples of different bursts */
+    BOOST_FOREACH( gr::tag_t tag, tags ) {
+      if ( "tx_eob" == pmt::symbol_to_string(tag.key) &&
+           (long)(tag.offset - base) < (long)noutput_items ) {
+        noutput_items = (int)(tag.offset - base) + 1; /* eob marks the last sample */
+        burst_ends = true;
+        break;
+      }
+    }
 
-void convert_default(float* inbuf, int8_t* outbuf,const unsigned int count)
-{
-  for(unsigned int i=0; i<count;i++){
-    outbuf[i]= inbuf[i]*127;
+    if ( _burst_remaining > 0 && _burst_remaining <= (long)noutput_items ) {
+      noutput_items = (int)_burst_remaining;
+      burst_ends = true;
+    }
   }
-}
-
-int hackrf_sink_c::work( int noutput_items,
-                         gr_vector_const_void_star &input_items,
-                         gr_vector_void_star &output_items )
-{
-  const gr_complex *in = (const gr_complex *) input_items[0];
 
   {
     boost::mutex::scoped_lock lock( _buf_mutex );
@@ -436,21 +516,13 @@ int hackrf_sink_c::work( int noutput_items,
   unsigned int remaining = (BUF_LEN-_buf_used)/2; //complex
 
   unsigned int count = std::min((unsigned int)noutput_items,remaining);
-  unsigned int sse_rem = count/8; // 8 complex = 16f==512bit for avx
-  unsigned int nosse_rem = count%8; // remainder
-
-#ifdef USE_AVX
-  convert_avx((float*)in, buf, sse_rem);
-  convert_default((float*)(in+sse_rem*8), buf+(sse_rem*8*2), nosse_rem*2);
-#elif USE_SSE2
-  convert_sse2((float*)in, buf, sse_rem);
-  convert_default((float*)(in+sse_rem*8), buf+(sse_rem*8*2), nosse_rem*2);
-#else
-  convert_default((float*)in, buf, count*2);
-#endif
 
-  _buf_used += (sse_rem*8+nosse_rem)*2;
-  int items_consumed = sse_rem*8+nosse_rem;
+  /* VOLK picks the best machine kernel at runtime, so the conversion no
+   * longer depends on the instruction set selected at compile time. */
+  volk_32f_s32f_convert_8i( buf, (const float *)in, 127.0f, count*2 );
+
+  _buf_used += count*2;
+  int items_consumed = count;
 
   if((unsigned int)noutput_items >= remaining) {
     {
@@ -467,6 +539,18 @@ int hackrf_sink_c::work( int noutput_items,
     }
   }
 
+  if ( _in_burst ) {
+    if ( _burst_remaining > 0 )
+      _burst_remaining -= items_consumed;
+
+    /* with the buffer full the burst end moves to the next call */
+    if ( burst_ends && items_consumed == noutput_items ) {
+      finish_burst();
+      _in_burst = false;
+      _burst_remaining = 0;
+    }
+  }
+
   // Tell runtime system how many input items we consumed on
   // each input stream.
   consume_each(items_consumed);
@@ -556,6 +640,16 @@ size_t hackrf_sink_c::get_num_channels()
   return 1;
 }
 
+uint64_t hackrf_sink_c::get_num_underflows()
+{
+  return _underflows.load(boost::memory_order_relaxed);
+}
+
+void hackrf_sink_c::reset_stream_stats()
+{
+  _underflows.store(0, boost::memory_order_relaxed);
+}
+
 osmosdr::meta_range_t hackrf_sink_c::get_sample_rates()
 {
   osmosdr::meta_range_t range;
@@ -630,9 +724,18 @@ double hackrf_sink_c::get_center_freq( size_t chan )
 
 double hackrf_sink_c::set_freq_corr( double ppm, size_t chan )
 {
+  if ( ppm == _freq_corr )
+    return get_freq_corr( chan );
+
+  /* the tuner is programmed with integer granularity, so small
+   * calibration steps often leave the corrected frequency unchanged;
+   * skip the tuner transaction entirely in that case */
+  double prev = APPLY_PPM_CORR( _center_freq, _freq_corr );
+
   _freq_corr = ppm;
 
-  set_center_freq( _center_freq );
+  if ( uint64_t( APPLY_PPM_CORR( _center_freq, ppm ) ) != uint64_t( prev ) )
+    set_center_freq( _center_freq );
 
   return get_freq_corr( chan );
 }
@@ -23,6 +23,7 @@
 #include <gnuradio/thread/thread.h>
 #include <gnuradio/sync_block.h>
 
+#include <boost/atomic.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/condition_variable.hpp>
 
@@ -90,6 +91,9 @@ public:
 
   size_t get_num_channels( void );
 
+  uint64_t get_num_underflows( void );
+  void reset_stream_stats( void );
+
   osmosdr::meta_range_t get_sample_rates( void );
   double set_sample_rate( double rate );
   double get_sample_rate( void );
@@ -127,6 +131,10 @@ private:
   static void _hackrf_wait(hackrf_sink_c *obj);
   void hackrf_wait();
 
+  bool tx_start();
+  bool tx_stop();
+  void finish_burst();
+
   static int _usage;
   static boost::mutex _usage_mutex;
 
@@ -139,6 +147,12 @@ private:
   unsigned int _buf_used;
   boost::mutex _buf_mutex;
   boost::condition_variable _buf_cond;
+  boost::atomic<uint64_t> _underflows;
+
+  bool _burst_mode;       /* burst=1: transmit tagged bursts only */
+  bool _in_burst;         /* between a tx_sob and the matching tx_eob */
+  bool _tx_active;        /* usb streaming is running */
+  long _burst_remaining;  /* samples left of a length tagged burst */
 
   double _sample_rate;
   double _center_freq;
@@ -27,20 +27,24 @@
 #include "config.h"
 #endif
 
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 #include <iostream>
 
 #include <boost/assign.hpp>
 #include <boost/format.hpp>
-#include <boost/detail/endian.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/thread/thread.hpp>
 
 #include <gnuradio/io_signature.h>
 
+#include <volk/volk.h>
+
 #include "hackrf_source_c.h"
 
 #include "arg_helpers.h"
+#include "osmosdr_trace.h"
 
 using namespace boost::assign;
 
@@ -49,6 +53,11 @@ using namespace boost::assign;
 
 #define BYTES_PER_SAMPLE  2 /* HackRF device produces 8 bit unsigned IQ data */
 
+/* the hardware sweep delivers fixed size blocks, each led by a ten
+ * byte header carrying 0x7f 0x7f and the tuned frequency */
+#define SWEEP_BLOCK_LEN   16384
+#define SWEEP_HEADER_LEN  10
+
 #define HACKRF_FORMAT_ERROR(ret, msg) \
   boost::str( boost::format(msg " (%1%) %2%") \
     % ret % hackrf_error_name((enum hackrf_error)ret) )
@@ -92,7 +101,8 @@ hackrf_source_c::hackrf_source_c (const std::string &args)
         gr::io_signature::make(MIN_IN, MAX_IN, sizeof (gr_complex)),
         gr::io_signature::make(MIN_OUT, MAX_OUT, sizeof (gr_complex))),
     _dev(NULL),
-    _buf(NULL),
+    _ring(NULL),
+    _thread_policy_applied(false),
     _sample_rate(0),
     _center_freq(0),
     _freq_corr(0),
@@ -100,14 +110,18 @@ hackrf_source_c::hackrf_source_c (const std::string &args)
     _amp_gain(0),
     _lna_gain(0),
     _vga_gain(0),
-    _bandwidth(0)
+    _bandwidth(0),
+    _sweep_start(0),
+    _sweep_stop(0),
+    _sweep_step(0),
+    _sweep_remaining(0)
 {
   int ret;
   std::string hackrf_serial;
 
   dict_t dict = params_to_dict(args);
 
-  _buf_num = _buf_len = _buf_head = _buf_used = _buf_offset = 0;
+  _buf_num = _buf_len = _buf_offset = 0;
 
   if (dict.count("buffers"))
     _buf_num = boost::lexical_cast< unsigned int >( dict["buffers"] );
@@ -115,6 +129,34 @@ hackrf_source_c::hackrf_source_c (const std::string &args)
 //  if (dict.count("buflen"))
 //    _buf_len = boost::lexical_cast< unsigned int >( dict["buflen"] );
 
+  /* buffer_ms= sizes the transfers for the wanted amount of buffering
+   * at the configured sample rate instead of the fixed default */
+  _buffer_ms = 0.0;
+  if (dict.count("buffer_ms"))
+    _buffer_ms = boost::lexical_cast< double >( dict["buffer_ms"] );
+
+  /* sweep=start:stop:step switches on the firmware driven hardware
+   * sweep, which retunes orders of magnitude faster than discrete
+   * set_center_freq() round trips; each captured block is annotated
+   * with an rx_freq stream tag */
+  if (dict.count("sweep")) {
+#ifdef LIBHACKRF_HAVE_START_RX_SWEEP
+    std::vector< std::string > fields;
+    boost::algorithm::split( fields, dict["sweep"], boost::is_any_of( ":" ) );
+
+    if ( 3 == fields.size() ) {
+      _sweep_start = boost::lexical_cast< double >( fields[0] );
+      _sweep_stop = boost::lexical_cast< double >( fields[1] );
+      _sweep_step = boost::lexical_cast< double >( fields[2] );
+    }
+
+    if ( _sweep_step <= 0 || _sweep_stop < _sweep_start )
+      throw std::runtime_error("Expected sweep=start:stop:step with step > 0.");
+#else
+    throw std::runtime_error("Hardware sweep not supported by libhackrf.");
+#endif
+  }
+
   if (0 == _buf_num)
     _buf_num = BUF_NUM;
 
@@ -123,17 +165,6 @@ hackrf_source_c::hackrf_source_c (const std::string &args)
 
   _samp_avail = _buf_len / BYTES_PER_SAMPLE;
 
-  // create a lookup table for gr_complex values
-  for (unsigned int i = 0; i <= 0xffff; i++) {
-#ifdef BOOST_LITTLE_ENDIAN
-    _lut.push_back( gr_complex( (float(int8_t(i & 0xff))) * (1.0f/128.0f),
-                                (float(int8_t(i >> 8))) * (1.0f/128.0f) ) );
-#else // BOOST_BIG_ENDIAN
-    _lut.push_back( gr_complex( (float(int8_t(i >> 8))) * (1.0f/128.0f),
-                                (float(int8_t(i & 0xff))) * (1.0f/128.0f) ) );
-#endif
-  }
-
   {
     boost::mutex::scoped_lock lock( _usage_mutex );
 
@@ -223,17 +254,52 @@ hackrf_source_c::hackrf_source_c (const std::string &args)
     }
   }
 
-  _buf = (unsigned short **) malloc(_buf_num * sizeof(unsigned short *));
+  alloc_policy policy;
+  if ( dict.count("hugepages") )
+    policy.hugepages = boost::lexical_cast<bool>( dict["hugepages"] );
+  if ( dict.count("numa_node") )
+    policy.numa_node = boost::lexical_cast<int>( dict["numa_node"] );
 
-  if (_buf) {
-    for(unsigned int i = 0; i < _buf_num; ++i)
-      _buf[i] = (unsigned short *) malloc(_buf_len);
-  }
+  if ( dict.count("affinity") )
+    _thread_policy.affinity = boost::lexical_cast<int>( dict["affinity"] );
+  if ( dict.count("rt_prio") )
+    _thread_policy.rt_prio = boost::lexical_cast<int>( dict["rt_prio"] );
+
+  _ring = new ring_buffer(_buf_num, _buf_len, 0, policy);
+
+  if ( dict.count("overflow") )
+    _ring->set_overflow_policy(
+          ring_buffer::policy_from_string( dict["overflow"] ) );
 
 //  _thread = gr::thread::thread(_hackrf_wait, this);
 
-  ret = hackrf_start_rx( _dev, _hackrf_rx_callback, (void *)this );
-  HACKRF_THROW_ON_ERROR(ret, "Failed to start RX streaming")
+#ifdef LIBHACKRF_HAVE_START_RX_SWEEP
+  if ( _sweep_step > 0.0 ) {
+    /* one block is captured per step; the firmware expects the range
+     * as whole MHz, so the bounds are widened to the enclosing ones */
+    uint16_t range[2];
+    range[0] = (uint16_t)(_sweep_start / 1e6);
+    range[1] = (uint16_t)ceil( _sweep_stop / 1e6 );
+
+    ret = hackrf_init_sweep( _dev, range, 1, SWEEP_BLOCK_LEN,
+                             (uint32_t)_sweep_step, 0, LINEAR );
+    HACKRF_THROW_ON_ERROR(ret, "Failed to configure hardware sweep")
+
+    ret = hackrf_start_rx_sweep( _dev, _hackrf_rx_callback, (void *)this );
+    HACKRF_THROW_ON_ERROR(ret, "Failed to start RX sweep")
+  }
+  else
+#endif
+  {
+    ret = hackrf_start_rx( _dev, _hackrf_rx_callback, (void *)this );
+    HACKRF_THROW_ON_ERROR(ret, "Failed to start RX streaming")
+  }
+
+  /* Set up constraints: produce in aligned full SIMD widths so the
+   * conversion kernels never have to run a scalar tail */
+  int const alignment_multiple = volk_get_alignment() / sizeof(gr_complex);
+  set_alignment(std::max(1, alignment_multiple));
+  set_output_multiple(std::max(1, alignment_multiple));
 }
 
 /*
@@ -265,13 +331,9 @@ hackrf_source_c::~hackrf_source_c ()
     }
   }
 
-  if (_buf) {
-    for(unsigned int i = 0; i < _buf_num; ++i) {
-      free(_buf[i]);
-    }
-
-    free(_buf);
-    _buf = NULL;
+  if (_ring) {
+    delete _ring;
+    _ring = NULL;
   }
 }
 
@@ -283,21 +345,15 @@ int hackrf_source_c::_hackrf_rx_callback(hackrf_transfer *transfer)
 
 int hackrf_source_c::hackrf_rx_callback(unsigned char *buf, uint32_t len)
 {
-  {
-    boost::mutex::scoped_lock lock( _buf_mutex );
-
-    int buf_tail = (_buf_head + _buf_used) % _buf_num;
-    memcpy(_buf[buf_tail], buf, len);
+  OSMOSDR_TRACE1(hackrf_callback, len);
 
-    if (_buf_used == _buf_num) {
-      std::cerr << "O" << std::flush;
-      _buf_head = (_buf_head + 1) % _buf_num;
-    } else {
-      _buf_used++;
-    }
+  if (!_thread_policy_applied) {
+    /* first callback, we are on libhackrf's libusb thread now */
+    apply_thread_policy( _thread_policy );
+    _thread_policy_applied = true;
   }
 
-  _buf_cond.notify_one();
+  _ring->write(buf, len); /* drops the transfer on overrun */
 
   return 0; // TODO: return -1 on error/stop
 }
@@ -315,6 +371,36 @@ bool hackrf_source_c::start()
 {
   if ( ! _dev )
     return false;
+
+  /* transfers run continuously since the constructor, so the geometry
+   * wanted by buffer_ms= is applied here where the sample rate is
+   * known and work() is not consuming yet, with the transfers paused
+   * around the ring reallocation. libhackrf hands us fixed size
+   * transfers, so only the slot count can adapt; the slot length must
+   * stay at one transfer. sweep mode keeps its geometry, restarting
+   * the plain transfers here would end the sweep. */
+  if ( _buffer_ms > 0.0 && _sample_rate > 0.0 && _sweep_step <= 0.0 ) {
+    double bytes = _sample_rate * BYTES_PER_SAMPLE * _buffer_ms / 1e3;
+    unsigned int buf_num = (unsigned int)ceil( bytes / _buf_len );
+
+    if ( buf_num < 2 )
+      buf_num = 2;
+
+    if ( buf_num != _buf_num ) {
+      hackrf_stop_rx( _dev );
+
+      _buf_num = buf_num;
+      _ring->resize( _buf_num, _buf_len );
+      _buf_offset = 0;
+      _samp_avail = _buf_len / BYTES_PER_SAMPLE;
+
+      std::cerr << "Using " << _buf_num << " buffers of size " << _buf_len
+                << "." << std::endl;
+
+      hackrf_start_rx( _dev, _hackrf_rx_callback, (void *)this );
+    }
+  }
+
 #if 0
   int ret = hackrf_start_rx( _dev, _hackrf_rx_callback, (void *)this );
   if ( ret != HACKRF_SUCCESS ) {
@@ -345,54 +431,136 @@ int hackrf_source_c::work( int noutput_items,
 {
   gr_complex *out = (gr_complex *)output_items[0];
 
+  OSMOSDR_TRACE2(hackrf_work_entry, noutput_items, _ring->used());
+
+  if ( _sweep_step > 0.0 )
+    return work_sweep( noutput_items, output_items );
+
   bool running = false;
 
   if ( _dev )
     running = (hackrf_is_streaming( _dev ) == HACKRF_TRUE);
 
-  {
-    boost::mutex::scoped_lock lock( _buf_mutex );
-
-    while (_buf_used < 3 && running) // collect at least 3 buffers
-      _buf_cond.wait( lock );
-  }
+  _ring->wait_for(3, running); // collect at least 3 buffers
 
   if ( ! running )
     return WORK_DONE;
 
-  unsigned short *buf = _buf[_buf_head] + _buf_offset;
+  /* the hackrf delivers signed 8 bit IQ, which maps onto a single volk
+   * kernel with the 1/128 scale folded in. the runtime dispatcher picks
+   * the best SIMD implementation for the machine we run on. */
+  const signed char *buf =
+      (signed char *)_ring->read_ptr() + _buf_offset * BYTES_PER_SAMPLE;
 
   if (noutput_items <= _samp_avail) {
-    for (int i = 0; i < noutput_items; ++i)
-      *out++ = _lut[ *(buf + i) ];
+    volk_8i_s32f_convert_32f((float *)out, buf, 128.0f,
+                             noutput_items * 2);
 
     _buf_offset += noutput_items;
     _samp_avail -= noutput_items;
   } else {
-    for (int i = 0; i < _samp_avail; ++i)
-      *out++ = _lut[ *(buf + i) ];
+    volk_8i_s32f_convert_32f((float *)out, buf, 128.0f,
+                             _samp_avail * 2);
 
-    {
-      boost::mutex::scoped_lock lock( _buf_mutex );
+    out += _samp_avail;
 
-      _buf_head = (_buf_head + 1) % _buf_num;
-      _buf_used--;
-    }
+    int remaining = noutput_items - _samp_avail;
 
-    buf = _buf[_buf_head];
+    _ring->read_done();
 
-    int remaining = noutput_items - _samp_avail;
+    buf = (signed char *)_ring->read_ptr();
+
+    if (!buf) { /* ring ran empty, deliver the partial chunk */
+      noutput_items -= remaining;
+      _buf_offset = 0;
+      _samp_avail = _buf_len / BYTES_PER_SAMPLE;
+      return noutput_items;
+    }
 
-    for (int i = 0; i < remaining; ++i)
-      *out++ = _lut[ *(buf + i) ];
+    volk_8i_s32f_convert_32f((float *)out, buf, 128.0f,
+                             remaining * 2);
 
     _buf_offset = remaining;
     _samp_avail = (_buf_len / BYTES_PER_SAMPLE) - remaining;
   }
 
+  OSMOSDR_TRACE1(hackrf_work_exit, noutput_items);
+
   return noutput_items;
 }
 
+/* sweep mode consumer: walks the ring in fixed size sweep blocks,
+ * validates each block header, tags the first sample of a block with
+ * the frequency the firmware had tuned to and converts the payload.
+ * _buf_offset counts bytes here, not samples. */
+int hackrf_source_c::work_sweep( int noutput_items,
+                                 gr_vector_void_star &output_items )
+{
+  gr_complex *out = (gr_complex *)output_items[0];
+  int produced = 0;
+
+  bool running = false;
+
+  if ( _dev )
+    running = (hackrf_is_streaming( _dev ) == HACKRF_TRUE);
+
+  _ring->wait_for(1, running);
+
+  if ( ! running )
+    return WORK_DONE;
+
+  while ( produced < noutput_items ) {
+    unsigned int slot_len = 0;
+    unsigned char *buf = (unsigned char *)_ring->read_ptr( &slot_len );
+
+    if ( ! buf ) /* ring ran empty, deliver the partial chunk */
+      break;
+
+    if ( 0 == _sweep_remaining ) { /* at a block boundary */
+      if ( _buf_offset + SWEEP_BLOCK_LEN > slot_len ) {
+        _ring->read_done();
+        _buf_offset = 0;
+        continue;
+      }
+
+      unsigned char *block = buf + _buf_offset;
+
+      if ( 0x7f != block[0] || 0x7f != block[1] ) {
+        /* lost sync, drop the block and try the next boundary */
+        _buf_offset += SWEEP_BLOCK_LEN;
+        continue;
+      }
+
+      uint64_t freq = 0; /* tuned frequency, little endian */
+      for ( int i = 7; i >= 0; i-- )
+        freq = (freq << 8) | block[2 + i];
+
+      add_item_tag( 0, nitems_written(0) + produced,
+                    pmt::mp("rx_freq"),
+                    pmt::from_double( (double)freq ),
+                    pmt::mp(alias()) );
+
+      _buf_offset += SWEEP_HEADER_LEN;
+      _sweep_remaining = (SWEEP_BLOCK_LEN - SWEEP_HEADER_LEN)
+                         / BYTES_PER_SAMPLE;
+    }
+
+    int n = noutput_items - produced;
+    if ( n > _sweep_remaining )
+      n = _sweep_remaining;
+
+    volk_8i_s32f_convert_32f((float *)(out + produced),
+                             (const signed char *)buf + _buf_offset,
+                             128.0f, n * 2);
+
+    _buf_offset += n * BYTES_PER_SAMPLE;
+    _sweep_remaining -= n;
+    produced += n;
+  }
+
+  return produced;
+}
+
 std::vector<std::string> hackrf_source_c::get_devices()
 {
   std::vector<std::string> devices;
@@ -474,6 +642,21 @@ size_t hackrf_source_c::get_num_channels()
   return 1;
 }
 
+uint64_t hackrf_source_c::get_num_overflows()
+{
+  return _ring->num_overruns();
+}
+
+void hackrf_source_c::reset_stream_stats()
+{
+  _ring->reset_overruns();
+}
+
+double hackrf_source_c::get_buffer_level()
+{
+  return _ring->used() / (double)_ring->buf_num();
+}
+
 osmosdr::meta_range_t hackrf_source_c::get_sample_rates()
 {
   osmosdr::meta_range_t range;
@@ -548,9 +731,18 @@ double hackrf_source_c::get_center_freq( size_t chan )
 
 double hackrf_source_c::set_freq_corr( double ppm, size_t chan )
 {
+  if ( ppm == _freq_corr )
+    return get_freq_corr( chan );
+
+  /* the tuner is programmed with integer granularity, so small
+   * calibration steps often leave the corrected frequency unchanged;
+   * skip the tuner transaction entirely in that case */
+  double prev = APPLY_PPM_CORR( _center_freq, _freq_corr );
+
   _freq_corr = ppm;
 
-  set_center_freq( _center_freq );
+  if ( uint64_t( APPLY_PPM_CORR( _center_freq, ppm ) ) != uint64_t( prev ) )
+    set_center_freq( _center_freq );
 
   return get_freq_corr( chan );
 }
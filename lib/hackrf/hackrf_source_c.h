@@ -31,6 +31,8 @@
 #include <libhackrf/hackrf.h>
 
 #include "source_iface.h"
+#include "ring_buffer.h"
+#include "thread_policy.h"
 
 class hackrf_source_c;
 
@@ -89,6 +91,10 @@ public:
 
   size_t get_num_channels( void );
 
+  uint64_t get_num_overflows( void );
+  void reset_stream_stats( void );
+  double get_buffer_level( void );
+
   osmosdr::meta_range_t get_sample_rates( void );
   double set_sample_rate( double rate );
   double get_sample_rate( void );
@@ -125,21 +131,22 @@ private:
   int hackrf_rx_callback(unsigned char *buf, uint32_t len);
   static void _hackrf_wait(hackrf_source_c *obj);
   void hackrf_wait();
+  int work_sweep( int noutput_items, gr_vector_void_star &output_items );
 
   static int _usage;
   static boost::mutex _usage_mutex;
 
-  std::vector<gr_complex> _lut;
-
   hackrf_device *_dev;
   gr::thread::thread _thread;
-  unsigned short **_buf;
+  ring_buffer *_ring;
   unsigned int _buf_num;
   unsigned int _buf_len;
-  unsigned int _buf_head;
-  unsigned int _buf_used;
-  boost::mutex _buf_mutex;
-  boost::condition_variable _buf_cond;
+  double _buffer_ms; /* autosize the ring for this much buffering, 0 = fixed */
+
+  /* applied from the first rx callback, which runs on the libusb
+   * thread spawned inside libhackrf */
+  thread_policy _thread_policy;
+  bool _thread_policy_applied;
 
   unsigned int _buf_offset;
   int _samp_avail;
@@ -152,6 +159,14 @@ private:
   double _lna_gain;
   double _vga_gain;
   double _bandwidth;
+
+  /* hardware sweep mode (sweep=start:stop:step): the firmware retunes
+   * on its own and prefixes each block with the tuned frequency,
+   * work_sweep() strips the headers and turns them into rx_freq tags */
+  double _sweep_start;
+  double _sweep_stop;
+  double _sweep_step;
+  int _sweep_remaining; /* samples left in the current sweep block */
 };
 
 #endif /* INCLUDED_HACKRF_SOURCE_C_H */
@@ -0,0 +1,112 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2012 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#include "iq_correct_cc.h"
+
+#include <gnuradio/io_signature.h>
+
+#include <volk/volk.h>
+
+#include <cstring>
+
+iq_correct_cc_sptr make_iq_correct_cc()
+{
+  return gnuradio::get_initial_sptr(new iq_correct_cc());
+}
+
+iq_correct_cc::iq_correct_cc()
+  : gr::sync_block("iq_correct_cc",
+        gr::io_signature::make(1, 1, sizeof(gr_complex)),
+        gr::io_signature::make(1, 1, sizeof(gr_complex))),
+    _dc(0, 0),
+    _w(0, 0),
+    _dc_corr(0, 0),
+    _stage(NULL),
+    _stage_items(0)
+{
+}
+
+iq_correct_cc::~iq_correct_cc()
+{
+  if (_stage)
+    volk_free(_stage);
+}
+
+void iq_correct_cc::set_dc_offset( const std::complex<double> &offset )
+{
+  gr::thread::scoped_lock lock(_lock);
+
+  _dc = gr_complex( offset.real(), offset.imag() );
+  update_correction();
+}
+
+void iq_correct_cc::set_iq_balance( const std::complex<double> &balance )
+{
+  gr::thread::scoped_lock lock(_lock);
+
+  _w = gr_complex( balance.real(), balance.imag() );
+  update_correction();
+}
+
+/* y = x + w * conj(x) - (dc + w * conj(dc)), the constant part only
+ * changes with the coefficients and is folded ahead of time */
+void iq_correct_cc::update_correction( void )
+{
+  _dc_corr = _dc + _w * std::conj(_dc);
+}
+
+int iq_correct_cc::work( int noutput_items,
+                         gr_vector_const_void_star &input_items,
+                         gr_vector_void_star &output_items )
+{
+  const gr_complex *in = (const gr_complex *)input_items[0];
+  gr_complex *out = (gr_complex *)output_items[0];
+
+  gr::thread::scoped_lock lock(_lock);
+
+  if (_w == gr_complex(0, 0)) {
+    if (_dc_corr == gr_complex(0, 0)) {
+      memcpy(out, in, noutput_items * sizeof(gr_complex));
+    } else {
+      for (int i = 0; i < noutput_items; i++)
+        out[i] = in[i] - _dc_corr;
+    }
+
+    return noutput_items;
+  }
+
+  if (_stage_items < noutput_items) {
+    if (_stage)
+      volk_free(_stage);
+    _stage_items = noutput_items;
+    _stage = (gr_complex *)volk_malloc(_stage_items * sizeof(gr_complex),
+                                       volk_get_alignment());
+  }
+
+  volk_32fc_conjugate_32fc(_stage, in, noutput_items);
+  volk_32fc_s32fc_multiply_32fc(_stage, _stage, _w, noutput_items);
+  volk_32f_x2_add_32f((float *)out, (const float *)in,
+                      (const float *)_stage, 2 * noutput_items);
+
+  if (_dc_corr != gr_complex(0, 0))
+    for (int i = 0; i < noutput_items; i++)
+      out[i] -= _dc_corr;
+
+  return noutput_items;
+}
@@ -0,0 +1,69 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2012 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_IQ_CORRECT_CC_H
+#define INCLUDED_IQ_CORRECT_CC_H
+
+#include <gnuradio/sync_block.h>
+#include <gnuradio/thread/thread.h>
+
+class iq_correct_cc;
+
+typedef boost::shared_ptr<iq_correct_cc> iq_correct_cc_sptr;
+
+iq_correct_cc_sptr make_iq_correct_cc();
+
+/*!
+ * \brief Vectorized DC offset and IQ imbalance correction.
+ *
+ * Applies y = x + w * conj(x) - c with volk kernels, where the complex
+ * coefficient w models gain imbalance and quadrature skew and c is the
+ * precomputed DC correction. With both coefficients at zero the block
+ * degrades to a plain copy. The coefficients are manual, they come in
+ * through the set_dc_offset()/set_iq_balance() API of the source.
+ */
+class iq_correct_cc : public gr::sync_block
+{
+private:
+  friend iq_correct_cc_sptr make_iq_correct_cc();
+
+  iq_correct_cc();
+
+public:
+  ~iq_correct_cc();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  void set_dc_offset( const std::complex<double> &offset );
+  void set_iq_balance( const std::complex<double> &balance );
+
+private:
+  void update_correction( void );
+
+  gr::thread::mutex _lock;
+  gr_complex _dc;      /* DC offset to be taken out */
+  gr_complex _w;       /* imbalance coefficient */
+  gr_complex _dc_corr; /* precomputed dc + w * conj(dc) */
+  gr_complex *_stage;  /* volk-aligned staging for w * conj(x) */
+  int _stage_items;
+};
+
+#endif /* INCLUDED_IQ_CORRECT_CC_H */
@@ -34,12 +34,15 @@
 #include <boost/assign.hpp>
 #include <boost/format.hpp>
 
+#include <algorithm>
 #include <stdexcept>
 #include <iostream>
 #include <stdio.h>
 
 #include <mirisdr.h>
 
+#include <volk/volk.h>
+
 #include "arg_helpers.h"
 
 using namespace boost::assign;
@@ -82,7 +85,9 @@ miri_source_c::miri_source_c (const std::string &args)
   : gr::sync_block ("miri_source_c",
         gr::io_signature::make(MIN_IN, MAX_IN, sizeof (gr_complex)),
         gr::io_signature::make(MIN_OUT, MAX_OUT, sizeof (gr_complex))),
+    _ring(NULL),
     _running(true),
+    _gated(false),
     _auto_gain(false),
     _skipped(0)
 {
@@ -94,8 +99,8 @@ miri_source_c::miri_source_c (const std::string &args)
   if (dict.count("miri"))
     dev_index = boost::lexical_cast< unsigned int >( dict["miri"] );
 
-  _buf_num = _buf_head = _buf_used = _buf_offset = 0;
-  _samp_avail = BUF_SIZE / BYTES_PER_SAMPLE;
+  _buf_num = _buf_offset = 0;
+  _samp_avail = 0; /* determined from the first buffer length in work() */
 
   if (dict.count("buffers"))
     _buf_num = boost::lexical_cast< unsigned int >( dict["buffers"] );
@@ -108,6 +113,18 @@ miri_source_c::miri_source_c (const std::string &args)
               << std::endl;
   }
 
+  /* watermark= is the consumer low-watermark: work() waits until this
+   * many buffers are filled before producing. 1 minimizes the added
+   * latency, higher values ride out scheduling jitter. */
+  _watermark = 3;
+  if (dict.count("watermark"))
+    _watermark = boost::lexical_cast< unsigned int >( dict["watermark"] );
+
+  if (_watermark < 1)
+    _watermark = 1;
+  if (_watermark >= _buf_num)
+    _watermark = _buf_num - 1;
+
   if ( dev_index >= mirisdr_get_device_count() )
     throw std::runtime_error("Wrong mirisdr device index given.");
 
@@ -132,15 +149,15 @@ miri_source_c::miri_source_c (const std::string &args)
   if (ret < 0)
     throw std::runtime_error("Failed to reset usb buffers.");
 
-  _buf = (unsigned short **) malloc(_buf_num * sizeof(unsigned short *));
-  _buf_lens = (unsigned int *) malloc(_buf_num * sizeof(unsigned int));
-
-  if (_buf && _buf_lens) {
-    for(unsigned int i = 0; i < _buf_num; ++i)
-      _buf[i] = (unsigned short *) malloc(BUF_SIZE);
-  }
+  _ring = new ring_buffer(_buf_num, BUF_SIZE);
 
   _thread = gr::thread::thread(_mirisdr_wait, this);
+
+  /* Set up constraints: produce in aligned full SIMD widths so the
+   * conversion kernels never have to run a scalar tail */
+  int const alignment_multiple = volk_get_alignment() / sizeof(gr_complex);
+  set_alignment(std::max(1, alignment_multiple));
+  set_output_multiple(std::max(1, alignment_multiple));
 }
 
 /*
@@ -156,15 +173,9 @@ miri_source_c::~miri_source_c ()
     _dev = NULL;
   }
 
-  if (_buf) {
-    for(unsigned int i = 0; i < _buf_num; ++i) {
-      free(_buf[i]);
-    }
-
-    free(_buf);
-    _buf = NULL;
-    free(_buf_lens);
-    _buf_lens = NULL;
+  if (_ring) {
+    delete _ring;
+    _ring = NULL;
   }
 }
 
@@ -176,30 +187,23 @@ void miri_source_c::_mirisdr_callback(unsigned char *buf, uint32_t len, void *ct
 
 void miri_source_c::mirisdr_callback(unsigned char *buf, uint32_t len)
 {
+  if (_gated) /* armed by start_synchronized(), drop the transfer */
+    return;
+
   if (_skipped < BUF_SKIP) {
     _skipped++;
     return;
   }
 
-  {
-    boost::mutex::scoped_lock lock( _buf_mutex );
+  if (len > BUF_SIZE)
+    throw std::runtime_error("Buffer too small.");
 
-    if (len > BUF_SIZE)
-      throw std::runtime_error("Buffer too small.");
-
-    int buf_tail = (_buf_head + _buf_used) % _buf_num;
-    memcpy(_buf[buf_tail], buf, len);
-    _buf_lens[buf_tail] = len;
-
-    if (_buf_used == _buf_num) {
-      std::cerr << "O" << std::flush;
-      _buf_head = (_buf_head + 1) % _buf_num;
-    } else {
-      _buf_used++;
-    }
-  }
+  _ring->write(buf, len); /* drops the transfer on overrun */
+}
 
-  _buf_cond.notify_one();
+void miri_source_c::gate_stream( bool gated )
+{
+  _gated = gated;
 }
 
 void miri_source_c::_mirisdr_wait(miri_source_c *obj)
@@ -216,7 +220,7 @@ void miri_source_c::mirisdr_wait()
   if ( ret != 0 )
     std::cerr << "mirisdr_read_async returned with " << ret << std::endl;
 
-  _buf_cond.notify_one();
+  _ring->notify();
 }
 
 int miri_source_c::work( int noutput_items,
@@ -225,47 +229,65 @@ int miri_source_c::work( int noutput_items,
 {
   gr_complex *out = (gr_complex *)output_items[0];
 
-  {
-    boost::mutex::scoped_lock lock( _buf_mutex );
-
-    while (_buf_used < 3 && _running) // collect at least 3 buffers
-      _buf_cond.wait( lock );
-  }
+  _ring->wait_for(_watermark, _running); // collect the configured low-watermark
 
   if (!_running)
     return WORK_DONE;
 
-  short *buf = (short *)_buf[_buf_head] + _buf_offset;
+  if (0 == _samp_avail) { /* fresh buffer at the head, pick up its length */
+    unsigned int buf_len = 0;
+    _ring->read_ptr( &buf_len );
+    _samp_avail = buf_len / BYTES_PER_SAMPLE;
+    _buf_offset = 0;
+  }
 
+  short *buf = (short *)_ring->read_ptr() + _buf_offset;
+
+  /* the 12 bit samples arrive as int16 IQ pairs, so the whole chunk
+   * inflates to float with a single volk call; the dispatcher picks
+   * the SIMD (SSE/NEON) version suited to the machine at runtime */
   if (noutput_items <= _samp_avail) {
-    for (int i = 0; i < noutput_items; i++)
-      *out++ = gr_complex( float(*(buf + i * 2 + 0)) * (1.0f/4096.0f),
-                           float(*(buf + i * 2 + 1)) * (1.0f/4096.0f) );
+    volk_16i_s32f_convert_32f( (float *)out, buf, 4096.0f,
+                               noutput_items * 2 );
+    out += noutput_items;
 
     _buf_offset += noutput_items * 2;
     _samp_avail -= noutput_items;
+
+    if (0 == _samp_avail) { /* drained the slot exactly, hand it back */
+      _ring->read_done();
+      _buf_offset = 0;
+    }
   } else {
-    for (int i = 0; i < _samp_avail; i++)
-      *out++ = gr_complex( float(*(buf + i * 2 + 0)) * (1.0f/4096.0f),
-                           float(*(buf + i * 2 + 1)) * (1.0f/4096.0f) );
+    volk_16i_s32f_convert_32f( (float *)out, buf, 4096.0f,
+                               _samp_avail * 2 );
+    out += _samp_avail;
 
-    {
-      boost::mutex::scoped_lock lock( _buf_mutex );
+    int remaining = noutput_items - _samp_avail;
+    unsigned int buf_len = 0;
 
-      _buf_head = (_buf_head + 1) % _buf_num;
-      _buf_used--;
-    }
+    _ring->read_done();
 
-    buf = (short *)_buf[_buf_head];
+    buf = (short *)_ring->read_ptr( &buf_len );
 
-    int remaining = noutput_items - _samp_avail;
+    if (!buf) { /* ring ran empty, deliver the partial chunk */
+      noutput_items -= remaining;
+      _buf_offset = 0;
+      _samp_avail = 0;
+      return noutput_items;
+    }
 
-    for (int i = 0; i < remaining; i++)
-      *out++ = gr_complex( float(*(buf + i * 2 + 0)) * (1.0f/4096.0f),
-                           float(*(buf + i * 2 + 1)) * (1.0f/4096.0f) );
+    volk_16i_s32f_convert_32f( (float *)out, buf, 4096.0f,
+                               remaining * 2 );
+    out += remaining;
 
     _buf_offset = remaining * 2;
-    _samp_avail = (_buf_lens[_buf_head] / BYTES_PER_SAMPLE) - remaining;
+    _samp_avail = (buf_len / BYTES_PER_SAMPLE) - remaining;
+
+    if (0 == _samp_avail) { /* drained the slot exactly, hand it back */
+      _ring->read_done();
+      _buf_offset = 0;
+    }
   }
 
   return noutput_items;
@@ -289,6 +311,21 @@ size_t miri_source_c::get_num_channels()
   return 1;
 }
 
+uint64_t miri_source_c::get_num_overflows()
+{
+  return _ring->num_overruns();
+}
+
+void miri_source_c::reset_stream_stats()
+{
+  _ring->reset_overruns();
+}
+
+double miri_source_c::get_buffer_level()
+{
+  return _ring->used() / (double)_ring->buf_num();
+}
+
 osmosdr::meta_range_t miri_source_c::get_sample_rates()
 {
   osmosdr::meta_range_t range;
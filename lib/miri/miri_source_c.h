@@ -23,10 +23,9 @@
 #include <gnuradio/sync_block.h>
 
 #include <gnuradio/thread/thread.h>
-#include <boost/thread/mutex.hpp>
-#include <boost/thread/condition_variable.hpp>
 
 #include "source_iface.h"
+#include "ring_buffer.h"
 
 class miri_source_c;
 typedef struct mirisdr_dev mirisdr_dev_t;
@@ -83,6 +82,11 @@ private:
 
   size_t get_num_channels( void );
 
+  uint64_t get_num_overflows( void );
+  void reset_stream_stats( void );
+  double get_buffer_level( void );
+  void gate_stream( bool gated );
+
   osmosdr::meta_range_t get_sample_rates( void );
   double set_sample_rate( double rate );
   double get_sample_rate( void );
@@ -115,14 +119,11 @@ private:
 
   mirisdr_dev_t *_dev;
   gr::thread::thread _thread;
-  unsigned short **_buf;
-  unsigned int *_buf_lens;
+  ring_buffer *_ring;
   unsigned int _buf_num;
-  unsigned int _buf_head;
-  unsigned int _buf_used;
-  boost::mutex _buf_mutex;
-  boost::condition_variable _buf_cond;
+  unsigned int _watermark; /* buffers work() waits for, watermark= arg */
   bool _running;
+  bool _gated; /* armed by start_synchronized(), callback drops transfers */
 
   unsigned int _buf_offset;
   int _samp_avail;
@@ -67,8 +67,9 @@ osmosdr_src_c::osmosdr_src_c (const std::string &args)
         gr::io_signature::make(0, 0, sizeof (gr_complex)),
         gr::io_signature::make(1, 1, sizeof (gr_complex)) ),
     _dev(NULL),
-    _buf(NULL),
+    _ring(NULL),
     _running(true),
+    _gated(false),
     _auto_gain(false),
     _if_gain(0),
     _skipped(0)
@@ -81,7 +82,7 @@ osmosdr_src_c::osmosdr_src_c (const std::string &args)
   if (dict.count("osmosdr"))
     dev_index = boost::lexical_cast< unsigned int >( dict["osmosdr"] );
 
-  _buf_num = _buf_len = _buf_head = _buf_used = _buf_offset = 0;
+  _buf_num = _buf_len = _buf_offset = 0;
 
   if (dict.count("buffers"))
     _buf_num = boost::lexical_cast< unsigned int >( dict["buffers"] );
@@ -95,11 +96,38 @@ osmosdr_src_c::osmosdr_src_c (const std::string &args)
   if (0 == _buf_len || _buf_len % 512 != 0) /* len must be multiple of 512 */
     _buf_len = BUF_LEN;
 
+  /* buffer_ms= sizes the transfers for the wanted amount of buffering;
+   * the transfer geometry is handed to the async reader once below, so
+   * only the 500 kSps rate configured here can be honored */
+  if (dict.count("buffer_ms") && 0 == dict.count("buflen")) {
+    double buffer_ms = boost::lexical_cast< double >( dict["buffer_ms"] );
+
+    if ( buffer_ms > 0.0 ) {
+      _buf_len = ring_buffer::len_for_ms( 500000.0 * BYTES_PER_SAMPLE,
+                                          buffer_ms, _buf_num, 512 );
+
+      if ( _buf_len < 8 * 512 ) /* keep transfers efficient on the bus */
+        _buf_len = 8 * 512;
+    }
+  }
+
   if ( BUF_NUM != _buf_num || BUF_LEN != _buf_len ) {
     std::cerr << "Using " << _buf_num << " buffers of size " << _buf_len << "."
               << std::endl;
   }
 
+  /* watermark= is the consumer low-watermark: work() waits until this
+   * many buffers are filled before producing. 1 minimizes the added
+   * latency, higher values ride out scheduling jitter. */
+  _watermark = 3;
+  if (dict.count("watermark"))
+    _watermark = boost::lexical_cast< unsigned int >( dict["watermark"] );
+
+  if (_watermark < 1)
+    _watermark = 1;
+  if (_watermark >= _buf_num)
+    _watermark = _buf_num - 1;
+
   _samp_avail = _buf_len / BYTES_PER_SAMPLE;
 
   if ( dev_index >= osmosdr_get_device_count() )
@@ -132,12 +160,17 @@ osmosdr_src_c::osmosdr_src_c (const std::string &args)
 
   set_if_gain( 24 ); /* preset to a reasonable default (non-GRC use case) */
 
-  _buf = (unsigned short **) malloc(_buf_num * sizeof(unsigned short *));
+  alloc_policy policy;
+  if ( dict.count("hugepages") )
+    policy.hugepages = boost::lexical_cast<bool>( dict["hugepages"] );
+  if ( dict.count("numa_node") )
+    policy.numa_node = boost::lexical_cast<int>( dict["numa_node"] );
 
-  if (_buf) {
-    for(unsigned int i = 0; i < _buf_num; ++i)
-      _buf[i] = (unsigned short *) malloc(_buf_len);
-  }
+  _ring = new ring_buffer(_buf_num, _buf_len, 0, policy);
+
+  if ( dict.count("overflow") )
+    _ring->set_overflow_policy(
+          ring_buffer::policy_from_string( dict["overflow"] ) );
 
   _thread = gr::thread::thread(_osmosdr_wait, this);
 }
@@ -155,13 +188,9 @@ osmosdr_src_c::~osmosdr_src_c ()
     _dev = NULL;
   }
 
-  if (_buf) {
-    for(unsigned int i = 0; i < _buf_num; ++i) {
-      free(_buf[i]);
-    }
-
-    free(_buf);
-    _buf = NULL;
+  if (_ring) {
+    delete _ring;
+    _ring = NULL;
   }
 }
 
@@ -173,26 +202,20 @@ void osmosdr_src_c::_osmosdr_callback(unsigned char *buf, uint32_t len, void *ct
 
 void osmosdr_src_c::osmosdr_callback(unsigned char *buf, uint32_t len)
 {
+  if (_gated) /* armed by start_synchronized(), drop the transfer */
+    return;
+
   if (_skipped < BUF_SKIP) {
     _skipped++;
     return;
   }
 
-  {
-    boost::mutex::scoped_lock lock( _buf_mutex );
-
-    int buf_tail = (_buf_head + _buf_used) % _buf_num;
-    memcpy(_buf[buf_tail], buf, len);
-
-    if (_buf_used == _buf_num) {
-      std::cerr << "O" << std::flush;
-      _buf_head = (_buf_head + 1) % _buf_num;
-    } else {
-      _buf_used++;
-    }
-  }
+  _ring->write(buf, len); /* drops the transfer on overrun */
+}
 
-  _buf_cond.notify_one();
+void osmosdr_src_c::gate_stream( bool gated )
+{
+  _gated = gated;
 }
 
 void osmosdr_src_c::_osmosdr_wait(osmosdr_src_c *obj)
@@ -209,7 +232,7 @@ void osmosdr_src_c::osmosdr_wait()
   if ( ret != 0 )
     std::cerr << "osmosdr_read_async returned with " << ret << std::endl;
 
-  _buf_cond.notify_one();
+  _ring->notify();
 }
 
 int osmosdr_src_c::work( int noutput_items,
@@ -218,44 +241,36 @@ int osmosdr_src_c::work( int noutput_items,
 {
   gr_complex *out = (gr_complex *)output_items[0];
 
-  {
-    boost::mutex::scoped_lock lock( _buf_mutex );
-
-    while (_buf_used < 3 && _running) // collect at least 3 buffers
-      _buf_cond.wait( lock );
-  }
+  _ring->wait_for(_watermark, _running); // collect the configured low-watermark
 
   if (!_running)
     return WORK_DONE;
 
-  short *buf = (short *)_buf[_buf_head] + _buf_offset;
+  short *buf = (short *)_ring->read_ptr() + _buf_offset;
 
   if (noutput_items <= _samp_avail) {
-    for (int i = 0; i < noutput_items; i++)
-       *out++ = gr_complex( float(*(buf + i * 2 + 0)) * (1.0f/32767.5f),
-                            float(*(buf + i * 2 + 1)) * (1.0f/32767.5f) );
+    _converter.s16_fc32(out, buf, noutput_items, 32767.5f);
 
     _buf_offset += noutput_items * 2;
     _samp_avail -= noutput_items;
   } else {
-    for (int i = 0; i < _samp_avail; i++)
-      *out++ = gr_complex( float(*(buf + i * 2 + 0)) * (1.0f/32767.5f),
-                           float(*(buf + i * 2 + 1)) * (1.0f/32767.5f) );
+    _converter.s16_fc32(out, buf, _samp_avail, 32767.5f);
+    out += _samp_avail;
 
-    {
-      boost::mutex::scoped_lock lock( _buf_mutex );
+    int remaining = noutput_items - _samp_avail;
 
-      _buf_head = (_buf_head + 1) % _buf_num;
-      _buf_used--;
-    }
+    _ring->read_done();
 
-    buf = (short *)_buf[_buf_head];
+    buf = (short *)_ring->read_ptr();
 
-    int remaining = noutput_items - _samp_avail;
+    if (!buf) { /* ring ran empty, deliver the partial chunk */
+      noutput_items -= remaining;
+      _buf_offset = 0;
+      _samp_avail = _buf_len / BYTES_PER_SAMPLE;
+      return noutput_items;
+    }
 
-    for (int i = 0; i < remaining; i++)
-      *out++ = gr_complex( float(*(buf + i * 2 + 0)) * (1.0f/32767.5f),
-                           float(*(buf + i * 2 + 1)) * (1.0f/32767.5f) );
+    _converter.s16_fc32(out, buf, remaining, 32767.5f);
 
     _buf_offset = remaining * 2;
     _samp_avail = (_buf_len / BYTES_PER_SAMPLE) - remaining;
@@ -294,6 +309,21 @@ size_t osmosdr_src_c::get_num_channels()
   return 1;
 }
 
+uint64_t osmosdr_src_c::get_num_overflows()
+{
+  return _ring->num_overruns();
+}
+
+void osmosdr_src_c::reset_stream_stats()
+{
+  _ring->reset_overruns();
+}
+
+double osmosdr_src_c::get_buffer_level()
+{
+  return _ring->used() / (double)_ring->buf_num();
+}
+
 osmosdr::meta_range_t osmosdr_src_c::get_sample_rates()
 {
   osmosdr::meta_range_t range;
@@ -23,10 +23,10 @@
 #include <gnuradio/sync_block.h>
 
 #include <gnuradio/thread/thread.h>
-#include <boost/thread/mutex.hpp>
-#include <boost/thread/condition_variable.hpp>
 
 #include "source_iface.h"
+#include "ring_buffer.h"
+#include "converter.h"
 
 class osmosdr_src_c;
 typedef struct osmosdr_dev osmosdr_dev_t;
@@ -85,6 +85,11 @@ private:
 
   size_t get_num_channels( void );
 
+  uint64_t get_num_overflows( void );
+  void reset_stream_stats( void );
+  double get_buffer_level( void );
+  void gate_stream( bool gated );
+
   osmosdr::meta_range_t get_sample_rates( void );
   double set_sample_rate( double rate );
   double get_sample_rate( void );
@@ -119,14 +124,13 @@ private:
 
   osmosdr_dev_t *_dev;
   gr::thread::thread _thread;
-  unsigned short **_buf;
+  ring_buffer *_ring;
+  sample_converter _converter;
   unsigned int _buf_num;
   unsigned int _buf_len;
-  unsigned int _buf_head;
-  unsigned int _buf_used;
-  boost::mutex _buf_mutex;
-  boost::condition_variable _buf_cond;
+  unsigned int _watermark; /* buffers work() waits for, watermark= arg */
   bool _running;
+  bool _gated; /* armed by start_synchronized(), callback drops transfers */
 
   unsigned int _buf_offset;
   int _samp_avail;
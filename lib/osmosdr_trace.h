@@ -0,0 +1,49 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_TRACE_H
+#define OSMOSDR_TRACE_H
+
+/*
+ * Static userspace tracepoints (USDT) under the "gr_osmosdr" provider,
+ * placed at the producer/consumer boundaries of the streaming paths.
+ * Each probe compiles to a single nop when no tracer is attached, so
+ * they may sit on the per-transfer hot path of a production flowgraph;
+ * perf or bpftrace can then reconstruct buffer timing live:
+ *
+ *   perf buildid-cache -a libgnuradio-osmosdr.so
+ *   perf probe sdt_gr_osmosdr:ring_overrun
+ *   perf record -e sdt_gr_osmosdr:ring_overrun ...
+ *
+ * Without sys/sdt.h (systemtap-sdt-dev) the probes compile away
+ * entirely.
+ */
+
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+#define OSMOSDR_TRACE(probe)         DTRACE_PROBE(gr_osmosdr, probe)
+#define OSMOSDR_TRACE1(probe, a)     DTRACE_PROBE1(gr_osmosdr, probe, a)
+#define OSMOSDR_TRACE2(probe, a, b)  DTRACE_PROBE2(gr_osmosdr, probe, a, b)
+#else
+#define OSMOSDR_TRACE(probe)
+#define OSMOSDR_TRACE1(probe, a)
+#define OSMOSDR_TRACE2(probe, a, b)
+#endif
+
+#endif /* OSMOSDR_TRACE_H */
@@ -0,0 +1,116 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_PAGE_ALLOC_H
+#define OSMOSDR_PAGE_ALLOC_H
+
+#include <cstddef>
+#include <iostream>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/*!
+ * Allocation policy for the streaming buffers, parsed from the
+ * hugepages=1 and numa_node=N device arguments. Huge pages take the
+ * TLB pressure out of the sample path on large rings, the node binding
+ * keeps the buffers local to the socket servicing the device's USB
+ * controller. Both are Linux only and need privileges/reserved pages,
+ * so everything degrades to the regular allocator when unavailable.
+ */
+struct alloc_policy
+{
+  bool hugepages; /* back the buffers with 2 MB pages */
+  int numa_node;  /* bind to this node, -1 keeps the system default */
+
+  alloc_policy() : hugepages(false), numa_node(-1) {}
+
+  bool is_default() const { return !hugepages && numa_node < 0; }
+};
+
+#define PAGE_ALLOC_HUGE_SIZE (2UL * 1024 * 1024)
+
+/*!
+ * Map an anonymous region according to the policy. \p len is rounded
+ * up as required and updated, pass the rounded value to page_free().
+ * Returns NULL when the platform or the policy cannot be served, the
+ * caller falls back to its regular allocator then.
+ */
+static inline void *page_alloc( size_t &len, const alloc_policy &policy )
+{
+#ifdef __linux__
+  size_t size = len;
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+  if (policy.hugepages) {
+    size = (size + PAGE_ALLOC_HUGE_SIZE - 1) & ~(PAGE_ALLOC_HUGE_SIZE - 1);
+#ifdef MAP_HUGETLB
+    flags |= MAP_HUGETLB;
+#endif
+  }
+
+  void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+
+  if (MAP_FAILED == p && policy.hugepages) {
+    /* no huge pages reserved, take normal ones rather than failing */
+    std::cerr << "Failed to allocate huge pages, using normal pages."
+              << std::endl;
+
+    size = len;
+    p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  }
+
+  if (MAP_FAILED == p)
+    return NULL;
+
+  if (policy.numa_node >= 0) {
+    unsigned long nodemask = 1UL << policy.numa_node;
+
+    /* MPOL_BIND without dragging in libnuma, the pages get faulted in
+     * on the bound node no matter which thread touches them first */
+    if (syscall(SYS_mbind, p, size, 2 /* MPOL_BIND */, &nodemask,
+                sizeof(nodemask) * 8, 0) < 0)
+      std::cerr << "Failed to bind buffers to NUMA node "
+                << policy.numa_node << "." << std::endl;
+  }
+
+  len = size;
+  return p;
+#else
+  (void)len;
+  (void)policy;
+  return NULL;
+#endif
+}
+
+static inline void page_free( void *p, size_t len )
+{
+#ifdef __linux__
+  munmap(p, len);
+#else
+  (void)p;
+  (void)len;
+#endif
+}
+
+#endif /* OSMOSDR_PAGE_ALLOC_H */
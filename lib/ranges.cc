@@ -87,6 +87,63 @@ void check_meta_range_monotonic(const meta_range_t &mr){
     }
 }
 
+struct meta_range_t::index{
+    index(void): size(0), first_start(0), last_stop(0),
+                 start(0), stop(0), step(0), values_valid(false)
+    {
+        /* NOP */
+    }
+
+    //fingerprint of the ranges the index was built for
+    size_t size;
+    double first_start, last_stop;
+
+    //cached aggregates
+    double start, stop, step;
+
+    //lazily enumerated values, only built when values() is called
+    bool values_valid;
+    std::vector<double> values;
+};
+
+meta_range_t::index &meta_range_t::fetch_index(void) const{
+    if (_index && ! this->empty() && _index->size == this->size() &&
+        _index->first_start == this->front().start() &&
+        _index->last_stop == this->back().stop()){
+        return *_index;
+    }
+
+    check_meta_range_monotonic(*this);
+
+    boost::shared_ptr<index> idx = OSMOSDR_PIMPL_MAKE(index, ());
+    idx->size = this->size();
+    idx->first_start = this->front().start();
+    idx->last_stop = this->back().stop();
+
+    //the ranges are monotonic, the bounds are at the ends
+    idx->start = this->front().start();
+    idx->stop = this->back().stop();
+
+    std::vector<double> non_zero_steps;
+    range_t last = this->front();
+    BOOST_FOREACH(const range_t &r, (*this)){
+        //steps at each range
+        if (r.step() > 0) non_zero_steps.push_back(r.step());
+        //and steps in-between ranges
+        double ibtw_step = r.start() - last.stop();
+        if (ibtw_step > 0) non_zero_steps.push_back(ibtw_step);
+        //store ref to last
+        last = r;
+    }
+    if (non_zero_steps.empty()) idx->step = 0; //all zero steps, its zero...
+    else idx->step = *std::min_element(non_zero_steps.begin(), non_zero_steps.end());
+
+    //replace instead of modify, copies fingerprinted against the old
+    //contents may still hold a reference to the previous index
+    _index = idx;
+    return *_index;
+}
+
 meta_range_t::meta_range_t(void){
     /* NOP */
 }
@@ -100,79 +157,68 @@ meta_range_t::meta_range_t(
 }
 
 double meta_range_t::start(void) const{
-    check_meta_range_monotonic(*this);
-    double min_start = this->front().start();
-    BOOST_FOREACH(const range_t &r, (*this)){
-        min_start = std::min(min_start, r.start());
-    }
-    return min_start;
+    return this->fetch_index().start;
 }
 
 double meta_range_t::stop(void) const{
-    check_meta_range_monotonic(*this);
-    double max_stop = this->front().stop();
-    BOOST_FOREACH(const range_t &r, (*this)){
-        max_stop = std::max(max_stop, r.stop());
-    }
-    return max_stop;
+    return this->fetch_index().stop;
 }
 
 double meta_range_t::step(void) const{
-    check_meta_range_monotonic(*this);
-    std::vector<double> non_zero_steps;
-    range_t last = this->front();
-    BOOST_FOREACH(const range_t &r, (*this)){
-        //steps at each range
-        if (r.step() > 0) non_zero_steps.push_back(r.step());
-        //and steps in-between ranges
-        double ibtw_step = r.start() - last.stop();
-        if (ibtw_step > 0) non_zero_steps.push_back(ibtw_step);
-        //store ref to last
-        last = r;
-    }
-    if (non_zero_steps.empty()) return 0; //all zero steps, its zero...
-    return *std::min_element(non_zero_steps.begin(), non_zero_steps.end());
+    return this->fetch_index().step;
+}
+
+static bool range_stop_below(const range_t &r, double value){
+    return r.stop() < value;
 }
 
 double meta_range_t::clip(double value, bool clip_step) const{
-    check_meta_range_monotonic(*this);
-    double last_stop = this->front().stop();
-    BOOST_FOREACH(const range_t &r, (*this)){
-        //in-between ranges, clip to nearest
-        if (value < r.start()){
-            return (std::abs(value - r.start()) < std::abs(value - last_stop))?
-                r.start() : last_stop;
-        }
-        //in this range, clip here
-        if (value <= r.stop()){
-            if (! clip_step || r.step() == 0) return value;
-            return boost::math::round((value - r.start())/r.step())*r.step() + r.start();
-        }
-        //continue on to the next range
-        last_stop = r.stop();
+    this->fetch_index(); //ensures the ranges are monotonic
+
+    //first range that ends at or above the value
+    const_iterator it = std::lower_bound(
+        this->begin(), this->end(), value, range_stop_below);
+
+    //beyond the last range, clip to the overall stop
+    if (it == this->end()) return this->back().stop();
+
+    const range_t &r = *it;
+
+    //in-between ranges, clip to nearest
+    if (value < r.start()){
+        double last_stop = (it == this->begin()) ? r.start() : (it - 1)->stop();
+        return (std::abs(value - r.start()) < std::abs(value - last_stop))?
+            r.start() : last_stop;
     }
-    return last_stop;
+
+    //in this range, clip here
+    if (! clip_step || r.step() == 0) return value;
+    return boost::math::round((value - r.start())/r.step())*r.step() + r.start();
 }
 
 std::vector<double> meta_range_t::values() const {
-    std::vector<double> values;
-
-    BOOST_FOREACH(const range_t &r, (*this)) {
-        if (r.start() != r.stop()) {
-            if ( r.step() == 0 ) {
-                values.push_back( r.start() );
-                values.push_back( r.stop() );
-            } else {
-                for ( double val = r.start(); val <= r.stop(); val += r.step() ) {
-                    values.push_back( val );
+    index &idx = this->fetch_index();
+
+    if (! idx.values_valid) {
+        BOOST_FOREACH(const range_t &r, (*this)) {
+            if (r.start() != r.stop()) {
+                if ( r.step() == 0 ) {
+                    idx.values.push_back( r.start() );
+                    idx.values.push_back( r.stop() );
+                } else {
+                    for ( double val = r.start(); val <= r.stop(); val += r.step() ) {
+                        idx.values.push_back( val );
+                    }
                 }
+            } else {
+                idx.values.push_back( r.start() );
             }
-        } else {
-            values.push_back( r.start() );
         }
+
+        idx.values_valid = true;
     }
 
-    return values;
+    return idx.values;
 }
 
 const std::string meta_range_t::to_pp_string(void) const{
@@ -23,6 +23,12 @@
 #include <string>
 #include <sstream>
 #include <stdexcept>
+#include <algorithm>
+#include <iostream>
+
+#if !defined(_WIN32)
+#include <sys/uio.h>
+#endif
 
 #include <boost/assign.hpp>
 #include <boost/format.hpp>
@@ -41,10 +47,30 @@ redpitaya_sink_c_sptr make_redpitaya_sink_c(const std::string &args)
   return gnuradio::get_initial_sptr(new redpitaya_sink_c(args));
 }
 
+#define BUF_NUM 32
+#define BUF_LEN (16384 * sizeof(gr_complex))
+
+/* upper bound on the slots gathered into a single submission */
+#define FLUSH_IOV_MAX 16
+
+/* scatter/gather entries differ in layout between the platforms */
+#if defined(_WIN32)
+#define IOV_BASE(x) (x).buf
+#define IOV_LEN(x)  (x).len
+#else
+#define IOV_BASE(x) (x).iov_base
+#define IOV_LEN(x)  (x).iov_len
+#endif
+
 redpitaya_sink_c::redpitaya_sink_c(const std::string &args) :
   gr::sync_block("redpitaya_sink_c",
                  gr::io_signature::make(1, 1, sizeof(gr_complex)),
-                 gr::io_signature::make(0, 0, 0))
+                 gr::io_signature::make(0, 0, 0)),
+  _ring(NULL),
+  _running(false),
+  _buf_num(0),
+  _buf_len(0),
+  _buf_offset(0)
 {
   std::string host = "192.168.1.100";
   std::stringstream message;
@@ -84,6 +110,18 @@ redpitaya_sink_c::redpitaya_sink_c(const std::string &args) :
   if ( 0 == port )
     port = 1001;
 
+  if ( dict.count( "buffers" ) )
+    _buf_num = boost::lexical_cast< unsigned int >( dict["buffers"] );
+
+  if ( dict.count( "buflen" ) )
+    _buf_len = boost::lexical_cast< unsigned int >( dict["buflen"] );
+
+  if ( 0 == _buf_num )
+    _buf_num = BUF_NUM;
+
+  if ( 0 == _buf_len || _buf_len % sizeof(gr_complex) != 0 )
+    _buf_len = BUF_LEN;
+
   for ( size_t i = 0; i < 2; ++i )
   {
     if ( ( _sockets[i] = socket( AF_INET, SOCK_STREAM, 0 ) ) < 0 )
@@ -108,10 +146,20 @@ redpitaya_sink_c::redpitaya_sink_c(const std::string &args) :
 
   command = ptt ? 2<<28 : 3<<28;
   redpitaya_send_command( _sockets[0], command );
+
+  /* keep the pipe full while gathered submissions are in flight */
+  int sndbuf = 2 * _buf_num * _buf_len;
+  setsockopt( _sockets[1], SOL_SOCKET, SO_SNDBUF,
+              (const char *)&sndbuf, sizeof(sndbuf) );
+
+  _ring = new ring_buffer( _buf_num, _buf_len );
 }
 
 redpitaya_sink_c::~redpitaya_sink_c()
 {
+  if ( _running )
+    stop();
+
 #if defined(_WIN32)
   ::closesocket( _sockets[1] );
   ::closesocket( _sockets[0] );
@@ -120,26 +168,159 @@ redpitaya_sink_c::~redpitaya_sink_c()
   ::close( _sockets[1] );
   ::close( _sockets[0] );
 #endif
+
+  delete _ring;
 }
 
-int redpitaya_sink_c::work( int noutput_items,
-                            gr_vector_const_void_star &input_items,
-                            gr_vector_void_star &output_items )
+bool redpitaya_sink_c::start()
 {
-  const gr_complex *in = (const gr_complex *)input_items[0];
+  _running = true;
+  _buf_offset = 0;
+  _thread = gr::thread::thread( _redpitaya_flush, this );
+
+  return true;
+}
+
+bool redpitaya_sink_c::stop()
+{
+  /* work() no longer runs at this point, hand the staged remainder to
+   * the flusher so it goes out before the thread winds down */
+  if ( _buf_offset && _ring->used() < _ring->buf_num() )
+  {
+    _ring->write_done( _buf_offset );
+    _buf_offset = 0;
+  }
+
+  _running = false;
+  _ring->notify();
+
+  if ( _thread.joinable() )
+    _thread.join();
+
+  return true;
+}
+
+void redpitaya_sink_c::_redpitaya_flush(redpitaya_sink_c *obj)
+{
+  obj->redpitaya_flush();
+}
+
+void redpitaya_sink_c::redpitaya_flush()
+{
+  /* drain what work() queued up before winding down */
+  while ( _running || _ring->used() )
+  {
+    _ring->wait_for( 1, _running );
 
 #if defined(_WIN32)
-  int size;
-  int total = sizeof(gr_complex) * noutput_items;
-  size = ::send( _sockets[1], (char *)in, total, 0 );
+    WSABUF iov[FLUSH_IOV_MAX];
 #else
-  ssize_t size;
-  ssize_t total = sizeof(gr_complex) * noutput_items;
-  size = ::send( _sockets[1], in, total, MSG_NOSIGNAL );
+    struct iovec iov[FLUSH_IOV_MAX];
 #endif
+    unsigned int count = 0;
+    size_t total = 0;
+
+    while ( count < FLUSH_IOV_MAX )
+    {
+      unsigned int len = 0;
+      void *buf = _ring->peek_ptr( count, &len );
 
-  if ( size != total )
-    throw std::runtime_error( "Sending samples failed." );
+      if ( !buf )
+        break;
+
+      IOV_BASE(iov[count]) = (char *)buf;
+      IOV_LEN(iov[count]) = len;
+      total += len;
+      count++;
+    }
+
+    if ( !count )
+      continue;
+
+    /* one gathered submission for the whole backlog, independent of the
+     * chunk sizes the scheduler handed to work() */
+    size_t sent = 0;
+    unsigned int first = 0;
+
+    while ( sent < total )
+    {
+#if defined(_WIN32)
+      DWORD n = 0;
+      if ( WSASend( _sockets[1], &iov[first], count - first, &n,
+                    0, NULL, NULL ) != 0 )
+        n = 0;
+#else
+      struct msghdr msg;
+      memset( &msg, 0, sizeof(msg) );
+      msg.msg_iov = &iov[first];
+      msg.msg_iovlen = count - first;
+
+      ssize_t n = ::sendmsg( _sockets[1], &msg, MSG_NOSIGNAL );
+#endif
+
+      if ( n <= 0 )
+      {
+        if ( _running )
+          std::cerr << "Sending samples failed." << std::endl;
+        _running = false;
+        return;
+      }
+
+      sent += n;
+
+      /* skip past the entries a short write completed */
+      size_t adv = n;
+      while ( first < count && adv >= IOV_LEN(iov[first]) )
+      {
+        adv -= IOV_LEN(iov[first]);
+        first++;
+      }
+      if ( first < count && adv )
+      {
+        IOV_BASE(iov[first]) = (char *)IOV_BASE(iov[first]) + adv;
+        IOV_LEN(iov[first]) -= adv;
+      }
+    }
+
+    for ( unsigned int i = 0; i < count; i++ )
+      _ring->read_done();
+  }
+}
+
+int redpitaya_sink_c::work( int noutput_items,
+                            gr_vector_const_void_star &input_items,
+                            gr_vector_void_star &output_items )
+{
+  const char *in = (const char *)input_items[0];
+  size_t remaining = sizeof(gr_complex) * noutput_items;
+
+  while ( remaining )
+  {
+    /* ring full means the flusher is behind, block until TCP drains */
+    while ( _ring->used() == _ring->buf_num() && _running )
+      boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+
+    if ( !_running )
+      throw std::runtime_error( "Sending samples failed." );
+
+    unsigned char *buf = (unsigned char *)_ring->write_ptr();
+    size_t chunk = std::min( remaining, (size_t)(_buf_len - _buf_offset) );
+
+    memcpy( buf + _buf_offset, in, chunk );
+
+    in += chunk;
+    remaining -= chunk;
+    _buf_offset += chunk;
+
+    /* publish on a full slot; a partial one only when the flusher ran
+     * dry, so small work calls coalesce whenever there is a backlog */
+    if ( _buf_offset == _buf_len ||
+         ( 0 == remaining && 0 == _ring->used() ) )
+    {
+      _ring->write_done( _buf_offset );
+      _buf_offset = 0;
+    }
+  }
 
   consume(0, noutput_items);
 
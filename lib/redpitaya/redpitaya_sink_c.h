@@ -22,8 +22,10 @@
 #define REDPITAYA_SINK_C_H
 
 #include <gnuradio/sync_block.h>
+#include <gnuradio/thread/thread.h>
 
 #include "sink_iface.h"
+#include "ring_buffer.h"
 
 #include "redpitaya_common.h"
 
@@ -45,6 +47,9 @@ private:
 public:
   ~redpitaya_sink_c();
 
+  bool start();
+  bool stop();
+
   int work( int noutput_items,
             gr_vector_const_void_star &input_items,
             gr_vector_void_star &output_items );
@@ -78,8 +83,18 @@ public:
   std::string get_antenna( size_t chan = 0 );
 
 private:
+  static void _redpitaya_flush(redpitaya_sink_c *obj);
+  void redpitaya_flush();
+
   double _freq, _rate, _corr;
   SOCKET _sockets[2];
+
+  gr::thread::thread _thread;
+  ring_buffer *_ring;
+  bool _running;
+  unsigned int _buf_num;
+  unsigned int _buf_len;
+  unsigned int _buf_offset; /* producer fill level of the staging slot */
 };
 
 #endif // REDPITAYA_SINK_C_H
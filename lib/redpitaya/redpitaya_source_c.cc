@@ -23,6 +23,8 @@
 #include <string>
 #include <sstream>
 #include <stdexcept>
+#include <algorithm>
+#include <iostream>
 
 #include <boost/assign.hpp>
 #include <boost/format.hpp>
@@ -41,10 +43,18 @@ redpitaya_source_c_sptr make_redpitaya_source_c(const std::string &args)
   return gnuradio::get_initial_sptr(new redpitaya_source_c(args));
 }
 
+#define BUF_NUM 32
+#define BUF_LEN (16384 * sizeof(gr_complex))
+
 redpitaya_source_c::redpitaya_source_c(const std::string &args) :
   gr::sync_block("redpitaya_source_c",
                  gr::io_signature::make(0, 0, 0),
-                 gr::io_signature::make(1, 1, sizeof(gr_complex)))
+                 gr::io_signature::make(1, 1, sizeof(gr_complex))),
+  _ring(NULL),
+  _running(false),
+  _buf_num(0),
+  _buf_len(0),
+  _buf_offset(0)
 {
   std::string host = "192.168.1.100";
   std::stringstream message;
@@ -81,6 +91,18 @@ redpitaya_source_c::redpitaya_source_c(const std::string &args) :
   if ( 0 == port )
     port = 1001;
 
+  if ( dict.count( "buffers" ) )
+    _buf_num = boost::lexical_cast< unsigned int >( dict["buffers"] );
+
+  if ( dict.count( "buflen" ) )
+    _buf_len = boost::lexical_cast< unsigned int >( dict["buflen"] );
+
+  if ( 0 == _buf_num )
+    _buf_num = BUF_NUM;
+
+  if ( 0 == _buf_len || _buf_len % sizeof(gr_complex) != 0 )
+    _buf_len = BUF_LEN;
+
   for ( size_t i = 0; i < 2; ++i )
   {
     if ( ( _sockets[i] = socket( AF_INET, SOCK_STREAM, 0 ) ) < 0 )
@@ -100,10 +122,21 @@ redpitaya_source_c::redpitaya_source_c(const std::string &args) :
     command = i;
     redpitaya_send_command( _sockets[i], command );
   }
+
+  /* several buffers stay in flight between the server and work(), so
+   * ask the kernel for enough socket buffering to ride out jitter */
+  int rcvbuf = 2 * _buf_num * _buf_len;
+  setsockopt( _sockets[1], SOL_SOCKET, SO_RCVBUF,
+              (const char *)&rcvbuf, sizeof(rcvbuf) );
+
+  _ring = new ring_buffer( _buf_num, _buf_len );
 }
 
 redpitaya_source_c::~redpitaya_source_c()
 {
+  if ( _running )
+    stop();
+
 #if defined(_WIN32)
   ::closesocket( _sockets[1] );
   ::closesocket( _sockets[0] );
@@ -112,6 +145,97 @@ redpitaya_source_c::~redpitaya_source_c()
   ::close( _sockets[1] );
   ::close( _sockets[0] );
 #endif
+
+  delete _ring;
+}
+
+bool redpitaya_source_c::start()
+{
+  _running = true;
+  _buf_offset = 0;
+  _thread = gr::thread::thread( _redpitaya_wait, this );
+
+  return true;
+}
+
+bool redpitaya_source_c::stop()
+{
+  _running = false;
+
+  /* unblock the reader's recv() before joining */
+#if defined(_WIN32)
+  ::shutdown( _sockets[1], SD_BOTH );
+#else
+  ::shutdown( _sockets[1], SHUT_RDWR );
+#endif
+
+  _ring->notify();
+
+  if ( _thread.joinable() )
+    _thread.join();
+
+  return true;
+}
+
+void redpitaya_source_c::_redpitaya_wait(redpitaya_source_c *obj)
+{
+  obj->redpitaya_wait();
+}
+
+void redpitaya_source_c::redpitaya_wait()
+{
+  while ( _running )
+  {
+    unsigned char *buf = (unsigned char *)_ring->write_ptr();
+
+    if ( !buf )
+    {
+      /* the flow graph stalled, wait for a free slot and let TCP flow
+       * control throttle the server in the meantime */
+      boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+      continue;
+    }
+
+#if defined(_WIN32)
+    int received = ::recv( _sockets[1], (char *)buf, _buf_len, 0 );
+#else
+    ssize_t received = ::recv( _sockets[1], buf, _buf_len, 0 );
+#endif
+
+    if ( received <= 0 )
+    {
+      if ( _running )
+        std::cerr << "Receiving samples failed." << std::endl;
+      break;
+    }
+
+    /* top up to a whole sample, a stray remainder would shift the
+     * stream off its I/Q framing */
+    while ( received % sizeof(gr_complex) )
+    {
+      size_t missing = sizeof(gr_complex) - received % sizeof(gr_complex);
+
+#if defined(_WIN32)
+      int r = ::recv( _sockets[1], (char *)buf + received, missing, MSG_WAITALL );
+#else
+      ssize_t r = ::recv( _sockets[1], buf + received, missing, MSG_WAITALL );
+#endif
+
+      if ( r <= 0 )
+      {
+        received -= received % sizeof(gr_complex);
+        break;
+      }
+
+      received += r;
+    }
+
+    if ( received )
+      _ring->write_done( received );
+  }
+
+  _running = false;
+  _ring->notify();
 }
 
 int redpitaya_source_c::work( int noutput_items,
@@ -119,21 +243,54 @@ int redpitaya_source_c::work( int noutput_items,
                               gr_vector_void_star &output_items )
 {
   gr_complex *out = (gr_complex *)output_items[0];
+  int produced = 0;
 
-#if defined(_WIN32)
-  int size;
-  int total = sizeof(gr_complex) * noutput_items;
-  size = ::recv( _sockets[1], (char *)out, total, MSG_WAITALL );
-#else
-  ssize_t size;
-  ssize_t total = sizeof(gr_complex) * noutput_items;
-  size = ::recv( _sockets[1], out, total, MSG_WAITALL );
-#endif
+  /* the reader thread keeps several buffers in flight, link jitter is
+   * absorbed by the ring instead of stalling the flow graph */
+  _ring->wait_for(1, _running);
 
-  if ( size != total )
-    throw std::runtime_error( "Receiving samples failed." );
+  while ( produced < noutput_items )
+  {
+    unsigned int buf_len = 0;
+    unsigned char *buf = (unsigned char *)_ring->read_ptr(&buf_len);
 
-  return noutput_items;
+    if ( !buf ) /* ring ran empty, deliver what we have */
+      break;
+
+    int samp_avail = (buf_len - _buf_offset) / sizeof(gr_complex);
+    int nout = std::min(noutput_items - produced, samp_avail);
+
+    memcpy( &out[produced], buf + _buf_offset, nout * sizeof(gr_complex) );
+
+    produced += nout;
+    _buf_offset += nout * sizeof(gr_complex);
+
+    if ( _buf_offset + sizeof(gr_complex) > buf_len )
+    {
+      _ring->read_done();
+      _buf_offset = 0;
+    }
+  }
+
+  if ( !produced && !_running )
+    return WORK_DONE;
+
+  return produced;
+}
+
+uint64_t redpitaya_source_c::get_num_overflows( void )
+{
+  return _ring->num_overruns();
+}
+
+void redpitaya_source_c::reset_stream_stats( void )
+{
+  _ring->reset_overruns();
+}
+
+double redpitaya_source_c::get_buffer_level( void )
+{
+  return _ring->used() / (double)_ring->buf_num();
 }
 
 std::string redpitaya_source_c::name()
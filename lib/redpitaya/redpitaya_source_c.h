@@ -22,8 +22,10 @@
 #define REDPITAYA_SOURCE_C_H
 
 #include <gnuradio/sync_block.h>
+#include <gnuradio/thread/thread.h>
 
 #include "source_iface.h"
+#include "ring_buffer.h"
 
 #include "redpitaya_common.h"
 
@@ -45,10 +47,17 @@ private:
 public:
   ~redpitaya_source_c();
 
+  bool start();
+  bool stop();
+
   int work( int noutput_items,
             gr_vector_const_void_star &input_items,
             gr_vector_void_star &output_items );
 
+  uint64_t get_num_overflows( void );
+  void reset_stream_stats( void );
+  double get_buffer_level( void );
+
   std::string name();
 
   static std::vector< std::string > get_devices( bool fake = false );
@@ -78,8 +87,18 @@ public:
   std::string get_antenna( size_t chan = 0 );
 
 private:
+  static void _redpitaya_wait(redpitaya_source_c *obj);
+  void redpitaya_wait();
+
   double _freq, _rate, _corr;
   SOCKET _sockets[2];
+
+  gr::thread::thread _thread;
+  ring_buffer *_ring;
+  bool _running;
+  unsigned int _buf_num;
+  unsigned int _buf_len;
+  unsigned int _buf_offset; /* consumer offset into the front slot */
 };
 
 #endif // REDPITAYA_SOURCE_C_H
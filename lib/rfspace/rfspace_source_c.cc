@@ -23,6 +23,10 @@
  * of probing for feature_t, options etc.  It should be the first
  * file included in your .cc file.
  */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* for recvmmsg() */
+#endif
+
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
@@ -38,6 +42,7 @@
 #endif
 
 #include <fcntl.h>
+#include <poll.h>
 #include <unistd.h>
 #include <termios.h>
 #include <sys/stat.h>
@@ -59,6 +64,7 @@
 #endif
 
 #include <gnuradio/io_signature.h>
+#include <osmosdr/time_spec.h>
 
 #include "arg_helpers.h"
 #include "rfspace_source_c.h"
@@ -71,6 +77,11 @@ using boost::asio::deadline_timer;
 #define DEFAULT_HOST  "127.0.0.1" /* We assume a running "siqs" from CuteSDR project */
 #define DEFAULT_PORT  50000
 
+#define UDP_PACKET_SIZE  (1024 * 2) /* header + sequence number + payload */
+#define UDP_PACKET_POOL  64         /* datagrams fetched with one syscall */
+
+#define USB_BULK_BUF_SIZE  (1024 * 64) /* serial staging buffer, several frames */
+
 /*
  * Create a new instance of rfspace_source_c and return
  * a boost shared_ptr.  This is effectively the public constructor.
@@ -112,19 +123,31 @@ rfspace_source_c::rfspace_source_c (const std::string &args)
     _udp(-1),
 #endif
     _usb(-1),
+    _usb_buf(NULL),
+    _usb_fill(0),
     _running(false),
     _keep_running(false),
     _sequence(0),
     _nchan(1),
     _sample_rate(NAN),
     _bandwidth(0.0f),
-    _fifo(NULL)
+    _fifo(NULL),
+    _pkt_pool(NULL),
+    _overflows(0),
+    _time_tag_pending(false),
+    _tagged_overruns(0)
 {
   std::string host = "";
   unsigned short port = 0;
 
   dict_t dict = params_to_dict(args);
 
+  if ( dict.count("affinity") )
+    _thread_policy.affinity = boost::lexical_cast<int>( dict["affinity"] );
+
+  if ( dict.count("rt_prio") )
+    _thread_policy.rt_prio = boost::lexical_cast<int>( dict["rt_prio"] );
+
   if ( dict.count("sdr-iq") )
     dict["rfspace"] = dict["sdr-iq"];
 
@@ -195,6 +218,12 @@ rfspace_source_c::rfspace_source_c (const std::string &args)
   if ( label.length() )
     std::cerr << "Using " + label << " ";
 
+  _run_ctrl_task = false;
+
+  /* self pipe used to wake the control task out of poll() on shutdown */
+  if ( pipe( _wake_pipe ) != 0 )
+    throw std::runtime_error("Could not create wakeup pipe: " + std::string(strerror(errno)));
+
   struct stat sb;
   bzero(&sb, sizeof(sb));
 
@@ -220,8 +249,16 @@ rfspace_source_c::rfspace_source_c (const std::string &args)
     tcflush(_usb, TCIFLUSH);
     tcsetattr(_usb, TCSANOW, &tios);
 
-    unsigned char byte;
-    while ( read(_usb, &byte, sizeof(byte)) > 0 ); /* flush serial */
+    _usb_buf = new unsigned char[USB_BULK_BUF_SIZE];
+
+    while ( read(_usb, _usb_buf, USB_BULK_BUF_SIZE) > 0 ); /* flush serial */
+
+    /* from here on reads serve the sample stream: have the kernel hold
+     * them back until a sizable batch is in (or the line goes quiet), so
+     * one syscall drains several frames instead of nibbling at each one */
+    tios.c_cc[VTIME] = 1;
+    tios.c_cc[VMIN]  = 255;
+    tcsetattr(_usb, TCSANOW, &tios);
 
     _radio = RFSPACE_SDR_IQ; /* legitimate assumption */
 
@@ -229,9 +266,9 @@ rfspace_source_c::rfspace_source_c (const std::string &args)
     if ( ! _fifo )
       throw std::runtime_error( "Failed to allocate sample FIFO" );
 
-    _run_usb_read_task = true;
+    _run_ctrl_task = true;
 
-    _thread = gr::thread::thread( boost::bind(&rfspace_source_c::usb_read_task, this) );
+    _thread = gr::thread::thread( boost::bind(&rfspace_source_c::control_task, this) );
   }
   else /* assuming host & port */
   {
@@ -339,6 +376,8 @@ rfspace_source_c::rfspace_source_c (const std::string &args)
       throw std::runtime_error("Bind of UDP socket failed: " + std::string(strerror(errno)));
     }
 
+    _pkt_pool = new unsigned char[UDP_PACKET_POOL * UDP_PACKET_SIZE];
+
 #endif
 
   }
@@ -478,13 +517,13 @@ rfspace_source_c::rfspace_source_c (const std::string &args)
     set_bandwidth( 0 );
   }
 
-  /* start TCP keepalive thread */
+  /* start control task (keeps the TCP connection alive) */
   if ( RFSPACE_NETSDR == _radio ||
        RFSPACE_SDR_IP == _radio ||
        RFSPACE_CLOUDIQ == _radio )
   {
-    _run_tcp_keepalive_task = true;
-    _thread = gr::thread::thread( boost::bind(&rfspace_source_c::tcp_keepalive_task, this) );
+    _run_ctrl_task = true;
+    _thread = gr::thread::thread( boost::bind(&rfspace_source_c::control_task, this) );
   }
 
 #if 0
@@ -511,21 +550,25 @@ rfspace_source_c::~rfspace_source_c ()
   close(_udp);
 #endif
 
-  if ( RFSPACE_SDR_IQ == _radio )
+  if ( _run_ctrl_task )
   {
-    _run_usb_read_task = false;
+    _run_ctrl_task = false;
+
+    /* wake the control task out of poll() */
+    if ( write( _wake_pipe[1], "", 1 ) != 1 )
+      std::cerr << "Could not wake up control task." << std::endl;
 
     _thread.join();
   }
-  else
-  {
-    _run_tcp_keepalive_task = false;
-    _thread.interrupt();
-    _thread.join();
-  }
+
+  close(_wake_pipe[0]);
+  close(_wake_pipe[1]);
 
   close(_usb);
 
+  delete [] _pkt_pool;
+  delete [] _usb_buf;
+
   if ( _fifo )
   {
     delete _fifo;
@@ -640,129 +683,176 @@ bool rfspace_source_c::transaction( const unsigned char *cmd, size_t size,
   return true;
 }
 
-static size_t read_bytes( int fd, char *data, size_t size, bool &run )
+/*
+ * Single poll() driven loop serving the whole control channel: serial
+ * data and command responses of the SDR-IQ as well as the periodic
+ * keepalive of the networked radios. Between events the thread sleeps
+ * in the kernel, so it neither burns timer wakeups nor preempts the
+ * datapath thread. The self pipe wakes it for shutdown.
+ */
+void rfspace_source_c::control_task()
 {
-  size_t nbytes = 0;
+  struct pollfd fds[2];
+  nfds_t nfds = 0;
 
-  while ( nbytes < size && run )
+  apply_thread_policy( _thread_policy );
+
+  fds[nfds].fd = _wake_pipe[0];
+  fds[nfds].events = POLLIN;
+  nfds++;
+
+  if ( _usb != -1 )
   {
-    int nread = read( fd, &data[nbytes], 1 );
+    fds[nfds].fd = _usb;
+    fds[nfds].events = POLLIN;
+    nfds++;
+  }
+
+  /* without a serial descriptor to watch, the poll() timeout doubles
+   * as the keepalive timer of the TCP connection */
+  int timeout = ( 1 == nfds ) ? 60 * 1000 : -1;
+
+  while ( _run_ctrl_task )
+  {
+    int ret = poll( fds, nfds, timeout );
+
+    if ( ret < 0 )
+    {
+      if ( EINTR == errno )
+        continue;
+
+      break;
+    }
 
-    if ( nread == 0 )
-      continue;   
+    if ( 0 == ret ) /* timeout, send periodic status request */
+    {
+      std::vector< unsigned char > response;
+      unsigned char status_pkt[] = { 0x04, 0x20, 0x05, 0x00 };
+      transaction( status_pkt, sizeof(status_pkt), response );
 
-    if ( nread < 0 )
+      continue;
+    }
+
+    if ( fds[0].revents ) /* woken up for shutdown */
       break;
 
-    nbytes++;
+    if ( nfds > 1 && fds[1].revents )
+      usb_read();
   }
-
-  return nbytes;
 }
 
-void rfspace_source_c::usb_read_task()
+/* batch whatever the serial line has queued into the staging buffer with
+ * a single read() and dispatch every complete frame found in it. bytes of
+ * a trailing partial frame stay in the buffer for the next batch. */
+void rfspace_source_c::usb_read()
 {
-  char data[1024*10];
-  size_t n_avail, to_copy;
-
-  if ( -1 == _usb )
+  int nread = read( _usb, _usb_buf + _usb_fill,
+                    USB_BULK_BUF_SIZE - _usb_fill );
+  if ( nread <= 0 )
     return;
 
-  while ( _run_usb_read_task )
+  _usb_fill += nread;
+
+  size_t pos = 0;
+
+  while ( _usb_fill - pos >= 2 )
   {
-    size_t nbytes = read_bytes( _usb, data, 2, _run_usb_read_task );
-    if ( nbytes != 2 )
-      continue;
+    unsigned char *frame = _usb_buf + pos;
 
-    size_t length = ((data[1] << 8) | data[0]) & 0x1fff;
+    size_t length = ((frame[1] << 8) | frame[0]) & 0x1fff;
 
     if ( 0 == length ) /* SDR-IQ 5.4.1 Output Data Item 0 */
       length = 1024*8 + 2;
 
-    if ( length <= 2 )
+    if ( length <= 2 ) /* header only items carry no payload, skip them */
+    {
+      pos += 2;
       continue;
+    }
 
-    length -= 2; /* subtract header */
-
-    if ( length > sizeof(data) - 2 )
+    if ( length > USB_BULK_BUF_SIZE )
     {
-      _run_usb_read_task = false;
+      _run_ctrl_task = false;
 
-      continue;
+      return;
     }
 
-    nbytes = read_bytes( _usb, data + 2, length, _run_usb_read_task );
-    if ( nbytes != length )
-      continue;
+    if ( _usb_fill - pos < length ) /* frame still incomplete */
+      break;
 
-    if ( 1024*8 == length )
-    {
-      /* push samples into the fifo */
+    usb_dispatch_frame( frame, length );
 
-      _fifo_lock.lock();
+    pos += length;
+  }
 
-      size_t num_samples = length / 4;
-      n_avail = _fifo->capacity() - _fifo->size();
-      to_copy = (n_avail < num_samples ? n_avail : num_samples);
+  if ( pos )
+  {
+    memmove( _usb_buf, _usb_buf + pos, _usb_fill - pos );
+    _usb_fill -= pos;
+  }
+}
 
-      #define SCALE_16  (1.0f/32768.0f)
+/* dispatch one complete frame including its header: sample payloads go
+ * into the fifo, command responses wake the transaction in flight */
+void rfspace_source_c::usb_dispatch_frame( unsigned char *data, size_t length )
+{
+  size_t n_avail, to_copy;
 
-      int16_t *sample = (int16_t *)(data + 2);
+  length -= 2; /* subtract header */
 
-      for ( size_t i = 0; i < to_copy; i++ )
-      {
-        /* Push sample to the fifo */
-        _fifo->push_back( gr_complex( *(sample+0) * SCALE_16,
-                                      *(sample+1) * SCALE_16 ) );
+  if ( 1024*8 == length )
+  {
+    /* push samples into the fifo */
 
-        /* offset to the next I+Q sample */
-        sample += 2;
-      }
+    _fifo_lock.lock();
 
-      #undef SCALE_16
+    size_t num_samples = length / 4;
+    n_avail = _fifo->capacity() - _fifo->size();
+    to_copy = (n_avail < num_samples ? n_avail : num_samples);
 
-      _fifo_lock.unlock();
+    #define SCALE_16  (1.0f/32768.0f)
 
-      /* We have made some new samples available to the consumer in work() */
-      if (to_copy) {
-//        std::cerr << "+" << std::flush;
-        _samp_avail.notify_one();
-      }
+    int16_t *sample = (int16_t *)(data + 2);
 
-      /* Indicate overrun, if neccesary */
-      if (to_copy < num_samples)
-        std::cerr << "O" << std::flush;
-    }
-    else
+    for ( size_t i = 0; i < to_copy; i++ )
     {
-      /* copy response & signal transaction */
+      /* Push sample to the fifo */
+      _fifo->push_back( gr_complex( *(sample+0) * SCALE_16,
+                                    *(sample+1) * SCALE_16 ) );
 
-      _resp_lock.lock();
+      /* offset to the next I+Q sample */
+      sample += 2;
+    }
+
+    #undef SCALE_16
 
-      _resp.clear();
-      _resp.resize( length + 2 );
-      memcpy( _resp.data(), data, length + 2 );
+    _fifo_lock.unlock();
 
-      _resp_lock.unlock();
+    /* We have made some new samples available to the consumer in work() */
+    if (to_copy) {
+//      std::cerr << "+" << std::flush;
+      _samp_avail.notify_one();
+    }
 
-      _resp_avail.notify_one();
+    /* Indicate overrun, if neccesary */
+    if (to_copy < num_samples) {
+      _overflows.fetch_add(1, boost::memory_order_relaxed);
+      std::cerr << "O" << std::flush;
     }
   }
-}
+  else
+  {
+    /* copy response & signal transaction */
 
-/* send periodic status requests to keep TCP connection alive */
-void rfspace_source_c::tcp_keepalive_task()
-{
-  std::vector< unsigned char > response;
-  unsigned char status_pkt[] = { 0x04, 0x20, 0x05, 0x00 };
+    _resp_lock.lock();
 
-  if ( -1 == _tcp )
-    return;
+    _resp.clear();
+    _resp.resize( length + 2 );
+    memcpy( _resp.data(), data, length + 2 );
 
-  while ( _run_tcp_keepalive_task )
-  {
-    boost::this_thread::sleep_for(boost::chrono::seconds(60));
-    transaction( status_pkt, sizeof(status_pkt), response );
+    _resp_lock.unlock();
+
+    _resp_avail.notify_one();
   }
 }
 
@@ -772,6 +862,9 @@ bool rfspace_source_c::start()
   _running = true;
   _keep_running = false;
 
+  _time_tag_pending = true;
+  _tagged_overruns = _overflows.load(boost::memory_order_relaxed);
+
   /* SDR-IP 4.2.1 Receiver State */
   /* NETSDR 4.2.1 Receiver State */
   unsigned char start[] = { 0x08, 0x00, 0x18, 0x00, 0x80, 0x02, 0x00, 0x00 };
@@ -813,62 +906,19 @@ bool rfspace_source_c::stop()
   return transaction( stop, sizeof(stop) );
 }
 
-/* Main work function, pull samples from the socket */
-int rfspace_source_c::work( int noutput_items,
-                           gr_vector_const_void_star &input_items,
-                           gr_vector_void_star &output_items )
+#define HEADER_SIZE 2
+#define SEQNUM_SIZE 2
+
+/* Validate a single data datagram, track its sequence number and convert
+ * the payload into the output buffers starting at out_offset. A sequence
+ * gap is concealed by zero filling the exact number of missing samples so
+ * downstream timing stays intact. At most space samples are produced per
+ * channel; returns the number of samples produced. */
+int rfspace_source_c::process_datagram( unsigned char *data, size_t rx_bytes,
+                                        struct sockaddr_in *peer,
+                                        gr_vector_void_star &output_items,
+                                        int out_offset, int space )
 {
-  unsigned char data[1024*2];
-
-  if ( ! _running )
-    return WORK_DONE;
-
-  if ( RFSPACE_SDR_IQ == _radio )
-  {
-    if ( noutput_items > 0 )
-    {
-      gr_complex *out = (gr_complex *)output_items[0];
-
-      boost::unique_lock<boost::mutex> lock(_fifo_lock);
-
-      /* Wait until we have the requested number of samples */
-      int n_samples_avail = _fifo->size();
-
-      while ( n_samples_avail < noutput_items )
-      {
-        _samp_avail.wait(lock);
-        n_samples_avail = _fifo->size();
-      }
-
-      for ( int i = 0; i < noutput_items; ++i )
-      {
-        out[i] = _fifo->at(0);
-        _fifo->pop_front();
-      }
-
-//      std::cerr << "-" << std::flush;
-    }
-
-    return noutput_items;
-  }
-
-#ifdef USE_ASIO
-  udp::endpoint ep;
-  size_t rx_bytes = _u.receive_from( boost::asio::buffer(data, sizeof(data)), ep );
-#else
-  struct sockaddr_in sa_in;           /* remote address */
-  socklen_t addrlen = sizeof(sa_in);  /* length of addresses */
-  ssize_t rx_bytes = recvfrom(_udp, data, sizeof(data), 0, (struct sockaddr *)&sa_in, &addrlen);
-  if ( rx_bytes <= 0 )
-  {
-    std::cerr << "recvfrom returned " << rx_bytes << std::endl;
-    return WORK_DONE;
-  }
-#endif
-
-  #define HEADER_SIZE 2
-  #define SEQNUM_SIZE 2
-
 //  bool is_24_bit = false;   // TODO: implement 24 bit sample format
 
   /* check header */
@@ -889,17 +939,6 @@ int rfspace_source_c::work( int noutput_items,
 
   uint16_t diff = sequence - _sequence;
 
-  if ( diff > 1 )
-  {
-    std::cerr << "Lost " << diff << " packets from "
-#ifdef USE_ASIO
-              << ep
-#else
-              << inet_ntoa(sa_in.sin_addr) << ":" << ntohs(sa_in.sin_port)
-#endif
-              << std::endl;
-  }
-
   _sequence = (0xffff == sequence) ? 0 : sequence;
 
   /* get pointer to samples */
@@ -907,11 +946,46 @@ int rfspace_source_c::work( int noutput_items,
 
   size_t rx_samples = (rx_bytes - HEADER_SIZE - SEQNUM_SIZE) / (sizeof(int16_t) * 2);
 
+  if ( 2 == _nchan )
+    rx_samples /= 2;
+
+  int produced = 0;
+
+  if ( diff > 1 )
+  {
+    /* in contiguous mode all datagrams carry the same number of samples,
+     * so the gap length is known exactly. zero fill it, clipped to what
+     * the output buffer can take after this packet's own payload. */
+    size_t missing = (size_t)(diff - 1) * rx_samples;
+    size_t fill = space > (int)rx_samples ? space - rx_samples : 0;
+
+    fill = std::min( missing, fill );
+
+    for ( size_t n = 0; n < _nchan; n++ )
+      memset( (gr_complex *)output_items[n] + out_offset, 0,
+              fill * sizeof(gr_complex) );
+
+    produced += fill;
+
+    _overflows.fetch_add(diff - 1, boost::memory_order_relaxed);
+
+    std::cerr << "Lost " << diff << " packets";
+#ifndef USE_ASIO
+    if ( peer )
+      std::cerr << " from " << inet_ntoa(peer->sin_addr)
+                << ":" << ntohs(peer->sin_port);
+#endif
+    std::cerr << ", concealed " << fill << " samples" << std::endl;
+  }
+
+  if ( (int)rx_samples > space - produced )
+    rx_samples = space - produced;
+
   #define SCALE_16  (1.0f/32768.0f)
 
   if ( 1 == _nchan )
   {
-    gr_complex *out = (gr_complex *)output_items[0];
+    gr_complex *out = (gr_complex *)output_items[0] + out_offset + produced;
     for ( size_t i = 0; i < rx_samples; i++ )
     {
       out[i] = gr_complex( *(sample+0) * SCALE_16,
@@ -922,10 +996,8 @@ int rfspace_source_c::work( int noutput_items,
   }
   else if ( 2 == _nchan )
   {
-    rx_samples /= 2;
-
-    gr_complex *out1 = (gr_complex *)output_items[0];
-    gr_complex *out2 = (gr_complex *)output_items[1];
+    gr_complex *out1 = (gr_complex *)output_items[0] + out_offset + produced;
+    gr_complex *out2 = (gr_complex *)output_items[1] + out_offset + produced;
     for ( size_t i = 0; i < rx_samples; i++ )
     {
       out1[i] = gr_complex( *(sample+0) * SCALE_16,
@@ -940,9 +1012,131 @@ int rfspace_source_c::work( int noutput_items,
 
   #undef SCALE_16
 
-  noutput_items = rx_samples;
+  return produced + rx_samples;
+}
+
+/* Main work function, pull samples from the socket */
+int rfspace_source_c::work( int noutput_items,
+                           gr_vector_const_void_star &input_items,
+                           gr_vector_void_star &output_items )
+{
+  if ( ! _running )
+    return WORK_DONE;
+
+  /* (re)stamp the stream on start and after overruns so downstream
+   * blocks can resynchronize instead of correlating continuously */
+  uint64_t overruns = _overflows.load(boost::memory_order_relaxed);
+  if ( _time_tag_pending || overruns != _tagged_overruns )
+  {
+    osmosdr::time_spec_t now = osmosdr::time_spec_t::get_system_time();
+
+    for ( size_t i = 0; i < output_items.size(); i++ )
+    {
+      add_item_tag(i, nitems_written(i),
+                   pmt::mp("rx_time"),
+                   pmt::make_tuple(pmt::from_uint64(now.get_full_secs()),
+                                   pmt::from_double(now.get_frac_secs())),
+                   pmt::mp(alias()));
+      add_item_tag(i, nitems_written(i),
+                   pmt::mp("rx_rate"),
+                   pmt::from_double(get_sample_rate()),
+                   pmt::mp(alias()));
+    }
+
+    _time_tag_pending = false;
+    _tagged_overruns = overruns;
+  }
+
+  if ( RFSPACE_SDR_IQ == _radio )
+  {
+    if ( noutput_items > 0 )
+    {
+      gr_complex *out = (gr_complex *)output_items[0];
+
+      boost::unique_lock<boost::mutex> lock(_fifo_lock);
 
-  return noutput_items;
+      /* Wait until we have the requested number of samples */
+      int n_samples_avail = _fifo->size();
+
+      while ( n_samples_avail < noutput_items )
+      {
+        _samp_avail.wait(lock);
+        n_samples_avail = _fifo->size();
+      }
+
+      for ( int i = 0; i < noutput_items; ++i )
+      {
+        out[i] = _fifo->at(0);
+        _fifo->pop_front();
+      }
+
+//      std::cerr << "-" << std::flush;
+    }
+
+    return noutput_items;
+  }
+
+#ifdef USE_ASIO
+  unsigned char data[UDP_PACKET_SIZE];
+  udp::endpoint ep;
+  size_t rx_bytes = _u.receive_from( boost::asio::buffer(data, sizeof(data)), ep );
+
+  return process_datagram( data, rx_bytes, NULL, output_items, 0,
+                           noutput_items );
+#elif defined(__linux__)
+  /* pull a batch of datagrams out of the kernel with a single syscall,
+   * bounded so that even maximum sized packets fit the output buffer */
+  struct mmsghdr msgs[UDP_PACKET_POOL];
+  struct iovec iovs[UDP_PACKET_POOL];
+  struct sockaddr_in peers[UDP_PACKET_POOL];
+
+  int max_samples = (UDP_PACKET_SIZE - HEADER_SIZE - SEQNUM_SIZE) /
+                    (sizeof(int16_t) * 2 * _nchan);
+  int vlen = std::max( 1, std::min( (int)UDP_PACKET_POOL,
+                                    noutput_items / max_samples ) );
+
+  memset( msgs, 0, sizeof(msgs) );
+  for ( int i = 0; i < vlen; i++ )
+  {
+    iovs[i].iov_base = _pkt_pool + i * UDP_PACKET_SIZE;
+    iovs[i].iov_len = UDP_PACKET_SIZE;
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+    msgs[i].msg_hdr.msg_name = &peers[i];
+    msgs[i].msg_hdr.msg_namelen = sizeof(peers[i]);
+  }
+
+  /* block for the first datagram, take the others only if already queued */
+  int npkts = recvmmsg( _udp, msgs, vlen, MSG_WAITFORONE, NULL );
+  if ( npkts <= 0 )
+  {
+    std::cerr << "recvmmsg returned " << npkts << std::endl;
+    return WORK_DONE;
+  }
+
+  int produced = 0;
+
+  for ( int i = 0; i < npkts; i++ )
+    produced += process_datagram( _pkt_pool + i * UDP_PACKET_SIZE,
+                                  msgs[i].msg_len, &peers[i],
+                                  output_items, produced,
+                                  noutput_items - produced );
+
+  return produced;
+#else
+  unsigned char *data = _pkt_pool;
+  struct sockaddr_in sa_in;           /* remote address */
+  socklen_t addrlen = sizeof(sa_in);  /* length of addresses */
+  ssize_t rx_bytes = recvfrom(_udp, data, UDP_PACKET_SIZE, 0, (struct sockaddr *)&sa_in, &addrlen);
+  if ( rx_bytes <= 0 )
+  {
+    std::cerr << "recvfrom returned " << rx_bytes << std::endl;
+    return WORK_DONE;
+  }
+
+  return process_datagram( data, rx_bytes, &sa_in, output_items, 0,
+                           noutput_items );
+#endif
 }
 
 /* discovery protocol internals taken from CuteSDR project */
@@ -1345,6 +1539,16 @@ size_t rfspace_source_c::get_num_channels()
   return _nchan;
 }
 
+uint64_t rfspace_source_c::get_num_overflows()
+{
+  return _overflows.load(boost::memory_order_relaxed);
+}
+
+void rfspace_source_c::reset_stream_stats()
+{
+  _overflows.store(0, boost::memory_order_relaxed);
+}
+
 #define NETSDR_MAX_RATE  2e6  /* same for SDR-IP & NETSDR */
 #define NETSDR_ADC_CLOCK 80e6 /* same for SDR-IP & NETSDR */
 #define SDR_IQ_ADC_CLOCK 66666667 /* SDR-IQ 5.2.4 I/Q Data Output Sample Rate */
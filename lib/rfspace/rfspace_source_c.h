@@ -29,12 +29,14 @@
 #include <gnuradio/block.h>
 #include <gnuradio/sync_block.h>
 
+#include <boost/atomic.hpp>
 #include <boost/circular_buffer.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/condition_variable.hpp>
 
 #include "osmosdr/ranges.h"
 #include "source_iface.h"
+#include "thread_policy.h"
 #ifdef USE_ASIO
 using boost::asio::ip::tcp;
 using boost::asio::ip::udp;
@@ -92,6 +94,9 @@ public:
 
   size_t get_num_channels( void );
 
+  uint64_t get_num_overflows( void );
+  void reset_stream_stats( void );
+
   osmosdr::meta_range_t get_sample_rates( void );
   double set_sample_rate( double rate );
   double get_sample_rate( void );
@@ -123,13 +128,19 @@ public:
 private: /* functions */
   void apply_channel( unsigned char *cmd, size_t chan = 0 );
 
+  int process_datagram( unsigned char *data, size_t rx_bytes,
+                        struct sockaddr_in *peer,
+                        gr_vector_void_star &output_items,
+                        int out_offset, int space );
+
   bool transaction( const unsigned char *cmd, size_t size );
 
   bool transaction( const unsigned char *cmd, size_t size,
                     std::vector< unsigned char > &response );
 
-  void usb_read_task();
-  void tcp_keepalive_task();
+  void control_task();
+  void usb_read();
+  void usb_dispatch_frame( unsigned char *data, size_t length );
 
 private: /* members */
   enum radio_type
@@ -153,6 +164,8 @@ private: /* members */
   SOCKET _udp;
 #endif
   int _usb;
+  unsigned char *_usb_buf; /* staging buffer for batched serial reads */
+  size_t _usb_fill;        /* bytes carried over of an incomplete frame */
   bool _running;
   bool _keep_running;
   uint16_t _sequence;
@@ -162,14 +175,21 @@ private: /* members */
   double _bandwidth;
 
   gr::thread::thread _thread;
-  bool _run_usb_read_task;
-  bool _run_tcp_keepalive_task;
+  thread_policy _thread_policy; /* affinity/rt_prio for the reader thread */
+  bool _run_ctrl_task;
+  int _wake_pipe[2]; /* self pipe, wakes the control task for shutdown */
   boost::mutex _tcp_lock;
 
   boost::circular_buffer<gr_complex> *_fifo;
   boost::mutex _fifo_lock;
   boost::condition_variable _samp_avail;
 
+  unsigned char *_pkt_pool; /* datagram pool for the batched UDP receive */
+  boost::atomic<uint64_t> _overflows; /* fifo overruns plus lost datagrams */
+
+  bool _time_tag_pending;    /* stamp rx_time/rx_rate on the next sample */
+  uint64_t _tagged_overruns; /* overrun count at the last stamp */
+
   std::vector< unsigned char > _resp;
   boost::mutex _resp_lock;
   boost::condition_variable _resp_avail;
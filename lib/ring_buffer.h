@@ -0,0 +1,418 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_RING_BUFFER_H
+#define OSMOSDR_RING_BUFFER_H
+
+#include <boost/atomic.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/thread_time.hpp>
+
+#include <volk/volk.h>
+
+#include "page_alloc.h"
+#include "osmosdr_trace.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <stdint.h>
+
+/*!
+ * Single-producer/single-consumer ring of preallocated equally sized
+ * buffers, shared by the driver blocks to hand samples from a streaming
+ * callback over to the work function.
+ *
+ * Head and tail are a pair of monotonically increasing atomic counters,
+ * so neither side takes a lock on the fast path. The mutex/condvar pair
+ * only backs the consumer sleep in wait_for() while the ring runs low;
+ * the producer wakes it with a bare notify, a possibly lost wakeup is
+ * recovered by the next transfer. What happens on overrun is selectable
+ * via set_overflow_policy(): by default the producer drops the newest
+ * buffer (keeping a contiguous backlog, right for recording), it may
+ * instead reclaim the oldest one (favouring fresh data, right for live
+ * demodulation) or block until the consumer catches up (backpressure
+ * for TX paths). Every dropped buffer is counted and reported with the
+ * usual "O" on stderr.
+ *
+ * The slots are volk-aligned so they may be used as source or target of
+ * SIMD conversion kernels directly. A larger alignment may be requested,
+ * e.g. for O_DIRECT file I/O.
+ *
+ * With a non-default alloc_policy all slots are carved out of a single
+ * anonymous mapping so one huge-page/NUMA policy covers the whole ring;
+ * if the mapping cannot be served the ring falls back to volk_malloc.
+ */
+class ring_buffer : public boost::noncopyable
+{
+public:
+  /*! Behavior of write_ptr() when all slots are filled. */
+  enum overflow_policy
+  {
+    OVERFLOW_DROP_NEWEST = 0, /* refuse the slot, keep the backlog */
+    OVERFLOW_DROP_OLDEST,     /* reclaim the oldest slot */
+    OVERFLOW_BLOCK            /* wait (bounded) for the consumer */
+  };
+
+  /*! Map an overflow= device argument onto a policy. */
+  static overflow_policy policy_from_string( const std::string &s )
+  {
+    if (s.empty() || "newest" == s)
+      return OVERFLOW_DROP_NEWEST;
+    if ("oldest" == s)
+      return OVERFLOW_DROP_OLDEST;
+    if ("block" == s)
+      return OVERFLOW_BLOCK;
+
+    throw std::runtime_error("Unsupported overflow policy '" + s + "', "
+                             "use oldest, newest or block.");
+  }
+
+  /*! Slot length covering ms milliseconds of a byte stream split over
+   * num slots, rounded up to a multiple of quantum (e.g. the 512 byte
+   * USB bulk transfer granularity), at least one quantum. */
+  static unsigned int len_for_ms( double bytes_per_sec, double ms,
+                                  unsigned int num, unsigned int quantum )
+  {
+    double len = bytes_per_sec * ms / 1e3 / num;
+    unsigned int quanta = (unsigned int)(len / quantum);
+
+    if (len > (double)quanta * quantum)
+      quanta++;
+    if (0 == quanta)
+      quanta = 1;
+
+    return quanta * quantum;
+  }
+
+  ring_buffer( unsigned int num, unsigned int len, size_t alignment = 0,
+               const alloc_policy &policy = alloc_policy() )
+    : _buf(NULL),
+      _buf_lens(NULL),
+      _region(NULL),
+      _region_size(0),
+      _num(num),
+      _len(len),
+      _alignment(alignment),
+      _alloc(policy),
+      _head(0),
+      _tail(0),
+      _overruns(0),
+      _policy(OVERFLOW_DROP_NEWEST)
+  {
+    if (0 == _alignment)
+      _alignment = volk_get_alignment();
+
+    allocate();
+  }
+
+  ~ring_buffer()
+  {
+    release();
+  }
+
+  /*! Reallocate the slots for a new geometry, resetting the ring to
+   * empty. Not thread safe: producer and consumer must be quiescent.
+   * Throws like the constructor when the geometry cannot be backed by
+   * memory; the ring is empty and released in that case. */
+  void resize( unsigned int num, unsigned int len )
+  {
+    if (num == _num && len == _len)
+      return;
+
+    release();
+
+    _num = num;
+    _len = len;
+
+    _head.store(0, boost::memory_order_relaxed);
+    _tail.store(0, boost::memory_order_relaxed);
+
+    allocate();
+  }
+
+  unsigned int buf_num() const { return _num; }
+  unsigned int buf_len() const { return _len; }
+
+  /*! To be called before streaming starts, not thread safe. */
+  void set_overflow_policy( overflow_policy policy ) { _policy = policy; }
+
+  /*! Number of buffers the producer had to drop so far. */
+  uint64_t num_overruns() const
+  {
+    return _overruns.load(boost::memory_order_relaxed);
+  }
+
+  void reset_overruns()
+  {
+    _overruns.store(0, boost::memory_order_relaxed);
+  }
+
+  /*! Number of filled buffers waiting for the consumer. */
+  unsigned int used() const
+  {
+    return _tail.load(boost::memory_order_acquire) -
+           _head.load(boost::memory_order_acquire);
+  }
+
+  /* producer interface, to be used by a single thread at a time */
+
+  /*! Slot to be filled next, NULL when the ring is full and the
+   * overflow policy decided against making room. */
+  void *write_ptr()
+  {
+    unsigned int tail = _tail.load(boost::memory_order_relaxed);
+
+    if (tail - _head.load(boost::memory_order_acquire) == _num) {
+
+      if (OVERFLOW_BLOCK == _policy) {
+        /* wait for the consumer to free a slot, but give up after one
+         * second so a consumer that went away (e.g. on shutdown) can
+         * not deadlock the streaming callback; the timeout degrades
+         * into the drop-newest behavior below */
+        boost::system_time give_up = boost::get_system_time() +
+                                     boost::posix_time::seconds(1);
+
+        boost::mutex::scoped_lock lock(_mutex);
+
+        while (tail - _head.load(boost::memory_order_acquire) == _num &&
+               _space.timed_wait(lock, give_up))
+          ;
+
+        if (tail - _head.load(boost::memory_order_acquire) != _num)
+          return _buf[tail % _num];
+      }
+      else if (OVERFLOW_DROP_OLDEST == _policy) {
+        /* reclaim the oldest slot; losing the CAS against a concurrent
+         * read_done() means the consumer just made room itself. The
+         * consumer may still be copying out of the reclaimed slot, one
+         * possibly torn buffer per overrun is the price of freshness */
+        unsigned int head = _head.load(boost::memory_order_acquire);
+        _head.compare_exchange_strong(head, head + 1,
+                                      boost::memory_order_acq_rel);
+      }
+
+      _overruns.fetch_add(1, boost::memory_order_relaxed);
+      OSMOSDR_TRACE2(ring_overrun, this,
+                     _overruns.load(boost::memory_order_relaxed));
+      std::cerr << "O" << std::flush;
+
+      if (tail - _head.load(boost::memory_order_acquire) == _num)
+        return NULL;
+    }
+
+    return _buf[tail % _num];
+  }
+
+  /*! Publish the slot obtained through write_ptr(). */
+  void write_done( unsigned int len )
+  {
+    unsigned int tail = _tail.load(boost::memory_order_relaxed);
+
+    _buf_lens[tail % _num] = len;
+    _tail.store(tail + 1, boost::memory_order_release);
+
+    OSMOSDR_TRACE2(ring_write, this, len);
+
+    _cond.notify_one();
+  }
+
+  /*! Convenience producer, copies an external buffer into the ring. */
+  bool write( const void *data, unsigned int len )
+  {
+    void *dst = write_ptr();
+
+    if (!dst || len > _len)
+      return false;
+
+    memcpy(dst, data, len);
+    write_done(len);
+
+    return true;
+  }
+
+  /* consumer interface, to be used by a single thread at a time */
+
+  /*! Block until at least min_used buffers are ready or !running. */
+  void wait_for( unsigned int min_used, const bool &running )
+  {
+    boost::mutex::scoped_lock lock(_mutex);
+
+    while (used() < min_used && running)
+      _cond.wait(lock);
+  }
+
+  /*! Oldest filled slot, NULL when the ring is empty. */
+  void *read_ptr( unsigned int *len = NULL )
+  {
+    unsigned int head = _head.load(boost::memory_order_relaxed);
+
+    if (_tail.load(boost::memory_order_acquire) == head)
+      return NULL;
+
+    if (len)
+      *len = _buf_lens[head % _num];
+
+    return _buf[head % _num];
+  }
+
+  /*! Like read_ptr(), but peeks offset slots past the oldest one so the
+   * consumer may gather several filled slots into a single submission,
+   * e.g. one writev() covering the whole backlog. */
+  void *peek_ptr( unsigned int offset, unsigned int *len = NULL )
+  {
+    unsigned int head = _head.load(boost::memory_order_relaxed);
+
+    if (_tail.load(boost::memory_order_acquire) - head <= offset)
+      return NULL;
+
+    if (len)
+      *len = _buf_lens[(head + offset) % _num];
+
+    return _buf[(head + offset) % _num];
+  }
+
+  /*! Hand the slot obtained through read_ptr() back to the producer. */
+  void read_done()
+  {
+    OSMOSDR_TRACE1(ring_read, this);
+
+    _head.fetch_add(1, boost::memory_order_release);
+
+    if (OVERFLOW_BLOCK == _policy) {
+      /* wake a producer parked in write_ptr() */
+      {
+        boost::mutex::scoped_lock lock(_mutex);
+      }
+
+      _space.notify_one();
+    }
+  }
+
+  /*! Wake up a consumer blocked in wait_for(), e.g. on shutdown. The
+   * empty lock/unlock fences against the racing recheck in wait_for(). */
+  void notify()
+  {
+    {
+      boost::mutex::scoped_lock lock(_mutex);
+    }
+
+    _cond.notify_all();
+  }
+
+private:
+  /*! A failed allocation must surface as an exception right here: the
+   * geometry may come straight from a device argument (buffers=,
+   * buffer_ms=), and returning with NULL slots would crash the
+   * streaming path much later instead. */
+  void allocate()
+  {
+    _buf = (unsigned char **) malloc(_num * sizeof(unsigned char *));
+    _buf_lens = (unsigned int *) malloc(_num * sizeof(unsigned int));
+
+    if (!_buf || !_buf_lens) {
+      release();
+      throw_alloc_failure();
+    }
+
+    /* NULL slots so release() can run on a partial allocation */
+    memset(_buf, 0, _num * sizeof(unsigned char *));
+
+    if (!_alloc.is_default()) {
+      const size_t stride = ((size_t)_len + _alignment - 1)
+                            / _alignment * _alignment;
+
+      _region_size = (size_t)_num * stride;
+      _region = page_alloc(_region_size, _alloc);
+
+      if (_region) {
+        for (unsigned int i = 0; i < _num; ++i) {
+          _buf[i] = (unsigned char *)_region + i * stride;
+          _buf_lens[i] = _len;
+        }
+      }
+    }
+
+    if (!_region) {
+      for (unsigned int i = 0; i < _num; ++i) {
+        _buf[i] = (unsigned char *) volk_malloc(_len, _alignment);
+
+        if (!_buf[i]) {
+          release(); /* frees the slots allocated so far */
+          throw_alloc_failure();
+        }
+
+        _buf_lens[i] = _len;
+      }
+    }
+  }
+
+  void throw_alloc_failure()
+  {
+    throw std::runtime_error("Failed to allocate a ring of " +
+                             boost::lexical_cast<std::string>(_num) + " x " +
+                             boost::lexical_cast<std::string>(_len) +
+                             " byte buffers");
+  }
+
+  void release()
+  {
+    if (_buf) {
+      if (_region) {
+        page_free(_region, _region_size);
+        _region = NULL;
+        _region_size = 0;
+      } else {
+        for (unsigned int i = 0; i < _num; ++i)
+          volk_free(_buf[i]);
+      }
+
+      free(_buf);
+      _buf = NULL;
+    }
+
+    free(_buf_lens);
+    _buf_lens = NULL;
+  }
+
+  unsigned char **_buf;
+  unsigned int *_buf_lens;
+  void *_region; /* single mapping behind all slots, NULL for volk slots */
+  size_t _region_size;
+  unsigned int _num;
+  unsigned int _len;
+  size_t _alignment;
+  alloc_policy _alloc;
+
+  boost::atomic<unsigned int> _head;
+  boost::atomic<unsigned int> _tail;
+  boost::atomic<uint64_t> _overruns;
+  overflow_policy _policy;
+
+  boost::mutex _mutex;
+  boost::condition_variable _cond;
+  boost::condition_variable _space; /* producer sleep for OVERFLOW_BLOCK */
+};
+
+#endif /* OSMOSDR_RING_BUFFER_H */
@@ -29,19 +29,25 @@
 
 #include "rtl_source_c.h"
 #include <gnuradio/io_signature.h>
+#include <osmosdr/time_spec.h>
 
 #include <boost/assign.hpp>
 #include <boost/format.hpp>
+#include <boost/thread/thread.hpp>
 #include <boost/detail/endian.hpp>
 #include <boost/algorithm/string.hpp>
 
+#include <algorithm>
 #include <stdexcept>
 #include <iostream>
 #include <stdio.h>
 
 #include <rtl-sdr.h>
 
+#include <volk/volk.h>
+
 #include "arg_helpers.h"
+#include "osmosdr_trace.h"
 
 using namespace boost::assign;
 
@@ -51,6 +57,13 @@ using namespace boost::assign;
 
 #define BYTES_PER_SAMPLE  2 // rtl device delivers 8 bit unsigned IQ data
 
+/* below this the tuners cannot lock and direct sampling takes over */
+#define DIRECT_SAMP_THRESH 24e6
+
+/* capture layout: 8 byte magic, then per transfer a host order header
+ * { uint64 arrival nanoseconds, uint32 length } and the raw bytes */
+#define CAPTURE_MAGIC "OSMOCAP0"
+
 /*
  * Create a new instance of rtl_source_c and return
  * a boost shared_ptr.  This is effectively the public constructor.
@@ -75,20 +88,58 @@ static const int MAX_IN = 0;	// maximum number of input streams
 static const int MIN_OUT = 1;	// minimum number of output streams
 static const int MAX_OUT = 1;	// maximum number of output streams
 
+/*
+ * The output signature depends on the selected wire format: the default
+ * is complex float, with "wire_format=sc8" the device's 8 bit samples
+ * are passed through recentered but without inflation to float.
+ */
+static gr::io_signature::sptr rtl_out_sig( const std::string &args )
+{
+  device_args_t dict( args );
+
+  std::string format = dict.to_string("wire_format");
+
+  if ( format.length() && "fc32" != format && "sc8" != format )
+    throw std::runtime_error(
+          "Wire format '" + format + "' not supported by rtl backend.");
+
+  return gr::io_signature::make(MIN_OUT, MAX_OUT,
+                                wire_format_item_size( format ));
+}
+
 /*
  * The private constructor
  */
 rtl_source_c::rtl_source_c (const std::string &args)
   : gr::sync_block ("rtl_source_c",
         gr::io_signature::make(MIN_IN, MAX_IN, sizeof (gr_complex)),
-        gr::io_signature::make(MIN_OUT, MAX_OUT, sizeof (gr_complex))),
+        rtl_out_sig(args)),
+    _decim(1),
+    _cic(NULL),
+    _decim_buf(NULL),
+    _record_fp(NULL),
+    _wire_sc8(false),
+    _item_size(sizeof(gr_complex)),
     _dev(NULL),
-    _buf(NULL),
+    _ring(NULL),
     _running(false),
+    _gated(false),
     _no_tuner(false),
     _auto_gain(false),
     _if_gain(0),
-    _skipped(0)
+    _skipped(0),
+    _auto_direct(0),
+    _cur_direct(0),
+    _mode_tag_pending(false),
+    _scan_pos(0),
+    _scan_dwell(0),
+    _scan_settle(0),
+    _scan_remaining(0),
+    _scan_skip(0),
+    _scan_tag_pending(false),
+    _align_skip(0),
+    _time_tag_pending(false),
+    _tagged_overruns(0)
 {
   int ret;
   int index;
@@ -99,68 +150,134 @@ rtl_source_c::rtl_source_c (const std::string &args)
   char product[256];
   char serial[256];
 
-  dict_t dict = params_to_dict(args);
+  device_args_t dict(args);
+
+  _wire_sc8 = ("sc8" == dict.to_string("wire_format"));
+
+  _item_size = _wire_sc8 ? 2 * sizeof(char) : sizeof(gr_complex);
+
+  _decim = dict.to_uint("decim", 1);
+  if (0 == _decim)
+    _decim = 1;
+
+  if (_decim > 1) {
+    if (_wire_sc8)
+      throw std::runtime_error("decim= requires the fc32 wire format.");
+
+    _cic = new cic_decimator(_decim);
 
-  if (dict.count("rtl")) {
-    std::string value = dict["rtl"];
+    std::cerr << "Using software decimation by " << _decim << "." << std::endl;
+  }
+
+  _replay_file = dict.to_string("replay");
+
+  std::string record_file = dict.to_string("record");
+
+  if ( record_file.length() && _replay_file.length() )
+    throw std::runtime_error("record= and replay= are mutually exclusive.");
 
-    if ( (index = rtlsdr_get_index_by_serial( value.c_str() )) >= 0 ) {
-      dev_index = index; /* use the resolved index value */
-    } else { /* use the numeric value of the argument */
-      if ( value.length() ) {
-        try {
-          dev_index = boost::lexical_cast< unsigned int >( value );
-        } catch ( std::exception &ex ) {
-          throw std::runtime_error(
-                "Failed to use '" + value + "' as index: " + ex.what());
+  /* in replay mode the hardware is never touched */
+  if ( _replay_file.empty() ) {
+    if (dict.has("rtl")) {
+      std::string value = dict.to_string("rtl");
+
+      if ( (index = rtlsdr_get_index_by_serial( value.c_str() )) >= 0 ) {
+        dev_index = index; /* use the resolved index value */
+      } else { /* use the numeric value of the argument */
+        if ( value.length() ) {
+          char *end = NULL;
+          dev_index = (unsigned int)strtoul( value.c_str(), &end, 10 );
+          if ( NULL == end || *end != '\0' )
+            throw std::runtime_error(
+                  "Failed to use '" + value + "' as index.");
         }
       }
     }
-  }
 
-  if ( dev_index >= rtlsdr_get_device_count() )
-    throw std::runtime_error("Wrong rtlsdr device index given.");
+    if ( dev_index >= rtlsdr_get_device_count() )
+      throw std::runtime_error("Wrong rtlsdr device index given.");
 
-  std::cerr << "Using device #" << dev_index;
+    std::cerr << "Using device #" << dev_index;
+
+    memset(manufact, 0, sizeof(manufact));
+    memset(product, 0, sizeof(product));
+    memset(serial, 0, sizeof(serial));
+    if ( !rtlsdr_get_device_usb_strings( dev_index, manufact, product, serial ) ) {
+      if (strlen(manufact))
+        std::cerr << " " << manufact;
+      if (strlen(product))
+        std::cerr << " " << product;
+      if (strlen(serial))
+        std::cerr << " SN: " << serial;
+    } else {
+      std::cerr << " " << rtlsdr_get_device_name(dev_index);
+    }
 
-  memset(manufact, 0, sizeof(manufact));
-  memset(product, 0, sizeof(product));
-  memset(serial, 0, sizeof(serial));
-  if ( !rtlsdr_get_device_usb_strings( dev_index, manufact, product, serial ) ) {
-    if (strlen(manufact))
-      std::cerr << " " << manufact;
-    if (strlen(product))
-      std::cerr << " " << product;
-    if (strlen(serial))
-      std::cerr << " SN: " << serial;
-  } else {
-    std::cerr << " " << rtlsdr_get_device_name(dev_index);
+    std::cerr << std::endl;
   }
 
-  std::cerr << std::endl;
+  rtl_freq = (unsigned int)dict.to_double("rtl_xtal");
+
+  tuner_freq = (unsigned int)dict.to_double("tuner_xtal");
 
-  if (dict.count("rtl_xtal"))
-    rtl_freq = (unsigned int)boost::lexical_cast< double >( dict["rtl_xtal"] );
+  direct_samp = dict.to_uint("direct_samp");
 
-  if (dict.count("tuner_xtal"))
-    tuner_freq = (unsigned int)boost::lexical_cast< double >( dict["tuner_xtal"] );
+  _auto_direct = (int)dict.to_uint("auto_direct");
 
-  if (dict.count("direct_samp"))
-    direct_samp = boost::lexical_cast< unsigned int >( dict["direct_samp"] );
+  offset_tune = dict.to_uint("offset_tune");
 
-  if (dict.count("offset_tune"))
-    offset_tune = boost::lexical_cast< unsigned int >( dict["offset_tune"] );
+  bias_tee = dict.to_bool("bias");
 
-  if (dict.count("bias"))
-    bias_tee = boost::lexical_cast<bool>( dict["bias"] );
+  _buf_offset = 0;
 
-  _buf_num = _buf_len = _buf_head = _buf_used = _buf_offset = 0;
+  _buf_num = dict.to_uint("buffers");
 
-  if (dict.count("buffers"))
-    _buf_num = boost::lexical_cast< unsigned int >( dict["buffers"] );
+  _buf_len = dict.to_uint("buflen");
 
-  if (dict.count("buflen"))
-    _buf_len = boost::lexical_cast< unsigned int >( dict["buflen"] );
+  /* buffer_ms= sizes the transfers for the wanted amount of buffering
+   * at the configured sample rate instead of the fixed default; an
+   * explicit buflen= wins over the autosizing */
+  _buffer_ms = 0.0;
+  if ( 0 == _buf_len )
+    _buffer_ms = (double)dict.to_long("buffer_ms", 0);
+
+  /* scan=start:stop:step (or scan_list=f1:f2:...) makes the block hop
+   * through the resulting frequency list on its own: after scan_dwell
+   * output samples it retunes to the next entry, drops scan_settle
+   * samples of tuner settling time plus whatever was still buffered at
+   * the previous frequency, and tags the first clean sample with
+   * rx_freq. This saves the per-hop round-trip through the caller. */
+  std::string scan = dict.to_string("scan");
+  if ( scan.length() ) {
+    std::vector< std::string > fields;
+    boost::algorithm::split( fields, scan, boost::is_any_of( ":" ) );
+
+    double start = 0, stop = 0, step = 0;
+    if ( 3 == fields.size() ) {
+      start = strtod( fields[0].c_str(), NULL );
+      stop = strtod( fields[1].c_str(), NULL );
+      step = strtod( fields[2].c_str(), NULL );
+    }
+    if ( step <= 0 || stop < start )
+      throw std::runtime_error("Expected scan=start:stop:step with step > 0.");
+
+    for ( double freq = start; freq <= stop; freq += step )
+      _scan_freqs.push_back( freq );
+  } else if ( dict.has("scan_list") ) {
+    std::vector< std::string > fields;
+    std::string list = dict.to_string("scan_list");
+    boost::algorithm::split( fields, list, boost::is_any_of( ":" ) );
+
+    BOOST_FOREACH( std::string field, fields )
+      if ( field.length() )
+        _scan_freqs.push_back( strtod( field.c_str(), NULL ) );
+  }
+
+  _scan_dwell = dict.to_uint("scan_dwell", 16384);
+  if (0 == _scan_dwell)
+    _scan_dwell = 16384;
+
+  _scan_settle = dict.to_uint("scan_settle", 2048);
 
   if (0 == _buf_num)
     _buf_num = BUF_NUM;
@@ -173,70 +290,130 @@ rtl_source_c::rtl_source_c (const std::string &args)
               << std::endl;
   }
 
-  _samp_avail = _buf_len / BYTES_PER_SAMPLE;
+  /* watermark= is the consumer low-watermark: work() waits until this
+   * many buffers are filled before producing. 1 minimizes the added
+   * latency for repeater style flowgraphs, higher values ride out
+   * scheduling jitter when recording. */
+  _watermark = dict.to_uint("watermark", 3);
+  if (_watermark < 1)
+    _watermark = 1;
+  if (_watermark >= _buf_num)
+    _watermark = _buf_num - 1;
 
-  // create a lookup table for gr_complex values
-  for (unsigned int i = 0; i < 0x100; i++)
-    _lut.push_back((i - 127.4f) / 128.0f);
+  _samp_avail = _buf_len / BYTES_PER_SAMPLE;
 
   _dev = NULL;
-  ret = rtlsdr_open( &_dev, dev_index );
-  if (ret < 0)
-    throw std::runtime_error("Failed to open rtlsdr device.");
 
-  if (rtl_freq > 0 || tuner_freq > 0) {
-    if (rtl_freq)
-      std::cerr << "Setting rtl clock to " << rtl_freq << " Hz." << std::endl;
-    if (tuner_freq)
-      std::cerr << "Setting tuner clock to " << tuner_freq << " Hz." << std::endl;
+  if ( _replay_file.empty() ) {
+    ret = rtlsdr_open( &_dev, dev_index );
+    if (ret < 0)
+      throw std::runtime_error("Failed to open rtlsdr device.");
+
+    if (rtl_freq > 0 || tuner_freq > 0) {
+      if (rtl_freq)
+        std::cerr << "Setting rtl clock to " << rtl_freq << " Hz." << std::endl;
+      if (tuner_freq)
+        std::cerr << "Setting tuner clock to " << tuner_freq << " Hz." << std::endl;
+
+      ret = rtlsdr_set_xtal_freq( _dev, rtl_freq, tuner_freq );
+      if (ret < 0)
+        throw std::runtime_error(
+          str(boost::format("Failed to set xtal frequencies. Error %d.") % ret ));
+    }
 
-    ret = rtlsdr_set_xtal_freq( _dev, rtl_freq, tuner_freq );
+    ret = rtlsdr_set_sample_rate( _dev, 1024000 );
     if (ret < 0)
-      throw std::runtime_error(
-        str(boost::format("Failed to set xtal frequencies. Error %d.") % ret ));
-  }
+      throw std::runtime_error("Failed to set default samplerate.");
 
-  ret = rtlsdr_set_sample_rate( _dev, 1024000 );
-  if (ret < 0)
-    throw std::runtime_error("Failed to set default samplerate.");
+    ret = rtlsdr_set_tuner_gain_mode(_dev, int(!_auto_gain));
+    if (ret < 0)
+      throw std::runtime_error("Failed to set tuner gain mode.");
 
-  ret = rtlsdr_set_tuner_gain_mode(_dev, int(!_auto_gain));
-  if (ret < 0)
-    throw std::runtime_error("Failed to set tuner gain mode.");
+    ret = rtlsdr_set_agc_mode(_dev, int(_auto_gain));
+    if (ret < 0)
+      throw std::runtime_error("Failed to set agc mode.");
+
+    if (direct_samp) {
+      ret = rtlsdr_set_direct_sampling(_dev, direct_samp);
+      if (ret < 0)
+        throw std::runtime_error("Failed to enable direct sampling.");
+      _no_tuner = true;
+      _cur_direct = direct_samp;
+    }
 
-  ret = rtlsdr_set_agc_mode(_dev, int(_auto_gain));
-  if (ret < 0)
-    throw std::runtime_error("Failed to set agc mode.");
+    if (offset_tune) {
+      ret = rtlsdr_set_offset_tuning(_dev, offset_tune);
+      if (ret < 0)
+        throw std::runtime_error("Failed to enable offset tuning.");
+    }
 
-  if (direct_samp) {
-    ret = rtlsdr_set_direct_sampling(_dev, direct_samp);
+    ret = rtlsdr_set_bias_tee(_dev, bias_tee);
     if (ret < 0)
-      throw std::runtime_error("Failed to enable direct sampling.");
-    _no_tuner = true;
-  }
+      throw std::runtime_error("Failed to set bias tee.");
 
-  if (offset_tune) {
-    ret = rtlsdr_set_offset_tuning(_dev, offset_tune);
+    ret = rtlsdr_reset_buffer( _dev );
     if (ret < 0)
-      throw std::runtime_error("Failed to enable offset tuning.");
+      throw std::runtime_error("Failed to reset usb buffers.");
+
+    set_if_gain( 24 ); /* preset to a reasonable default (non-GRC use case) */
   }
 
-  ret = rtlsdr_set_bias_tee(_dev, bias_tee);
-  if (ret < 0)
-    throw std::runtime_error("Failed to set bias tee.");
+  alloc_policy policy;
+  policy.hugepages = dict.to_bool("hugepages");
+  policy.numa_node = (int)dict.to_long("numa_node", -1);
+
+  _thread_policy.affinity = (int)dict.to_long("affinity", -1);
+  _thread_policy.rt_prio = (int)dict.to_long("rt_prio", -1);
+
+  /* the ring holds output-format samples so the scheduler thread is
+   * left with a plain block copy and no per-sample work */
+  _ring = new ring_buffer(_buf_num, _buf_len / BYTES_PER_SAMPLE * _item_size,
+                          0, policy);
+
+  _ring->set_overflow_policy(
+        ring_buffer::policy_from_string( dict.to_string("overflow") ) );
 
-  ret = rtlsdr_reset_buffer( _dev );
-  if (ret < 0)
-    throw std::runtime_error("Failed to reset usb buffers.");
+  if (_cic)
+    _decim_buf = (gr_complex *)volk_malloc(
+          _buf_len / BYTES_PER_SAMPLE * sizeof(gr_complex),
+          volk_get_alignment());
 
-  set_if_gain( 24 ); /* preset to a reasonable default (non-GRC use case) */
+  if ( record_file.length() ) {
+    _record_fp = fopen( record_file.c_str(), "wb" );
+    if ( NULL == _record_fp )
+      throw std::runtime_error("Failed to open " + record_file);
 
-  _buf = (unsigned char **)malloc(_buf_num * sizeof(unsigned char *));
+    fwrite( CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC) - 1, 1, _record_fp );
 
-  if (_buf) {
-    for(unsigned int i = 0; i < _buf_num; ++i)
-      _buf[i] = (unsigned char *)malloc(_buf_len);
+    std::cerr << "Recording the raw device stream to " << record_file << "."
+              << std::endl;
   }
+
+  if ( _replay_file.length() )
+    std::cerr << "Replaying the raw device stream from " << _replay_file << "."
+              << std::endl;
+
+  /* async_tune=1 moves the several ms of synchronous usb control
+   * transfers behind a retune off the flowgraph's control context onto
+   * a command thread, so tuning no longer stalls sample consumption.
+   * Completion is published on the "tune_done" message port. */
+  message_port_register_out( pmt::mp("tune_done") );
+
+  _async_tune = dict.to_bool("async_tune");
+  _run_cmd_thread = false;
+  _tune_pending = false;
+  _tune_freq = 0;
+
+  if ( _async_tune ) {
+    _run_cmd_thread = true;
+    _cmd_worker = gr::thread::thread(_cmd_thread_fn, this);
+  }
+
+  /* Set up constraints: produce in aligned full SIMD widths so the
+   * conversion kernels never have to run a scalar tail */
+  int const alignment_multiple = volk_get_alignment() / sizeof(gr_complex);
+  set_alignment(std::max(1, alignment_multiple));
+  set_output_multiple(std::max(1, alignment_multiple));
 }
 
 /*
@@ -244,32 +421,109 @@ rtl_source_c::rtl_source_c (const std::string &args)
  */
 rtl_source_c::~rtl_source_c ()
 {
-  if (_dev) {
-    if (_running)
+  if (_run_cmd_thread)
+  {
     {
-      _running = false;
-      rtlsdr_cancel_async( _dev );
-      _thread.join();
+      boost::mutex::scoped_lock lock(_cmd_lock);
+      _run_cmd_thread = false;
     }
+    _cmd_cond.notify_one();
+    _cmd_worker.join();
+  }
+
+  if (_running)
+  {
+    _running = false;
+    if (_dev)
+      rtlsdr_cancel_async( _dev );
+    _thread.join();
+  }
 
+  if (_dev) {
     rtlsdr_close( _dev );
     _dev = NULL;
   }
 
-  if (_buf) {
-    for(unsigned int i = 0; i < _buf_num; ++i) {
-      free(_buf[i]);
-    }
+  if (_record_fp) {
+    fclose( _record_fp );
+    _record_fp = NULL;
+  }
+
+  if (_ring) {
+    delete _ring;
+    _ring = NULL;
+  }
+
+  if (_decim_buf) {
+    volk_free(_decim_buf);
+    _decim_buf = NULL;
+  }
 
-    free(_buf);
-    _buf = NULL;
+  if (_cic) {
+    delete _cic;
+    _cic = NULL;
   }
 }
 
+/* pick a transfer size covering _buffer_ms of buffering at the current
+ * device rate; only called while the reader thread is down */
+void rtl_source_c::update_buffer_geometry()
+{
+  if ( _buffer_ms <= 0.0 || ! _dev )
+    return;
+
+  double rate = (double)rtlsdr_get_sample_rate( _dev );
+  if ( rate <= 0.0 )
+    return;
+
+  unsigned int buf_len = ring_buffer::len_for_ms( rate * BYTES_PER_SAMPLE,
+                                                  _buffer_ms, _buf_num, 512 );
+
+  /* keep individual transfers large enough to be efficient on the bus */
+  if ( buf_len < 8 * 512 )
+    buf_len = 8 * 512;
+
+  if ( buf_len == _buf_len )
+    return;
+
+  _buf_len = buf_len;
+
+  _ring->resize( _buf_num, _buf_len / BYTES_PER_SAMPLE * _item_size );
+
+  if ( _cic ) {
+    volk_free( _decim_buf );
+    _decim_buf = (gr_complex *)volk_malloc(
+          _buf_len / BYTES_PER_SAMPLE * sizeof(gr_complex),
+          volk_get_alignment());
+  }
+
+  _buf_offset = 0;
+  _samp_avail = _buf_len / BYTES_PER_SAMPLE;
+
+  std::cerr << "Using " << _buf_num << " buffers of size " << _buf_len << "."
+            << std::endl;
+}
+
 bool rtl_source_c::start()
 {
+  if ( !_scan_freqs.empty() ) {
+    _scan_pos = 0;
+    set_center_freq( _scan_freqs[0] );
+    _scan_remaining = _scan_dwell;
+    _scan_skip = _scan_settle;
+    _scan_tag_pending = true;
+  }
+
+  _time_tag_pending = true;
+  _tagged_overruns = _ring->num_overruns();
+
+  update_buffer_geometry();
+
   _running = true;
-  _thread = gr::thread::thread(_rtlsdr_wait, this);
+  if ( _replay_file.length() )
+    _thread = gr::thread::thread(_rtlsdr_replay, this);
+  else
+    _thread = gr::thread::thread(_rtlsdr_wait, this);
 
   return true;
 }
@@ -284,6 +538,11 @@ bool rtl_source_c::stop()
   return true;
 }
 
+void rtl_source_c::gate_stream( bool gated )
+{
+  _gated = gated;
+}
+
 void rtl_source_c::_rtlsdr_callback(unsigned char *buf, uint32_t len, void *ctx)
 {
   rtl_source_c *obj = (rtl_source_c *)ctx;
@@ -292,26 +551,65 @@ void rtl_source_c::_rtlsdr_callback(unsigned char *buf, uint32_t len, void *ctx)
 
 void rtl_source_c::rtlsdr_callback(unsigned char *buf, uint32_t len)
 {
+  OSMOSDR_TRACE1(rtl_callback, len);
+
+  if (_gated) /* armed by start_synchronized(), drop the transfer */
+    return;
+
+  if (_record_fp) {
+    /* dump the transfer exactly as it entered the callback, the
+     * arrival timestamp lets the replay pace on the deltas */
+    uint64_t nsecs =
+        (uint64_t)osmosdr::time_spec_t::get_system_time().to_nsecs();
+
+    fwrite( &nsecs, sizeof(nsecs), 1, _record_fp );
+    fwrite( &len, sizeof(len), 1, _record_fp );
+    fwrite( buf, 1, len, _record_fp );
+  }
+
   if (_skipped < BUF_SKIP) {
     _skipped++;
     return;
   }
 
-  {
-    boost::mutex::scoped_lock lock( _buf_mutex );
+  /* convert straight out of the usb transfer buffer into the tail
+   * slot, which is ours until write_done() publishes it. this replaces
+   * the former memcpy, the raw bytes never get copied. */
+  if (_wire_sc8) {
+    signed char *out = (signed char *)_ring->write_ptr();
 
-    int buf_tail = (_buf_head + _buf_used) % _buf_num;
-    memcpy(_buf[buf_tail], buf, len);
+    if (!out) /* overrun, drop the transfer */
+      return;
 
-    if (_buf_used == _buf_num) {
-      std::cerr << "O" << std::flush;
-      _buf_head = (_buf_head + 1) % _buf_num;
-    } else {
-      _buf_used++;
-    }
+    for (uint32_t i = 0; i < len; ++i)
+      out[i] = (signed char)(buf[i] ^ 0x80); /* recenter to signed */
+
+    _ring->write_done(len);
+    return;
   }
 
-  _buf_cond.notify_one();
+  gr_complex *out = (gr_complex *)_ring->write_ptr();
+
+  if (!out) /* overrun, drop the transfer */
+    return;
+
+  if (_cic) {
+    /* decimate right after conversion, only the wanted rate ever
+     * crosses into the ring */
+    _converter.u8_fc32(_decim_buf, buf, len / BYTES_PER_SAMPLE, 0.6f / 128.0f);
+
+    unsigned int nout = _cic->process(out, _decim_buf, len / BYTES_PER_SAMPLE);
+
+    if (!nout) /* hold on to the slot until it carries a sample */
+      return;
+
+    _ring->write_done(nout * sizeof(gr_complex));
+    return;
+  }
+
+  _converter.u8_fc32(out, buf, len / BYTES_PER_SAMPLE, 0.6f / 128.0f);
+
+  _ring->write_done(len / BYTES_PER_SAMPLE * sizeof(gr_complex));
 }
 
 void rtl_source_c::_rtlsdr_wait(rtl_source_c *obj)
@@ -321,6 +619,8 @@ void rtl_source_c::_rtlsdr_wait(rtl_source_c *obj)
 
 void rtl_source_c::rtlsdr_wait()
 {
+  apply_thread_policy( _thread_policy ); /* the callback runs on this thread */
+
   int ret = rtlsdr_read_async( _dev, _rtlsdr_callback, (void *)this, _buf_num, _buf_len );
 
   _running = false;
@@ -328,50 +628,271 @@ void rtl_source_c::rtlsdr_wait()
   if ( ret != 0 )
     std::cerr << "rtlsdr_read_async returned with " << ret << std::endl;
 
-  _buf_cond.notify_one();
+  _ring->notify();
+}
+
+void rtl_source_c::_rtlsdr_replay(rtl_source_c *obj)
+{
+  obj->rtlsdr_replay();
+}
+
+/*
+ * Feed a raw capture back through the regular callback at recorded
+ * pacing. The transfers hit the very same ring and conversion path as
+ * live data, so a field overrun replays into the same overrun here.
+ */
+void rtl_source_c::rtlsdr_replay()
+{
+  apply_thread_policy( _thread_policy );
+
+  FILE *fp = fopen( _replay_file.c_str(), "rb" );
+
+  char magic[sizeof(CAPTURE_MAGIC) - 1];
+  if ( !fp ||
+       fread( magic, sizeof(magic), 1, fp ) != 1 ||
+       memcmp( magic, CAPTURE_MAGIC, sizeof(magic) ) != 0 ) {
+    std::cerr << "Failed to open capture " << _replay_file << std::endl;
+    if (fp)
+      fclose( fp );
+    _running = false;
+    _ring->notify();
+    return;
+  }
+
+  std::vector< unsigned char > buf;
+  long long first_nsecs = -1;
+  osmosdr::time_spec_t start = osmosdr::time_spec_t::get_system_time();
+
+  while (_running) {
+    uint64_t nsecs;
+    uint32_t len;
+
+    if ( fread( &nsecs, sizeof(nsecs), 1, fp ) != 1 ||
+         fread( &len, sizeof(len), 1, fp ) != 1 )
+      break; /* end of capture */
+
+    if ( buf.size() < len )
+      buf.resize( len );
+
+    if ( fread( &buf[0], 1, len, fp ) != len )
+      break; /* truncated transfer */
+
+    if ( first_nsecs < 0 )
+      first_nsecs = nsecs;
+
+    /* wait out the recorded arrival time, in slices so stop() does
+     * not hang on long capture gaps */
+    osmosdr::time_spec_t due =
+        start + osmosdr::time_spec_t::from_nsecs( nsecs - first_nsecs );
+
+    while (_running) {
+      double ahead =
+          (due - osmosdr::time_spec_t::get_system_time()).get_real_secs();
+
+      if (ahead <= 0)
+        break;
+
+      boost::this_thread::sleep( boost::posix_time::microseconds(
+          long(std::min(ahead, 0.01) * 1e6) + 1 ) );
+    }
+
+    if (_running)
+      rtlsdr_callback( &buf[0], len );
+  }
+
+  fclose( fp );
+
+  _running = false;
+  _ring->notify();
+}
+
+void rtl_source_c::_cmd_thread_fn(rtl_source_c *obj)
+{
+  obj->cmd_thread();
+}
+
+/*
+ * Dedicated tuner control thread (async_tune=1). Retune requests are
+ * coalesced to the latest target, executed here off the flowgraph's
+ * control context, and acknowledged on the "tune_done" message port
+ * once the hardware settled on the new frequency.
+ */
+void rtl_source_c::cmd_thread()
+{
+  boost::unique_lock<boost::mutex> lock(_cmd_lock);
+
+  while (_run_cmd_thread) {
+    if (!_tune_pending) {
+      _cmd_cond.wait(lock);
+      continue;
+    }
+
+    double freq = _tune_freq;
+    _tune_pending = false;
+
+    /* several ms of usb control transfers, run without the lock so
+     * further requests keep coalescing meanwhile */
+    lock.unlock();
+
+    if (_dev)
+      apply_center_freq( freq );
+
+    message_port_pub( pmt::mp("tune_done"),
+                      pmt::cons( pmt::mp("freq"),
+                                 pmt::from_double( get_center_freq() ) ) );
+
+    lock.lock();
+  }
 }
 
 int rtl_source_c::work( int noutput_items,
                         gr_vector_const_void_star &input_items,
                         gr_vector_void_star &output_items )
 {
-  gr_complex *out = (gr_complex *)output_items[0];
+  unsigned char *out = (unsigned char *)output_items[0];
+  int produced = 0;
 
-  {
-    boost::mutex::scoped_lock lock( _buf_mutex );
+  OSMOSDR_TRACE2(rtl_work_entry, noutput_items, _ring->used());
 
-    while (_buf_used < 3 && _running) // collect at least 3 buffers
-      _buf_cond.wait( lock );
-  }
+  _ring->wait_for(_watermark, _running); // collect the configured low-watermark
 
   if (!_running)
     return WORK_DONE;
 
-  while (noutput_items && _buf_used) {
-    const int nout = std::min(noutput_items, _samp_avail);
-    const unsigned char *buf = _buf[_buf_head] + _buf_offset * 2;
+  while (noutput_items && _ring->used()) {
+    /* slots are not necessarily full when the decimator is in line,
+     * pick up the actual length when entering a fresh one */
+    if (0 == _buf_offset) {
+      unsigned int bytes = 0;
+      _ring->read_ptr(&bytes);
+      _samp_avail = bytes / _item_size;
+    }
+
+    /* alignment trim requested via skip_samples() */
+    uint64_t align_skip = _align_skip.load(boost::memory_order_relaxed);
+    if (align_skip) {
+      const int nskip = (int)std::min((uint64_t)_samp_avail, align_skip);
+
+      _align_skip.fetch_sub(nskip, boost::memory_order_relaxed);
+      _samp_avail -= nskip;
+
+      if (!_samp_avail) {
+        _ring->read_done();
+        _buf_offset = 0;
+      } else {
+        _buf_offset += nskip;
+      }
+
+      continue;
+    }
+
+    /* settle time after a hop, consume without producing */
+    if (_scan_skip) {
+      const int nskip = (int)std::min((uint64_t)_samp_avail, _scan_skip);
+
+      _scan_skip -= nskip;
+      _samp_avail -= nskip;
+
+      if (!_samp_avail) {
+        _ring->read_done();
+        _buf_offset = 0;
+      } else {
+        _buf_offset += nskip;
+      }
+
+      continue;
+    }
+
+    /* (re)stamp the stream on start and after overruns so downstream
+       blocks can resynchronize instead of correlating continuously */
+    uint64_t overruns = _ring->num_overruns();
+    if (_time_tag_pending || overruns != _tagged_overruns) {
+      osmosdr::time_spec_t now = osmosdr::time_spec_t::get_system_time();
+      add_item_tag(0, nitems_written(0) + produced,
+                   pmt::mp("rx_time"),
+                   pmt::make_tuple(pmt::from_uint64(now.get_full_secs()),
+                                   pmt::from_double(now.get_frac_secs())),
+                   pmt::mp(alias()));
+      add_item_tag(0, nitems_written(0) + produced,
+                   pmt::mp("rx_rate"),
+                   pmt::from_double(get_sample_rate()),
+                   pmt::mp(alias()));
+      _time_tag_pending = false;
+      _tagged_overruns = overruns;
+    }
+
+    /* mark the first sample after a direct sampling switch */
+    if (_mode_tag_pending) {
+      add_item_tag(0, nitems_written(0) + produced,
+                   pmt::mp("direct_sampling"),
+                   pmt::from_long(_cur_direct),
+                   pmt::mp(alias()));
+      _mode_tag_pending = false;
+    }
+
+    int nout = std::min(noutput_items, _samp_avail);
 
-    for (int i = 0; i < nout; ++i)
-      *out++ = gr_complex(_lut[buf[i * 2]], _lut[buf[i * 2 + 1]]);
+    if (!_scan_freqs.empty()) {
+      nout = (int)std::min((uint64_t)nout, _scan_remaining);
 
+      if (_scan_tag_pending) {
+        add_item_tag(0, nitems_written(0) + produced,
+                     pmt::mp("rx_freq"),
+                     pmt::from_double(_scan_freqs[_scan_pos]),
+                     pmt::mp(alias()));
+        _scan_tag_pending = false;
+      }
+    }
+
+    const unsigned char *buf =
+        (unsigned char *)_ring->read_ptr() + _buf_offset * _item_size;
+
+    memcpy(out, buf, nout * _item_size);
+
+    out += nout * _item_size;
+    produced += nout;
     noutput_items -= nout;
     _samp_avail -= nout;
 
     if (!_samp_avail) {
-      {
-        boost::mutex::scoped_lock lock( _buf_mutex );
-
-        _buf_head = (_buf_head + 1) % _buf_num;
-        _buf_used--;
-      }
-      _samp_avail = _buf_len / BYTES_PER_SAMPLE;
+      _ring->read_done();
       _buf_offset = 0;
     } else {
       _buf_offset += nout;
     }
+
+    if (!_scan_freqs.empty()) {
+      _scan_remaining -= nout;
+
+      if (!_scan_remaining)
+        scan_hop();
+    }
   }
 
-  return (out - ((gr_complex *)output_items[0]));
+  OSMOSDR_TRACE1(rtl_work_exit, produced);
+
+  return produced;
+}
+
+/*
+ * Advance to the next scan frequency. Everything still buffered was
+ * captured at the previous frequency, so it is scheduled for dropping
+ * together with the configured settle time.
+ */
+void rtl_source_c::scan_hop()
+{
+  const uint64_t samples_per_buf = _buf_len / BYTES_PER_SAMPLE / _decim;
+
+  _scan_pos = (_scan_pos + 1) % _scan_freqs.size();
+
+  set_center_freq( _scan_freqs[_scan_pos] );
+
+  _scan_skip = _scan_settle;
+  if (_ring->used())
+    _scan_skip += _samp_avail + (_ring->used() - 1) * samples_per_buf;
+
+  _scan_remaining = _scan_dwell;
+  _scan_tag_pending = true;
 }
 
 std::vector<std::string> rtl_source_c::get_devices()
@@ -415,6 +936,26 @@ size_t rtl_source_c::get_num_channels()
   return 1;
 }
 
+uint64_t rtl_source_c::get_num_overflows()
+{
+  return _ring->num_overruns();
+}
+
+void rtl_source_c::reset_stream_stats()
+{
+  _ring->reset_overruns();
+}
+
+double rtl_source_c::get_buffer_level()
+{
+  return _ring->used() / (double)_ring->buf_num();
+}
+
+void rtl_source_c::skip_samples( uint64_t count, size_t chan )
+{
+  _align_skip.fetch_add(count, boost::memory_order_relaxed);
+}
+
 osmosdr::meta_range_t rtl_source_c::get_sample_rates()
 {
   osmosdr::meta_range_t range;
@@ -433,13 +974,23 @@ osmosdr::meta_range_t rtl_source_c::get_sample_rates()
 //  range += osmosdr::range_t( 3000000 ); // may work
 //  range += osmosdr::range_t( 3200000 ); // max rate
 
+  if (_decim > 1) {
+    /* present the decimated rates, the device runs _decim times faster */
+    osmosdr::meta_range_t decimated;
+
+    for (size_t i = 0; i < range.size(); i++)
+      decimated += osmosdr::range_t( range[i].start() / _decim );
+
+    return decimated;
+  }
+
   return range;
 }
 
 double rtl_source_c::set_sample_rate(double rate)
 {
   if (_dev) {
-    rtlsdr_set_sample_rate( _dev, (uint32_t)rate );
+    rtlsdr_set_sample_rate( _dev, (uint32_t)(rate * _decim) );
   }
 
   return get_sample_rate();
@@ -448,7 +999,7 @@ double rtl_source_c::set_sample_rate(double rate)
 double rtl_source_c::get_sample_rate()
 {
   if (_dev)
-    return (double)rtlsdr_get_sample_rate( _dev );
+    return (double)rtlsdr_get_sample_rate( _dev ) / _decim;
 
   return 0;
 }
@@ -458,6 +1009,14 @@ osmosdr::freq_range_t rtl_source_c::get_freq_range( size_t chan )
   osmosdr::freq_range_t range;
 
   if (_dev) {
+    if (_auto_direct) {
+      /* the block flips to direct sampling below the tuner range on
+       * its own, so the HF span is reachable as well */
+      uint32_t rtl_freq;
+      if ( !rtlsdr_get_xtal_freq( _dev, &rtl_freq, NULL ) )
+        range += osmosdr::range_t( 0, double(rtl_freq) / 2.0 );
+    }
+
     if (_no_tuner) {
       uint32_t rtl_freq;
       if ( !rtlsdr_get_xtal_freq( _dev, &rtl_freq, NULL ) )
@@ -487,10 +1046,54 @@ osmosdr::freq_range_t rtl_source_c::get_freq_range( size_t chan )
   return range;
 }
 
+/*
+ * Program the tuner, switching direct sampling on the fly when the
+ * target crosses the tuner range boundary. The demod accepts the mode
+ * change mid-stream, so the async reader stays alive and the dead air
+ * is bounded by the backlog still in the ring, which is scheduled for
+ * dropping; the first sample in the new mode is tagged.
+ */
+void rtl_source_c::apply_center_freq( double freq )
+{
+  if (_auto_direct) {
+    int mode = (freq < DIRECT_SAMP_THRESH) ? _auto_direct : 0;
+
+    if (mode != _cur_direct) {
+      if (rtlsdr_set_direct_sampling( _dev, mode ) < 0) {
+        std::cerr << "Failed to switch direct sampling mode." << std::endl;
+      } else {
+        _cur_direct = mode;
+
+        /* everything still buffered was captured in the old mode */
+        skip_samples( (uint64_t)_ring->used() *
+                      (_buf_len / BYTES_PER_SAMPLE / _decim) );
+        _mode_tag_pending = true;
+        _time_tag_pending = true;
+      }
+    }
+  }
+
+  rtlsdr_set_center_freq( _dev, (uint32_t)freq );
+}
+
 double rtl_source_c::set_center_freq( double freq, size_t chan )
 {
-  if (_dev)
-    rtlsdr_set_center_freq( _dev, (uint32_t)freq );
+  if (_dev) {
+    if (_async_tune) {
+      /* hand over to the command thread and return right away, the
+       * caller observes completion on the "tune_done" message port */
+      {
+        boost::mutex::scoped_lock lock(_cmd_lock);
+        _tune_freq = freq;
+        _tune_pending = true;
+      }
+      _cmd_cond.notify_one();
+
+      return freq;
+    }
+
+    apply_center_freq( freq );
+  }
 
   return get_center_freq( chan );
 }
@@ -505,7 +1108,10 @@ double rtl_source_c::get_center_freq( size_t chan )
 
 double rtl_source_c::set_freq_corr( double ppm, size_t chan )
 {
-  if ( _dev )
+  /* the library retunes internally when the correction changes; skip
+   * the call (and with it the usb transaction) for a repeated value,
+   * the comparison reads a library-local cache only */
+  if ( _dev && (int)ppm != rtlsdr_get_freq_correction( _dev ) )
     rtlsdr_set_freq_correction( _dev, (int)ppm );
 
   return get_freq_corr( chan );
@@ -23,12 +23,17 @@
 #define INCLUDED_RTLSDR_SOURCE_C_H
 
 #include <gnuradio/sync_block.h>
+#include <gnuradio/gr_complex.h>
 
 #include <gnuradio/thread/thread.h>
-#include <boost/thread/mutex.hpp>
-#include <boost/thread/condition_variable.hpp>
+
+#include <cstdio>
 
 #include "source_iface.h"
+#include "ring_buffer.h"
+#include "converter.h"
+#include "decimator.h"
+#include "thread_policy.h"
 
 class rtl_source_c;
 typedef struct rtlsdr_dev rtlsdr_dev_t;
@@ -86,6 +91,12 @@ public:
 
   size_t get_num_channels( void );
 
+  uint64_t get_num_overflows( void );
+  void reset_stream_stats( void );
+  double get_buffer_level( void );
+  void skip_samples( uint64_t count, size_t chan = 0 );
+  void gate_stream( bool gated );
+
   osmosdr::meta_range_t get_sample_rates( void );
   double set_sample_rate( double rate );
   double get_sample_rate( void );
@@ -121,19 +132,39 @@ private:
   void rtlsdr_callback(unsigned char *buf, uint32_t len);
   static void _rtlsdr_wait(rtl_source_c *obj);
   void rtlsdr_wait();
-
-  std::vector<float> _lut;
+  static void _rtlsdr_replay(rtl_source_c *obj);
+  void rtlsdr_replay();
+  void scan_hop();
+  void update_buffer_geometry();
+  void apply_center_freq( double freq );
+  static void _cmd_thread_fn(rtl_source_c *obj);
+  void cmd_thread();
+
+  sample_converter _converter; /* shared volk-backed conversion kernels */
+  thread_policy _thread_policy; /* affinity/rt_prio for the reader thread */
+
+  /* optional in-block decimation (decim= argument), applied right
+   * after sample conversion on the reader thread */
+  unsigned int _decim;
+  cic_decimator *_cic;
+  gr_complex *_decim_buf; /* full rate staging ahead of the CIC */
+
+  /* raw capture and replay of the callback byte stream (record= and
+   * replay= arguments), arrival timestamps pace the replay */
+  FILE *_record_fp;
+  std::string _replay_file;
+  bool _wire_sc8; /* pass recentered 8 bit IQ through instead of fc32 */
+  size_t _item_size;
 
   rtlsdr_dev_t *_dev;
   gr::thread::thread _thread;
-  unsigned char **_buf;
+  ring_buffer *_ring;
   unsigned int _buf_num;
   unsigned int _buf_len;
-  unsigned int _buf_head;
-  unsigned int _buf_used;
-  boost::mutex _buf_mutex;
-  boost::condition_variable _buf_cond;
+  unsigned int _watermark; /* buffers work() waits for, watermark= arg */
+  double _buffer_ms; /* autosize the ring for this much buffering, 0 = fixed */
   bool _running;
+  bool _gated; /* armed by start_synchronized(), callback drops transfers */
 
   unsigned int _buf_offset;
   int _samp_avail;
@@ -142,6 +173,41 @@ private:
   bool _auto_gain;
   double _if_gain;
   unsigned int _skipped;
+
+  /* automatic direct sampling (auto_direct= argument): a retune below
+   * the tuner range switches the demod to direct sampling on the given
+   * branch with the async reader kept alive, a retune above switches
+   * back; the transition point is tagged in the stream */
+  int _auto_direct; /* branch to use below the tuner range, 0 = off */
+  int _cur_direct;  /* currently programmed direct sampling mode */
+  bool _mode_tag_pending; /* tag the first sample in the new mode */
+
+  /* scan mode: the block hops through _scan_freqs on its own */
+  std::vector<double> _scan_freqs;
+  size_t _scan_pos;
+  uint64_t _scan_dwell;     /* output samples produced per hop */
+  uint64_t _scan_settle;    /* settle samples dropped after each hop */
+  uint64_t _scan_remaining; /* output samples left at the current hop */
+  uint64_t _scan_skip;      /* stale samples still to be dropped */
+  bool _scan_tag_pending;   /* tag the first clean sample after a hop */
+
+  /* pending trim requested via skip_samples(), written by the control
+   * thread and consumed on the streaming path */
+  boost::atomic<uint64_t> _align_skip;
+
+  bool _time_tag_pending;    /* stamp rx_time/rx_rate on the next sample */
+  uint64_t _tagged_overruns; /* overrun count at the last stamp */
+
+  /* async tuner control (async_tune= argument): set_center_freq() hands
+   * the request over to a command thread and returns immediately,
+   * completion is published on the "tune_done" message port */
+  bool _async_tune;
+  bool _run_cmd_thread;
+  bool _tune_pending; /* latest request wins, older targets are stale */
+  double _tune_freq;
+  gr::thread::thread _cmd_worker;
+  boost::mutex _cmd_lock;
+  boost::condition_variable _cmd_cond;
 };
 
 #endif /* INCLUDED_RTLSDR_SOURCE_C_H */
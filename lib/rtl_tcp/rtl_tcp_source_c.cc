@@ -18,12 +18,14 @@
  * Boston, MA 02110-1301, USA.
  */
 
+#include <algorithm>
 #include <fstream>
 #include <string>
 #include <sstream>
 
 #include <boost/assign.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/thread/thread.hpp>
 
 #include <gnuradio/io_signature.h>
 
@@ -59,8 +61,6 @@ typedef ptrdiff_t ssize_t;
 #include <WinSock2.h>
 #endif
 
-#define BYTES_PER_SAMPLE  2 // rtl_tcp device delivers 8 bit unsigned IQ data
-
 /* copied from rtl sdr code */
 typedef struct { /* structure size must be multiple of 2 bytes */
   char magic[4];
@@ -148,7 +148,14 @@ rtl_tcp_source_c::rtl_tcp_source_c(const std::string &args) :
   d_socket(-1),
   _no_tuner(false),
   _auto_gain(false),
-  _if_gain(0)
+  _if_gain(0),
+  _wire_fmt(WIRE_FMT_CU8),
+  _bytes_per_sample(2),
+  _ring(NULL),
+  _buf_num(32),
+  _buf_len(16384),
+  _buf_offset(0),
+  _running(false)
 {
   std::string host = "127.0.0.1";
   unsigned short port = 1234;
@@ -177,6 +184,12 @@ rtl_tcp_source_c::rtl_tcp_source_c(const std::string &args) :
   if (dict.count("psize"))
     payload_size = boost::lexical_cast< int >( dict["psize"] );
 
+  if (dict.count("buffers"))
+    _buf_num = boost::lexical_cast< unsigned int >( dict["buffers"] );
+
+  if (0 == _buf_num)
+    _buf_num = 32;
+
   if (dict.count("direct_samp"))
     direct_samp = boost::lexical_cast< unsigned int >( dict["direct_samp"] );
 
@@ -186,6 +199,22 @@ rtl_tcp_source_c::rtl_tcp_source_c(const std::string &args) :
   if (dict.count("bias"))
     bias_tee = boost::lexical_cast<bool>( dict["bias"] );
 
+  enum wire_format wire_fmt_req = WIRE_FMT_CU8;
+
+  if (dict.count("wire_format")) {
+    std::string format = dict["wire_format"];
+
+    if ("cu8" == format)
+      wire_fmt_req = WIRE_FMT_CU8;
+    else if ("cs8" == format)
+      wire_fmt_req = WIRE_FMT_CS8;
+    else if ("cs16" == format)
+      wire_fmt_req = WIRE_FMT_CS16;
+    else
+      throw std::runtime_error(
+            "Wire format '" + format + "' not supported by rtl_tcp backend.");
+  }
+
   if (!host.length())
     host = "127.0.0.1";
 
@@ -222,10 +251,8 @@ rtl_tcp_source_c::rtl_tcp_source_c(const std::string &args) :
     report_error("rtl_tcp_source_f/getaddrinfo",
                  "can't initialize source socket" );
 
-  d_temp_buff = new unsigned char[payload_size];   // allow it to hold up to payload_size bytes
-  d_LUT = new float[0x100];
-  for (int i = 0; i < 0x100; ++i)
-    d_LUT[i] = (((float)(i & 0xff)) - 127.4f) * (1.0f / 128.0f);
+  _buf_len = payload_size;
+  _ring = new ring_buffer(_buf_num, _buf_len);
 
   // create socket
   d_socket = socket(ip_src->ai_family, ip_src->ai_socktype,
@@ -238,6 +265,13 @@ rtl_tcp_source_c::rtl_tcp_source_c(const std::string &args) :
   if (setsockopt(d_socket, SOL_SOCKET, SO_REUSEADDR, (optval_t)&opt_val, sizeof(int)) == -1)
     report_error("SO_REUSEADDR","can't set socket option SO_REUSEADDR");
 
+  // Oversize the kernel receive buffer: the reader thread drains it in
+  // large chunks and the headroom rides out scheduling hiccups on slow
+  // links without stalling the sender.
+  int rcvbuf = std::max( 1 << 20, int(_buf_num * _buf_len) );
+  if (setsockopt(d_socket, SOL_SOCKET, SO_RCVBUF, (optval_t)&rcvbuf, sizeof(rcvbuf)) == -1)
+    report_error("SO_RCVBUF", NULL);
+
   // Don't wait when shutting down
   linger lngr;
   lngr.l_onoff  = 1;
@@ -277,7 +311,12 @@ rtl_tcp_source_c::rtl_tcp_source_c(const std::string &args) :
   d_tuner_gain_count = 0;
   d_tuner_if_gain_count = 0;
 
-  if (memcmp(dongle_info.magic, "RTL0", 4) == 0) {
+  /* protocol extension: servers able to reframe the stream (SDRplay or
+   * Airspy backends with more than 8 ADC bits) announce themselves with
+   * the RTLX magic, the rest of the greeting matches RTL0 */
+  bool extended = (memcmp(dongle_info.magic, "RTLX", 4) == 0);
+
+  if (memcmp(dongle_info.magic, "RTL0", 4) == 0 || extended) {
     d_tuner_type = rtlsdr_tuner(ntohl(dongle_info.tuner_type));
     d_tuner_gain_count = ntohl(dongle_info.tuner_gain_count);
     if (RTLSDR_TUNER_E4000 == d_tuner_type)
@@ -310,12 +349,33 @@ rtl_tcp_source_c::rtl_tcp_source_c(const std::string &args) :
   // set bias tee
   cmd = { 0x0e, htonl(bias_tee) };
   send(d_socket, (const char*)&cmd, sizeof(cmd), 0);
+
+  if (WIRE_FMT_CU8 != wire_fmt_req && !extended) {
+    std::cerr << "The server does not announce the wire format extension, "
+              << "using classic 8 bit framing." << std::endl;
+    wire_fmt_req = WIRE_FMT_CU8;
+  }
+
+  if (WIRE_FMT_CU8 != wire_fmt_req) {
+    // set wire format, cs16 halves the WAN bytes versus shipping float
+    // while keeping the full ADC width of the server
+    cmd = { 0x77, htonl(wire_fmt_req) };
+    send(d_socket, (const char*)&cmd, sizeof(cmd), 0);
+  }
+
+  _wire_fmt = wire_fmt_req;
+  _bytes_per_sample = (WIRE_FMT_CS16 == _wire_fmt) ? 4 : 2;
 }
 
 rtl_tcp_source_c::~rtl_tcp_source_c()
 {
-  delete [] d_LUT;
-  delete [] d_temp_buff;
+  if (_thread.joinable()) {
+    _running = false;
+    shutdown(d_socket, SHUT_RDWR); /* unblocks the reader in recv() */
+    _thread.join();
+  }
+
+  delete _ring;
 
   if (d_socket != -1) {
     shutdown(d_socket, SHUT_RDWR);
@@ -334,29 +394,131 @@ rtl_tcp_source_c::~rtl_tcp_source_c()
 }
 
 
+bool rtl_tcp_source_c::start()
+{
+  _running = true;
+  _buf_offset = 0;
+  _thread = gr::thread::thread(_rtl_tcp_wait, this);
+
+  return true;
+}
+
+bool rtl_tcp_source_c::stop()
+{
+  _running = false;
+  _ring->notify();
+
+  if (_thread.joinable())
+    _thread.join();
+
+  return true;
+}
+
+void rtl_tcp_source_c::_rtl_tcp_wait(rtl_tcp_source_c *obj)
+{
+  obj->rtl_tcp_wait();
+}
+
+void rtl_tcp_source_c::rtl_tcp_wait()
+{
+  while (_running) {
+    unsigned char *buf = (unsigned char *)_ring->write_ptr();
+
+    if (!buf) {
+      /* the flowgraph stalled, wait for a free slot and let TCP flow
+       * control throttle the server in the meantime */
+      boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+      continue;
+    }
+
+    ssize_t received = recv(d_socket, (char *)buf, _buf_len, 0);
+
+    if (received <= 0) {
+      if (received == -1 && is_error(EAGAIN))
+        continue;
+      if (_running)
+        fprintf(stderr, "socket error\n");
+      break;
+    }
+
+    /* keep the slots sample aligned, a stray partial sample would shift
+     * I and Q for the rest of the stream */
+    while (received % _bytes_per_sample) {
+      ssize_t r = recv(d_socket, (char *)buf + received, 1, 0);
+
+      if (r != 1) {
+        if (r == -1 && is_error(EAGAIN))
+          continue;
+        /* connection is going down, drop the torn sample */
+        received -= received % _bytes_per_sample;
+        break;
+      }
+
+      received++;
+    }
+
+    if (!received)
+      break;
+
+    _ring->write_done(received);
+  }
+
+  _ring->notify();
+}
+
 int rtl_tcp_source_c::work(int noutput_items,
 			   gr_vector_const_void_star &input_items,
 			   gr_vector_void_star &output_items)
 {
   gr_complex *out = (gr_complex *)output_items[0];
-  int bytesleft = noutput_items * BYTES_PER_SAMPLE;
-  int index = 0;
-  int receivedbytes = 0;
-  while (bytesleft > 0) {
-    receivedbytes = recv(d_socket, (char*)&d_temp_buff[index], bytesleft, 0);
-
-    if (receivedbytes == -1 && !is_error(EAGAIN)) {
-      fprintf(stderr, "socket error\n");
-      return -1;
+  int produced = 0;
+
+  /* the reader thread keeps draining the socket while we convert the
+   * bytes buffered so far, so a network hiccup no longer stalls the
+   * whole flowgraph */
+  _ring->wait_for(1, _running);
+
+  while (produced < noutput_items) {
+    unsigned int buf_len = 0;
+    unsigned char *buf = (unsigned char *)_ring->read_ptr(&buf_len);
+
+    if (!buf) /* ring ran empty, deliver what we have */
+      break;
+
+    int samp_avail = (buf_len - _buf_offset) / _bytes_per_sample;
+    int nout = std::min(noutput_items - produced, samp_avail);
+
+    /* one vectorized convert per framing instead of per-sample work */
+    switch (_wire_fmt) {
+    case WIRE_FMT_CS8:
+      _converter.s8_fc32(&out[produced],
+                         (signed char *)buf + _buf_offset, nout);
+      break;
+    case WIRE_FMT_CS16:
+      /* servers left-align their ADC words, so 16 bit full scale holds
+       * for 12 and 14 bit backends alike */
+      _converter.s16_fc32(&out[produced],
+                          (short *)(buf + _buf_offset), nout);
+      break;
+    default:
+      _converter.u8_fc32(&out[produced], buf + _buf_offset, nout,
+                         0.6f / 128.0f);
+      break;
+    }
+
+    produced += nout;
+    _buf_offset += nout * _bytes_per_sample;
+
+    if (_buf_offset + _bytes_per_sample > buf_len) {
+      _ring->read_done();
+      _buf_offset = 0;
     }
-    bytesleft -= receivedbytes;
-    index += receivedbytes;
   }
 
-  for (int i = 0; i < noutput_items; i++)
-    out[i] = gr_complex(d_LUT[d_temp_buff[i * 2]], d_LUT[d_temp_buff[i * 2 + 1]]);
+  if (!produced && !_running)
+    return WORK_DONE;
 
-  return noutput_items;
+  return produced;
 }
 
 std::string rtl_tcp_source_c::name()
@@ -383,6 +545,21 @@ size_t rtl_tcp_source_c::get_num_channels( void )
   return 1;
 }
 
+uint64_t rtl_tcp_source_c::get_num_overflows( void )
+{
+  return _ring->num_overruns();
+}
+
+void rtl_tcp_source_c::reset_stream_stats( void )
+{
+  _ring->reset_overruns();
+}
+
+double rtl_tcp_source_c::get_buffer_level( void )
+{
+  return _ring->used() / (double)_ring->buf_num();
+}
+
 osmosdr::meta_range_t rtl_tcp_source_c::get_sample_rates( void )
 {
   osmosdr::meta_range_t range;
@@ -21,8 +21,11 @@
 #define RTL_TCP_SOURCE_C_H
 
 #include <gnuradio/sync_block.h>
+#include <gnuradio/thread/thread.h>
 
 #include "source_iface.h"
+#include "ring_buffer.h"
+#include "converter.h"
 
 class rtl_tcp_source_c;
 
@@ -46,6 +49,14 @@ private:
     RTLSDR_TUNER_R828D
   };
 
+  /* wire formats the protocol extension can negotiate, the values go
+   * out on the wire in the SET_WIRE_FORMAT command */
+  enum wire_format {
+    WIRE_FMT_CU8 = 0, /* classic rtl_tcp, unsigned 8 bit */
+    WIRE_FMT_CS8 = 1, /* signed 8 bit */
+    WIRE_FMT_CS16 = 2 /* signed 16 bit, full ADC width of the server */
+  };
+
   friend rtl_tcp_source_c_sptr make_rtl_tcp_source_c(const std::string &args);
 
   rtl_tcp_source_c(const std::string &args);
@@ -54,6 +65,9 @@ private:
 public:
   ~rtl_tcp_source_c();
 
+  bool start();
+  bool stop();
+
   int work(int noutput_items,
 	   gr_vector_const_void_star &input_items,
 	   gr_vector_void_star &output_items);
@@ -64,6 +78,10 @@ public:
 
   size_t get_num_channels( void );
 
+  uint64_t get_num_overflows( void );
+  void reset_stream_stats( void );
+  double get_buffer_level( void );
+
   osmosdr::meta_range_t get_sample_rates( void );
   double set_sample_rate( double rate );
   double get_sample_rate( void );
@@ -91,6 +109,9 @@ public:
   std::string get_antenna( size_t chan = 0 );
 
 private:
+  static void _rtl_tcp_wait(rtl_tcp_source_c *obj);
+  void rtl_tcp_wait();
+
   int d_socket;		  // handle to socket
   double _freq, _rate, _gain, _corr;
   bool _no_tuner;
@@ -100,8 +121,17 @@ private:
   enum rtlsdr_tuner d_tuner_type;
   unsigned int d_tuner_gain_count;
   unsigned int d_tuner_if_gain_count;
-  unsigned char *d_temp_buff; // hold buffer between calls
-  float *d_LUT;
+  sample_converter _converter; /* shared volk-backed conversion kernels */
+
+  enum wire_format _wire_fmt; /* negotiated framing of the stream */
+  unsigned int _bytes_per_sample;
+
+  gr::thread::thread _thread;
+  ring_buffer *_ring;
+  unsigned int _buf_num;
+  unsigned int _buf_len;
+  unsigned int _buf_offset;
+  bool _running;
 };
 
 #endif // RTL_TCP_SOURCE_C_H
@@ -128,10 +128,6 @@ rtl_tcp_source_f::rtl_tcp_source_f(size_t itemsize,
 
   // FIXME leaks if report_error throws below
   d_temp_buff = new unsigned char[d_payload_size];   // allow it to hold up to payload_size bytes
-  d_LUT= new float[0xff+1];
-  for(int i=0; i <=(0xff);++i){
-    d_LUT[i] = (((float)(i&0xff))-127.4f)*(1.0f/128.0f);
-  }
   // create socket
   d_socket = socket(ip_src->ai_family, ip_src->ai_socktype,
                     ip_src->ai_protocol);
@@ -253,8 +249,9 @@ int rtl_tcp_source_f::work (int noutput_items,
   }
   r = noutput_items;
 
-  for(int i=0; i<r; ++i)
-    out[i]=d_LUT[*(d_temp_buff+d_temp_offset+i)];
+  // same vectorized u8 -> float kernel as the complex flavor, the
+  // 127.4 wire center is folded in as a dc residual
+  d_converter.u8_f32(out, d_temp_buff + d_temp_offset, r, 0.6f/128.0f);
 
   return r;
 }
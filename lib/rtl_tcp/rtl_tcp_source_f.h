@@ -24,6 +24,8 @@
 #include <gnuradio/sync_block.h>
 #include <gnuradio/thread/thread.h>
 
+#include "converter.h"
+
 #if defined(_WIN32)
 // if not posix, assume winsock
 #pragma comment(lib, "ws2_32.lib")
@@ -79,7 +81,7 @@ private:
   int           d_socket;        // handle to socket
   unsigned char *d_temp_buff;    // hold buffer between calls
   size_t        d_temp_offset;   // point to temp buffer location offset
-  float         *d_LUT;
+  sample_converter d_converter;  // shared volk-backed conversion kernels
 
   unsigned int d_tuner_type;
   unsigned int d_tuner_gain_count;
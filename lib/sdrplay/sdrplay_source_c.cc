@@ -38,6 +38,7 @@
 
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
 #include <stdio.h>
 #include <math.h>
 
@@ -110,8 +111,9 @@ sdrplay_source_c::sdrplay_source_c (const std::string &args)
   : gr::sync_block ("sdrplay_source_c",
         gr::io_signature::make(MIN_IN, MAX_IN, sizeof (gr_complex)),
         gr::io_signature::make(MIN_OUT, MAX_OUT, sizeof (gr_complex))),
+    _ring(NULL),
+    _buf_offset(0),
     _running(false),
-    _uninit(false),
     _auto_gain(false)
 {
    _dev = (sdrplay_dev_t *)malloc(sizeof(sdrplay_dev_t));
@@ -129,12 +131,12 @@ sdrplay_source_c::sdrplay_source_c (const std::string &args)
    set_gain_limits(_dev->rfHz);
    _dev->gain_dB = _dev->maxGain - _dev->gRdB;
    
-   _bufi.reserve(SDRPLAY_MAX_BUF_SIZE);
-   _bufq.reserve(SDRPLAY_MAX_BUF_SIZE);   
+   _bufi.resize(SDRPLAY_MAX_BUF_SIZE);
+   _bufq.resize(SDRPLAY_MAX_BUF_SIZE);
 
-   _buf_mutex.lock();
-   _buf_offset = 0;
-   _buf_mutex.unlock();
+   /* already converted samples, handed from the reader thread to
+    * work() without taking a lock */
+   _ring = new ring_buffer(64, SDRPLAY_MAX_BUF_SIZE * sizeof(gr_complex));
 }
 
 /*
@@ -142,15 +144,97 @@ sdrplay_source_c::sdrplay_source_c (const std::string &args)
  */
 sdrplay_source_c::~sdrplay_source_c ()
 {
+   if (_running)
+   {
+      stop();
+   }
+
    free(_dev);
    _dev = NULL;
-   _buf_mutex.lock();
-   if (_running)
+
+   if (_ring)
    {
-      _running = false;
+      delete _ring;
+      _ring = NULL;
    }
-   _uninit = true;
-   _buf_mutex.unlock();
+}
+
+bool sdrplay_source_c::start()
+{
+   if (_dev == NULL)
+   {
+      return false;
+   }
+
+   reinit_device();
+
+   _buf_offset = 0;
+   _running = true;
+   _thread = gr::thread::thread(_sdrplay_wait, this);
+
+   return true;
+}
+
+bool sdrplay_source_c::stop()
+{
+   if (!_running)
+   {
+      return true;
+   }
+
+   _running = false;
+   _thread.join();
+
+   boost::mutex::scoped_lock lock(_buf_mutex);
+   mir_sdr_Uninit();
+
+   return true;
+}
+
+void sdrplay_source_c::_sdrplay_wait(sdrplay_source_c *obj)
+{
+   obj->sdrplay_wait();
+}
+
+void sdrplay_source_c::sdrplay_wait()
+{
+   unsigned int sampNum;
+   int grChanged;
+   int rfChanged;
+   int fsChanged;
+
+   while (_running)
+   {
+      int count;
+
+      {
+         /* only serializes the API against the setters, work() is
+          * never on the other side of this lock */
+         boost::mutex::scoped_lock lock(_buf_mutex);
+
+         mir_sdr_ReadPacket(_bufi.data(), _bufq.data(), &sampNum,
+                            &grChanged, &rfChanged, &fsChanged);
+         count = _dev->samplesPerPacket;
+      }
+
+      gr_complex *out = (gr_complex *)_ring->write_ptr();
+      if (out == NULL)
+      {
+         continue; /* ring full, drop the packet, "O" already printed */
+      }
+
+      /* convert here in the reader thread so work() is left with a
+       * plain block copy */
+      for (int i = 0; i < count; i++)
+      {
+         out[i] = gr_complex( float(_bufi[i]) * (1.0f/2048.0f),
+                              float(_bufq[i]) * (1.0f/2048.0f) );
+      }
+
+      _ring->write_done(count * sizeof(gr_complex));
+   }
+
+   _ring->notify();
 }
 
 void sdrplay_source_c::reinit_device()
@@ -173,7 +257,6 @@ void sdrplay_source_c::reinit_device()
       mir_sdr_SetDcMode(4, 1);
    }
 
-   _buf_offset = 0;
    _buf_mutex.unlock();
    std::cerr << "reinit_device end" << std::endl;
 }
@@ -212,57 +295,61 @@ int sdrplay_source_c::work( int noutput_items,
                             gr_vector_void_star &output_items )
 {
    gr_complex *out = (gr_complex *)output_items[0];
-   int cnt = noutput_items;
-   unsigned int sampNum;
-   int grChanged;
-   int rfChanged;
-   int fsChanged;
+   int produced = 0;
 
-   if (_uninit)
-   {
-      return WORK_DONE;
-   }
+   _ring->wait_for(1, _running);
 
    if (!_running)
    {
-      reinit_device();
-      _running = true;
+      return WORK_DONE;
    }
 
-   _buf_mutex.lock();
-
-   if (_buf_offset)
+   while (noutput_items)
    {
-      for (int i = _buf_offset; i < _dev->samplesPerPacket; i++)
+      unsigned int len;
+      gr_complex *buf = (gr_complex *)_ring->read_ptr(&len);
+
+      if (buf == NULL)
       {
-         *out++ = gr_complex( float(_bufi[i]) * (1.0f/2048.0f), float(_bufq[i]) * (1.0f/2048.0f) );
+         break;
       }
-      cnt -= (_dev->samplesPerPacket - _buf_offset);
-   }
 
-   while ((cnt - _dev->samplesPerPacket) >= 0)
-   {
-      mir_sdr_ReadPacket(_bufi.data(), _bufq.data(), &sampNum, &grChanged, &rfChanged, &fsChanged);
-      for (int i = 0; i < _dev->samplesPerPacket; i++)
+      unsigned int avail = len / sizeof(gr_complex) - _buf_offset;
+      unsigned int nout = std::min((unsigned int)noutput_items, avail);
+
+      memcpy(out, buf + _buf_offset, nout * sizeof(gr_complex));
+
+      out += nout;
+      produced += nout;
+      noutput_items -= nout;
+
+      if (nout == avail)
       {
-         *out++ = gr_complex( float(_bufi[i]) * (1.0f/2048.0f), float(_bufq[i]) * (1.0f/2048.0f) );
+         _ring->read_done();
+         _buf_offset = 0;
       }
-      cnt -= _dev->samplesPerPacket;
-   }
-
-   _buf_offset = 0;
-   if (cnt)
-   {
-      mir_sdr_ReadPacket(_bufi.data(), _bufq.data(), &sampNum, &grChanged, &rfChanged, &fsChanged);
-      for (int i = 0; i < cnt; i++)
+      else
       {
-         *out++ = gr_complex( float(_bufi[i]) * (1.0f/2048.0f), float(_bufq[i]) * (1.0f/2048.0f) );
+         _buf_offset += nout;
       }
-      _buf_offset = cnt;
    }
-   _buf_mutex.unlock();
 
-   return noutput_items;
+   return produced;
+}
+
+uint64_t sdrplay_source_c::get_num_overflows()
+{
+   return _ring->num_overruns();
+}
+
+void sdrplay_source_c::reset_stream_stats()
+{
+   _ring->reset_overruns();
+}
+
+double sdrplay_source_c::get_buffer_level()
+{
+   return _ring->used() / (double)_ring->buf_num();
 }
 
 std::vector<std::string> sdrplay_source_c::get_devices()
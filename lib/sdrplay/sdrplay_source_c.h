@@ -30,6 +30,7 @@
 #include "osmosdr/ranges.h"
 
 #include "source_iface.h"
+#include "ring_buffer.h"
 
 class sdrplay_source_c;
 typedef struct sdrplay_dev sdrplay_dev_t;
@@ -78,6 +79,9 @@ private:
 public:
    ~sdrplay_source_c ();	// public destructor
 
+   bool start();
+   bool stop();
+
    int work( int noutput_items,
             gr_vector_const_void_star &input_items,
             gr_vector_void_star &output_items );
@@ -86,6 +90,10 @@ public:
 
    size_t get_num_channels( void );
 
+   uint64_t get_num_overflows( void );
+   void reset_stream_stats( void );
+   double get_buffer_level( void );
+
    osmosdr::meta_range_t get_sample_rates( void );
    double set_sample_rate( double rate );
    double get_sample_rate( void );
@@ -120,16 +128,24 @@ public:
 private:
    void reinit_device(void);
    void set_gain_limits(double freq);
+   static void _sdrplay_wait(sdrplay_source_c *obj);
+   void sdrplay_wait();
 
    sdrplay_dev_t *_dev;
 
    std::vector< short > _bufi;
    std::vector< short > _bufq;
-   int _buf_offset;
+
+   /* serializes the mir_sdr API between the reader thread and the
+    * setters, the sample handoff itself goes through the lock-free
+    * ring and never contends with the flow graph */
    boost::mutex _buf_mutex;
 
+   gr::thread::thread _thread;
+   ring_buffer *_ring;
+   unsigned int _buf_offset; /* consumer offset into the front slot */
+
    bool _running;
-   bool _uninit;
    bool _auto_gain;
 };
 
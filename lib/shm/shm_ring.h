@@ -0,0 +1,61 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <stdint.h>
+
+/*
+ * Layout of the shared memory segment behind the shm= backend pair.
+ *
+ * A single publisher (shm_sink_c) owns the segment and appends
+ * post-conversion IQ samples to a ring of gr_complex; any number of
+ * consumer processes (shm_source_c) map the segment read-only and each
+ * follow the stream with their own private cursor. The publisher never
+ * waits for consumers: head only moves forward, and a consumer that
+ * fell more than one ring length behind detects this from the cursor
+ * distance, skips ahead and counts an overrun. Because a slow reader
+ * can race the writer over the region it is copying, consumers must
+ * re-check head after copying and discard the data if it was lapped
+ * (seqlock style), so no locks are shared across processes.
+ *
+ * head is published with a full barrier after the sample data is
+ * written, making the samples below it visible to other processes
+ * before the cursor moves.
+ */
+
+#define SHM_RING_MAGIC    0x4f534d31  /* "OSM1" */
+#define SHM_RING_VERSION  1
+
+/* keep the sample ring page aligned behind the header */
+#define SHM_RING_DATA_OFFSET  4096
+
+typedef struct
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t ring_len;     /* ring capacity in samples, power of two */
+  uint32_t active;       /* publisher attached and streaming */
+  double sample_rate;    /* stream metadata mirrored by the publisher */
+  double center_freq;
+  volatile uint64_t head; /* total samples published since creation */
+} shm_ring_header_t;
+
+#endif /* SHM_RING_H */
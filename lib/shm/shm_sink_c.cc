@@ -0,0 +1,305 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include <boost/assign.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <gnuradio/io_signature.h>
+
+#include "arg_helpers.h"
+#include "shm_sink_c.h"
+
+using namespace boost::assign;
+
+#define DEFAULT_SHM_NAME  "gr-osmosdr"
+#define DEFAULT_RING_LEN  (1 << 21) /* samples, 16 MiB of gr_complex */
+
+shm_sink_c_sptr make_shm_sink_c( const std::string &args )
+{
+  return gnuradio::get_initial_sptr( new shm_sink_c(args) );
+}
+
+shm_sink_c::shm_sink_c( const std::string &args ) :
+    gr::sync_block( "shm_sink_c",
+                    gr::io_signature::make(1, 1, sizeof(gr_complex)),
+                    gr::io_signature::make(0, 0, 0) ),
+    _fd(-1),
+    _hdr(NULL),
+    _ring(NULL),
+    _ring_len(DEFAULT_RING_LEN),
+    _freq(0),
+    _rate(0),
+    _corr(0),
+    _gain_val(0)
+{
+  std::string name = DEFAULT_SHM_NAME;
+
+  dict_t dict = params_to_dict(args);
+
+  if ( dict.count("shm") && dict["shm"].length() )
+    name = dict["shm"];
+
+  if ( dict.count("shm_len") )
+    _ring_len = boost::lexical_cast< uint32_t >( dict["shm_len"] );
+
+  /* the cursor arithmetic masks with ring_len - 1 */
+  if ( _ring_len < 4096 || _ring_len & (_ring_len - 1) )
+    throw std::runtime_error("Ring length (shm_len) must be a power of two "
+                             ">= 4096 samples");
+
+  if ( dict.count("freq") )
+    _freq = boost::lexical_cast< double >( dict["freq"] );
+
+  if ( dict.count("rate") )
+    _rate = boost::lexical_cast< double >( dict["rate"] );
+
+  _name = "/" + name;
+
+  /* a stale segment of a crashed publisher is simply replaced */
+  _fd = shm_open( _name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644 );
+  if ( _fd < 0 )
+    throw std::runtime_error("Could not create shared memory object " +
+                             _name + ": " + std::string(strerror(errno)));
+
+  size_t total = SHM_RING_DATA_OFFSET + (size_t)_ring_len * sizeof(gr_complex);
+
+  if ( ftruncate( _fd, total ) < 0 )
+  {
+    close(_fd);
+    shm_unlink( _name.c_str() );
+    throw std::runtime_error("Could not size shared memory object " + _name);
+  }
+
+  void *base = mmap( NULL, total, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     _fd, 0 );
+  if ( MAP_FAILED == base )
+  {
+    close(_fd);
+    shm_unlink( _name.c_str() );
+    throw std::runtime_error("Could not map shared memory object " + _name);
+  }
+
+  _hdr = (shm_ring_header_t *)base;
+  _ring = (gr_complex *)((unsigned char *)base + SHM_RING_DATA_OFFSET);
+
+  _hdr->version = SHM_RING_VERSION;
+  _hdr->ring_len = _ring_len;
+  _hdr->sample_rate = _rate;
+  _hdr->center_freq = _freq;
+  _hdr->head = 0;
+  _hdr->active = 1;
+
+  /* consumers validate the magic last, after the rest of the header
+   * is in place */
+  __sync_synchronize();
+  _hdr->magic = SHM_RING_MAGIC;
+
+  std::cerr << "Publishing IQ stream in shared memory " << _name
+            << " (" << _ring_len << " samples)" << std::endl;
+}
+
+shm_sink_c::~shm_sink_c()
+{
+  if ( _hdr )
+  {
+    _hdr->active = 0; /* consumers drain and report end of stream */
+
+    munmap( (void *)_hdr,
+            SHM_RING_DATA_OFFSET + (size_t)_ring_len * sizeof(gr_complex) );
+  }
+
+  if ( _fd >= 0 )
+    close(_fd);
+
+  /* drop the name; consumers that are still mapped keep the segment
+   * alive until they unmap it */
+  shm_unlink( _name.c_str() );
+}
+
+int shm_sink_c::work( int noutput_items,
+                      gr_vector_const_void_star &input_items,
+                      gr_vector_void_star &output_items )
+{
+  const gr_complex *in = (const gr_complex *)input_items[0];
+
+  uint64_t head = _hdr->head;
+  uint32_t pos = head & (_ring_len - 1);
+  int remaining = noutput_items;
+
+  while ( remaining )
+  {
+    uint32_t ncopy = std::min( (uint32_t)remaining, _ring_len - pos );
+
+    memcpy( _ring + pos, in, ncopy * sizeof(gr_complex) );
+
+    in += ncopy;
+    remaining -= ncopy;
+    pos = 0; /* a second pass can only be the wrap around */
+  }
+
+  /* publish the samples before moving the cursor */
+  __sync_synchronize();
+  _hdr->head = head + noutput_items;
+
+  return noutput_items;
+}
+
+std::string shm_sink_c::name()
+{
+  return "IQ Shared Memory sink";
+}
+
+std::vector<std::string> shm_sink_c::get_devices( bool fake )
+{
+  std::vector<std::string> devices;
+
+  if ( fake )
+  {
+    std::string args = "shm='" DEFAULT_SHM_NAME "'";
+    args += ",label='Complex Sampled (IQ) Shared Memory'";
+    devices.push_back( args );
+  }
+
+  return devices;
+}
+
+size_t shm_sink_c::get_num_channels( void )
+{
+  return 1;
+}
+
+osmosdr::meta_range_t shm_sink_c::get_sample_rates( void )
+{
+  osmosdr::meta_range_t range;
+
+  range += osmosdr::range_t( _rate, _rate );
+
+  return range;
+}
+
+double shm_sink_c::set_sample_rate( double rate )
+{
+  _rate = rate;
+  _hdr->sample_rate = rate; /* mirrored for the consumers */
+
+  return get_sample_rate();
+}
+
+double shm_sink_c::get_sample_rate( void )
+{
+  return _rate;
+}
+
+osmosdr::freq_range_t shm_sink_c::get_freq_range( size_t chan )
+{
+  return osmosdr::freq_range_t(_freq, _freq);
+}
+
+double shm_sink_c::set_center_freq( double freq, size_t chan )
+{
+  _freq = freq;
+  _hdr->center_freq = freq; /* mirrored for the consumers */
+
+  return get_center_freq(chan);
+}
+
+double shm_sink_c::get_center_freq( size_t chan )
+{
+  return _freq;
+}
+
+double shm_sink_c::set_freq_corr( double ppm, size_t chan )
+{
+  _corr = ppm;
+
+  return get_freq_corr( chan );
+}
+
+double shm_sink_c::get_freq_corr( size_t chan )
+{
+  return _corr;
+}
+
+std::vector<std::string> shm_sink_c::get_gain_names( size_t chan )
+{
+  return std::vector< std::string >();
+}
+
+osmosdr::gain_range_t shm_sink_c::get_gain_range( size_t chan )
+{
+  return osmosdr::gain_range_t();
+}
+
+osmosdr::gain_range_t shm_sink_c::get_gain_range( const std::string & name, size_t chan )
+{
+  return get_gain_range( chan );
+}
+
+double shm_sink_c::set_gain( double gain, size_t chan )
+{
+  _gain_val = gain;
+
+  return get_gain(chan);
+}
+
+double shm_sink_c::set_gain( double gain, const std::string & name, size_t chan )
+{
+  return set_gain( gain, chan );
+}
+
+double shm_sink_c::get_gain( size_t chan )
+{
+  return _gain_val;
+}
+
+double shm_sink_c::get_gain( const std::string & name, size_t chan )
+{
+  return get_gain( chan );
+}
+
+std::vector< std::string > shm_sink_c::get_antennas( size_t chan )
+{
+  return std::vector< std::string >();
+}
+
+std::string shm_sink_c::set_antenna( const std::string & antenna, size_t chan )
+{
+  return get_antenna( chan );
+}
+
+std::string shm_sink_c::get_antenna( size_t chan )
+{
+  return "";
+}
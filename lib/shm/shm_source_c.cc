@@ -0,0 +1,366 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include <boost/assign.hpp>
+#include <boost/chrono.hpp>
+#include <boost/thread.hpp>
+
+#include <gnuradio/io_signature.h>
+
+#include "arg_helpers.h"
+#include "shm_source_c.h"
+
+using namespace boost::assign;
+
+#define DEFAULT_SHM_NAME  "gr-osmosdr"
+
+shm_source_c_sptr make_shm_source_c( const std::string &args )
+{
+  return gnuradio::get_initial_sptr( new shm_source_c(args) );
+}
+
+shm_source_c::shm_source_c( const std::string &args ) :
+    gr::sync_block( "shm_source_c",
+                    gr::io_signature::make(0, 0, 0),
+                    gr::io_signature::make(1, 1, sizeof(gr_complex)) ),
+    _fd(-1),
+    _hdr(NULL),
+    _ring(NULL),
+    _ring_len(0),
+    _tail(0),
+    _running(false),
+    _overflows(0)
+{
+  std::string name = DEFAULT_SHM_NAME;
+
+  dict_t dict = params_to_dict(args);
+
+  if ( dict.count("shm") && dict["shm"].length() )
+    name = dict["shm"];
+
+  _name = "/" + name;
+
+  _fd = shm_open( _name.c_str(), O_RDONLY, 0 );
+  if ( _fd < 0 )
+    throw std::runtime_error("No shared memory publisher found at " +
+                             _name + ": " + std::string(strerror(errno)));
+
+  struct stat sb;
+  if ( fstat( _fd, &sb ) < 0 ||
+       sb.st_size < (off_t)SHM_RING_DATA_OFFSET )
+  {
+    close(_fd);
+    throw std::runtime_error("Shared memory object " + _name +
+                             " is not a gr-osmosdr stream");
+  }
+
+  void *base = mmap( NULL, sb.st_size, PROT_READ, MAP_SHARED, _fd, 0 );
+  if ( MAP_FAILED == base )
+  {
+    close(_fd);
+    throw std::runtime_error("Could not map shared memory object " + _name);
+  }
+
+  _hdr = (const shm_ring_header_t *)base;
+
+  if ( SHM_RING_MAGIC != _hdr->magic ||
+       SHM_RING_VERSION != _hdr->version ||
+       sb.st_size != (off_t)(SHM_RING_DATA_OFFSET +
+                             (size_t)_hdr->ring_len * sizeof(gr_complex)) )
+  {
+    munmap( base, sb.st_size );
+    close(_fd);
+    throw std::runtime_error("Shared memory object " + _name +
+                             " is not a gr-osmosdr stream");
+  }
+
+  _ring_len = _hdr->ring_len;
+  _ring = (const gr_complex *)((const unsigned char *)base +
+                               SHM_RING_DATA_OFFSET);
+
+  std::cerr << "Consuming IQ stream from shared memory " << _name
+            << " (" << _ring_len << " samples)" << std::endl;
+}
+
+shm_source_c::~shm_source_c()
+{
+  if ( _hdr )
+    munmap( (void *)_hdr,
+            SHM_RING_DATA_OFFSET + (size_t)_ring_len * sizeof(gr_complex) );
+
+  if ( _fd >= 0 )
+    close(_fd);
+}
+
+bool shm_source_c::start()
+{
+  _tail = _hdr->head; /* attach live, not at the stale ring content */
+  _running = true;
+
+  return true;
+}
+
+bool shm_source_c::stop()
+{
+  _running = false;
+
+  return true;
+}
+
+int shm_source_c::work( int noutput_items,
+                        gr_vector_const_void_star &input_items,
+                        gr_vector_void_star &output_items )
+{
+  gr_complex *out = (gr_complex *)output_items[0];
+
+  /* wait for samples; a vanished publisher with a drained ring is the
+   * end of the stream */
+  uint64_t head = _hdr->head;
+
+  while ( _running && head == _tail )
+  {
+    if ( ! _hdr->active )
+      return WORK_DONE;
+
+    boost::this_thread::sleep_for(boost::chrono::microseconds(100));
+    head = _hdr->head;
+  }
+
+  if ( ! _running )
+    return WORK_DONE;
+
+  for (;;)
+  {
+    if ( head - _tail > _ring_len )
+    {
+      /* lapped by the publisher, resume at the freshest half ring */
+      _tail = head - _ring_len / 2;
+
+      _overflows.fetch_add(1, boost::memory_order_relaxed);
+      std::cerr << "O" << std::flush;
+    }
+
+    int navail = (int)std::min( head - _tail, (uint64_t)noutput_items );
+    uint32_t pos = _tail & (_ring_len - 1);
+    int produced = 0;
+
+    while ( produced < navail )
+    {
+      uint32_t ncopy = std::min( (uint32_t)(navail - produced),
+                                 _ring_len - pos );
+
+      memcpy( out + produced, _ring + pos, ncopy * sizeof(gr_complex) );
+
+      produced += ncopy;
+      pos = 0; /* a second pass can only be the wrap around */
+    }
+
+    /* re-check the cursor: if the publisher lapped us while copying,
+     * the samples may be torn - resync and copy fresh ones instead */
+    __sync_synchronize();
+    head = _hdr->head;
+
+    if ( head - _tail <= _ring_len )
+    {
+      _tail += navail;
+
+      return navail;
+    }
+  }
+}
+
+std::string shm_source_c::name()
+{
+  return "IQ Shared Memory source";
+}
+
+std::vector<std::string> shm_source_c::get_devices( bool fake )
+{
+  std::vector<std::string> devices;
+
+#ifdef __linux__
+  /* every published stream is a regular file under /dev/shm, identify
+   * ours by the magic in the segment header */
+  DIR *dir = opendir( "/dev/shm" );
+  if ( dir )
+  {
+    struct dirent *ent;
+
+    while ( (ent = readdir( dir )) )
+    {
+      std::string name( ent->d_name );
+
+      if ( "." == name || ".." == name )
+        continue;
+
+      int fd = shm_open( ("/" + name).c_str(), O_RDONLY, 0 );
+      if ( fd < 0 )
+        continue;
+
+      shm_ring_header_t hdr;
+      bool valid = read( fd, &hdr, sizeof(hdr) ) == (int)sizeof(hdr) &&
+                   SHM_RING_MAGIC == hdr.magic &&
+                   SHM_RING_VERSION == hdr.version;
+      close(fd);
+
+      if ( valid )
+        devices.push_back( "shm='" + name + "'" +
+                           ",label='Shared Memory IQ Stream " + name + "'" );
+    }
+
+    closedir( dir );
+  }
+#endif
+
+  if ( devices.empty() && fake )
+    devices.push_back( "shm='" DEFAULT_SHM_NAME "'"
+                       ",label='Complex Sampled (IQ) Shared Memory'" );
+
+  return devices;
+}
+
+size_t shm_source_c::get_num_channels( void )
+{
+  return 1;
+}
+
+uint64_t shm_source_c::get_num_overflows( void )
+{
+  return _overflows.load(boost::memory_order_relaxed);
+}
+
+void shm_source_c::reset_stream_stats( void )
+{
+  _overflows.store(0, boost::memory_order_relaxed);
+}
+
+osmosdr::meta_range_t shm_source_c::get_sample_rates( void )
+{
+  osmosdr::meta_range_t range;
+
+  range += osmosdr::range_t( get_sample_rate() );
+
+  return range;
+}
+
+double shm_source_c::set_sample_rate( double rate )
+{
+  if ( rate != get_sample_rate() )
+    std::cerr << "WARNING: The sample rate is fixed by the publisher."
+              << std::endl;
+
+  return get_sample_rate();
+}
+
+double shm_source_c::get_sample_rate( void )
+{
+  return _hdr->sample_rate;
+}
+
+osmosdr::freq_range_t shm_source_c::get_freq_range( size_t chan )
+{
+  return osmosdr::freq_range_t( get_center_freq(), get_center_freq() );
+}
+
+double shm_source_c::set_center_freq( double freq, size_t chan )
+{
+  return get_center_freq(chan); /* tuning is up to the publisher */
+}
+
+double shm_source_c::get_center_freq( size_t chan )
+{
+  return _hdr->center_freq;
+}
+
+double shm_source_c::set_freq_corr( double ppm, size_t chan )
+{
+  return get_freq_corr( chan );
+}
+
+double shm_source_c::get_freq_corr( size_t chan )
+{
+  return 0;
+}
+
+std::vector<std::string> shm_source_c::get_gain_names( size_t chan )
+{
+  return std::vector< std::string >();
+}
+
+osmosdr::gain_range_t shm_source_c::get_gain_range( size_t chan )
+{
+  return osmosdr::gain_range_t();
+}
+
+osmosdr::gain_range_t shm_source_c::get_gain_range( const std::string & name, size_t chan )
+{
+  return get_gain_range( chan );
+}
+
+double shm_source_c::set_gain( double gain, size_t chan )
+{
+  return get_gain(chan);
+}
+
+double shm_source_c::set_gain( double gain, const std::string & name, size_t chan )
+{
+  return get_gain( name, chan );
+}
+
+double shm_source_c::get_gain( size_t chan )
+{
+  return 0;
+}
+
+double shm_source_c::get_gain( const std::string & name, size_t chan )
+{
+  return get_gain( chan );
+}
+
+std::vector< std::string > shm_source_c::get_antennas( size_t chan )
+{
+  return std::vector< std::string >();
+}
+
+std::string shm_source_c::set_antenna( const std::string & antenna, size_t chan )
+{
+  return get_antenna( chan );
+}
+
+std::string shm_source_c::get_antenna( size_t chan )
+{
+  return "";
+}
@@ -0,0 +1,109 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef SHM_SOURCE_C_H
+#define SHM_SOURCE_C_H
+
+#include <gnuradio/sync_block.h>
+
+#include <boost/atomic.hpp>
+
+#include "source_iface.h"
+#include "shm_ring.h"
+
+class shm_source_c;
+
+typedef boost::shared_ptr< shm_source_c > shm_source_c_sptr;
+
+shm_source_c_sptr make_shm_source_c( const std::string & args = "" );
+
+/*!
+ * \brief Consumes an IQ stream published in shared memory.
+ *
+ * Maps the segment of a shm_sink_c publisher (shm=name) read-only and
+ * follows its broadcast ring with a private cursor, delivering the
+ * full-rate stream without a copy through the kernel. Falling more
+ * than one ring length behind the publisher is detected from the
+ * cursor distance; the block then skips ahead and counts an overrun.
+ * Rate and frequency come from the metadata the publisher mirrors
+ * into the segment header, the setters are therefore read-only stubs.
+ */
+class shm_source_c :
+    public gr::sync_block,
+    public source_iface
+{
+private:
+  friend shm_source_c_sptr make_shm_source_c(const std::string &args);
+
+  shm_source_c(const std::string &args);
+
+public:
+  ~shm_source_c();
+
+  bool start();
+  bool stop();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  std::string name();
+
+  static std::vector< std::string > get_devices( bool fake = false );
+
+  size_t get_num_channels( void );
+
+  uint64_t get_num_overflows( void );
+  void reset_stream_stats( void );
+
+  osmosdr::meta_range_t get_sample_rates( void );
+  double set_sample_rate( double rate );
+  double get_sample_rate( void );
+
+  osmosdr::freq_range_t get_freq_range( size_t chan = 0 );
+  double set_center_freq( double freq, size_t chan = 0 );
+  double get_center_freq( size_t chan = 0 );
+  double set_freq_corr( double ppm, size_t chan = 0 );
+  double get_freq_corr( size_t chan = 0 );
+
+  std::vector<std::string> get_gain_names( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( const std::string & name, size_t chan = 0 );
+  double set_gain( double gain, size_t chan = 0 );
+  double set_gain( double gain, const std::string & name, size_t chan = 0 );
+  double get_gain( size_t chan = 0 );
+  double get_gain( const std::string & name, size_t chan = 0 );
+
+  std::vector< std::string > get_antennas( size_t chan = 0 );
+  std::string set_antenna( const std::string & antenna, size_t chan = 0 );
+  std::string get_antenna( size_t chan = 0 );
+
+private:
+  std::string _name;            /* shared memory object name, "/..." */
+  int _fd;
+  const shm_ring_header_t *_hdr;
+  const gr_complex *_ring;      /* sample ring behind the header */
+  uint32_t _ring_len;           /* ring capacity in samples */
+
+  uint64_t _tail;               /* private read cursor */
+  bool _running;
+  boost::atomic<uint64_t> _overflows;
+};
+
+#endif // SHM_SOURCE_C_H
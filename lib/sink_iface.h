@@ -25,6 +25,8 @@
 #include <osmosdr/time_spec.h>
 #include <gnuradio/basic_block.h>
 
+#include <stdint.h>
+
 /*!
  * TODO: document
  *
@@ -38,6 +40,30 @@ public:
    */
   virtual size_t get_num_channels( void ) = 0;
 
+  /*!
+   * Get the number of overflow events, i.e. samples the driver had to
+   * drop because they could not be handed to the device or medium in
+   * time, since stream start or the last reset_stream_stats() call.
+   * Maintained with relaxed atomics on the streaming path, so polling
+   * it is free. Drivers without overflow detection always return 0.
+   * \return the number of overflow events
+   */
+  virtual uint64_t get_num_overflows( void ) { return 0; }
+
+  /*!
+   * Get the number of underflow events, i.e. the device ran out of
+   * samples to transmit, since stream start or the last
+   * reset_stream_stats() call. Drivers without underflow detection
+   * always return 0.
+   * \return the number of underflow events
+   */
+  virtual uint64_t get_num_underflows( void ) { return 0; }
+
+  /*!
+   * Reset the overflow/underflow counters to zero.
+   */
+  virtual void reset_stream_stats( void ) { }
+
   /*!
    * Get the possible sample rates for the underlying radio hardware.
    * \return a range of rates in Sps
@@ -29,6 +29,9 @@
 
 #include <gnuradio/io_signature.h>
 #include <gnuradio/constants.h>
+#include <gnuradio/blocks/interleaved_char_to_complex.h>
+#include <gnuradio/blocks/interleaved_short_to_complex.h>
+#include <gnuradio/blocks/multiply_const_cc.h>
 
 #ifdef ENABLE_UHD
 #include "uhd_sink_c.h"
@@ -51,6 +54,12 @@
 #ifdef ENABLE_FILE
 #include "file_sink_c.h"
 #endif
+#ifdef ENABLE_SHM
+#include "shm_sink_c.h"
+#endif
+#ifdef ENABLE_UDP
+#include "udp_sink_c.h"
+#endif
 
 #include "arg_helpers.h"
 #include "sink_impl.h"
@@ -79,6 +88,18 @@ sink_impl::sink_impl( const std::string &args )
 
   std::vector< std::string > arg_list = args_to_vector(args);
 
+  /* wire_format=sc16/sc8 lets transmit chains feed interleaved integer
+   * IQ (e.g. stored modulated bursts) directly: the input signature
+   * follows the format in args_to_io_signature() above and the samples
+   * are inflated to complex float once, in the conversion stage wired
+   * in below, instead of the application upconverting the whole stream */
+  size_t wire_item_size = sizeof(gr_complex);
+  BOOST_FOREACH( std::string arg, arg_list ) {
+    dict_t dict = params_to_dict(arg);
+    if (dict.count("wire_format"))
+      wire_item_size = wire_format_item_size( dict["wire_format"] );
+  }
+
   std::vector< std::string > dev_types;
 
 #ifdef ENABLE_UHD
@@ -102,6 +123,12 @@ sink_impl::sink_impl( const std::string &args )
 #ifdef ENABLE_FILE
   dev_types.push_back("file");
 #endif
+#ifdef ENABLE_SHM
+  dev_types.push_back("shm");
+#endif
+#ifdef ENABLE_UDP
+  dev_types.push_back("udp");
+#endif
 
   std::cerr << "gr-osmosdr "
             << GR_OSMOSDR_VERSION << " (" << GR_OSMOSDR_LIBVER << ") "
@@ -122,34 +149,44 @@ sink_impl::sink_impl( const std::string &args )
   }
 
   if ( ! device_specified ) {
+    /* only the first hit is ever used below, so stop probing as soon
+     * as one backend reports a device and leave the remaining (often
+     * heavy to load) backends untouched */
     std::vector< std::string > dev_list;
 #ifdef ENABLE_UHD
-    BOOST_FOREACH( std::string dev, uhd_sink_c::get_devices() )
-      dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      BOOST_FOREACH( std::string dev, uhd_sink_c::get_devices() )
+        dev_list.push_back( dev );
 #endif
 #ifdef ENABLE_BLADERF
-    BOOST_FOREACH( std::string dev, bladerf_sink_c::get_devices() )
-      dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      BOOST_FOREACH( std::string dev, bladerf_sink_c::get_devices() )
+        dev_list.push_back( dev );
 #endif
 #ifdef ENABLE_HACKRF
-    BOOST_FOREACH( std::string dev, hackrf_sink_c::get_devices() )
-      dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      BOOST_FOREACH( std::string dev, hackrf_sink_c::get_devices() )
+        dev_list.push_back( dev );
 #endif
 #ifdef ENABLE_SOAPY
-    BOOST_FOREACH( std::string dev, soapy_sink_c::get_devices() )
-      dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      BOOST_FOREACH( std::string dev, soapy_sink_c::get_devices() )
+        dev_list.push_back( dev );
 #endif
 #ifdef ENABLE_REDPITAYA
-    BOOST_FOREACH( std::string dev, redpitaya_sink_c::get_devices() )
-      dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      BOOST_FOREACH( std::string dev, redpitaya_sink_c::get_devices() )
+        dev_list.push_back( dev );
 #endif
 #ifdef ENABLE_FREESRP
-    BOOST_FOREACH( std::string dev, freesrp_sink_c::get_devices() )
-      dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      BOOST_FOREACH( std::string dev, freesrp_sink_c::get_devices() )
+        dev_list.push_back( dev );
 #endif
 #ifdef ENABLE_FILE
-    BOOST_FOREACH( std::string dev, file_sink_c::get_devices() )
-      dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      BOOST_FOREACH( std::string dev, file_sink_c::get_devices() )
+        dev_list.push_back( dev );
 #endif
 
 //    std::cerr << std::endl;
@@ -216,11 +253,45 @@ sink_impl::sink_impl( const std::string &args )
     }
 #endif
 
+#ifdef ENABLE_SHM
+    if ( dict.count("shm") ) {
+      shm_sink_c_sptr sink = make_shm_sink_c( arg );
+      block = sink; iface = sink.get();
+    }
+#endif
+
+#ifdef ENABLE_UDP
+    if ( dict.count("udp") ) {
+      udp_sink_c_sptr sink = make_udp_sink_c( arg );
+      block = sink; iface = sink.get();
+    }
+#endif
+
     if ( iface != NULL && long(block.get()) != 0 ) {
       _devs.push_back( iface );
 
       for (size_t i = 0; i < iface->get_num_channels(); i++) {
-        connect(self(), channel++, block, i);
+        if ( 2 * sizeof(short) == wire_item_size ) {
+          gr::blocks::interleaved_short_to_complex::sptr conv =
+              gr::blocks::interleaved_short_to_complex::make( true );
+          gr::blocks::multiply_const_cc::sptr scale =
+              gr::blocks::multiply_const_cc::make( gr_complex(1.0f/32768.0f, 0) );
+
+          connect(self(), channel++, conv, 0);
+          connect(conv, 0, scale, 0);
+          connect(scale, 0, block, i);
+        } else if ( 2 * sizeof(char) == wire_item_size ) {
+          gr::blocks::interleaved_char_to_complex::sptr conv =
+              gr::blocks::interleaved_char_to_complex::make( true );
+          gr::blocks::multiply_const_cc::sptr scale =
+              gr::blocks::multiply_const_cc::make( gr_complex(1.0f/128.0f, 0) );
+
+          connect(self(), channel++, conv, 0);
+          connect(conv, 0, scale, 0);
+          connect(scale, 0, block, i);
+        } else {
+          connect(self(), channel++, block, i);
+        }
       }
     } else if ( (iface != NULL) || (long(block.get()) != 0) )
       throw std::runtime_error("Either iface or block are NULL.");
@@ -241,6 +312,32 @@ size_t sink_impl::get_num_channels()
   return channels;
 }
 
+uint64_t sink_impl::get_num_overflows()
+{
+  uint64_t overflows = 0;
+
+  BOOST_FOREACH( sink_iface *dev, _devs )
+    overflows += dev->get_num_overflows();
+
+  return overflows;
+}
+
+uint64_t sink_impl::get_num_underflows()
+{
+  uint64_t underflows = 0;
+
+  BOOST_FOREACH( sink_iface *dev, _devs )
+    underflows += dev->get_num_underflows();
+
+  return underflows;
+}
+
+void sink_impl::reset_stream_stats()
+{
+  BOOST_FOREACH( sink_iface *dev, _devs )
+    dev->reset_stream_stats();
+}
+
 #define NO_DEVICES_MSG  "FATAL: No device(s) available to work with."
 
 osmosdr::meta_range_t sink_impl::get_sample_rates()
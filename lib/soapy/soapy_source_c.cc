@@ -30,6 +30,7 @@
 
 #include <iostream>
 #include <algorithm> //find
+#include <cstring> //memcpy
 
 #include <boost/assign.hpp>
 #include <boost/format.hpp>
@@ -43,6 +44,10 @@
 #include "osmosdr/source.h"
 #include <SoapySDR/Device.hpp>
 #include <SoapySDR/Version.hpp>
+#include <SoapySDR/Errors.hpp>
+#include <SoapySDR/Formats.hpp>
+
+#include <volk/volk.h>
 
 using namespace boost::assign;
 
@@ -61,7 +66,8 @@ soapy_source_c_sptr make_soapy_source_c (const std::string &args)
 soapy_source_c::soapy_source_c (const std::string &args)
   : gr::sync_block ("soapy_source_c",
                     gr::io_signature::make (0, 0, 0),
-                    args_to_io_signature(args))
+                    args_to_io_signature(args)),
+    _overflows(0)
 {
     {
         boost::mutex::scoped_lock l(get_soapy_maker_mutex());
@@ -70,11 +76,79 @@ soapy_source_c::soapy_source_c (const std::string &args)
     _nchan = std::max(1, args_to_io_signature(args)->max_streams());
     std::vector<size_t> channels;
     for (size_t i = 0; i < _nchan; i++) channels.push_back(i);
-    _stream = _device->setupStream(SOAPY_SDR_RX, "CF32", channels);
+
+    _format = SOAPY_SDR_CF32;
+    _fullscale = 1.0;
+    _native_items = 0;
+    _native_bufs.resize(_nchan, NULL);
+
+    dict_t dict = params_to_dict(args);
+    bool native = true;
+    if (dict.count("native"))
+        native = !("off" == dict["native"] || "0" == dict["native"]);
+
+    bool direct = true;
+    if (dict.count("direct"))
+        direct = !("off" == dict["direct"] || "0" == dict["direct"]);
+
+    /* stream in the device's native format when we can convert it
+     * ourselves, this skips the float conversion inside the soapy
+     * driver and leaves one vectorized convert in this block */
+    if (native)
+    {
+        double fullscale = 0.0;
+        std::string fmt = _device->getNativeStreamFormat(SOAPY_SDR_RX, 0, fullscale);
+
+        bool same = true;
+        for (size_t i = 1; i < _nchan; i++)
+        {
+            double ignored = 0.0;
+            if (_device->getNativeStreamFormat(SOAPY_SDR_RX, i, ignored) != fmt)
+                same = false;
+        }
+
+        if (same && (SOAPY_SDR_CS16 == fmt || SOAPY_SDR_CS8 == fmt))
+        {
+            std::vector<std::string> formats =
+                _device->getStreamFormats(SOAPY_SDR_RX, 0);
+
+            if (std::find(formats.begin(), formats.end(), fmt) != formats.end())
+            {
+                _format = fmt;
+                _fullscale = fullscale;
+                std::cerr << "Using native stream format " << _format
+                          << " with full scale " << _fullscale << std::endl;
+            }
+        }
+    }
+
+    _stream = _device->setupStream(SOAPY_SDR_RX, _format, channels);
+
+    /* zero-copy streaming: acquire the driver's DMA buffers and convert
+     * straight into the output buffers, skipping the copy readStream
+     * performs.  Only usable when the driver exports its buffers. */
+    _direct = direct && (_device->getNumDirectAccessBuffers(_stream) > 0);
+    _direct_handle = 0;
+    _direct_bufs.resize(_nchan, NULL);
+    _direct_avail = 0;
+    _direct_offset = 0;
+
+    if (_direct)
+        std::cerr << "Using zero-copy direct access buffers" << std::endl;
+
+    /* Set up constraints: produce in aligned full SIMD widths so the
+     * conversion kernels never have to run a scalar tail */
+    int const alignment_multiple = volk_get_alignment() / sizeof(gr_complex);
+    set_alignment(std::max(1, alignment_multiple));
+    set_output_multiple(std::max(1, alignment_multiple));
 }
 
 soapy_source_c::~soapy_source_c(void)
 {
+    for (size_t i = 0; i < _native_bufs.size(); i++)
+        if (_native_bufs[i])
+            volk_free(_native_bufs[i]);
+
     _device->closeStream(_stream);
     boost::mutex::scoped_lock l(get_soapy_maker_mutex());
     SoapySDR::Device::unmake(_device);
@@ -87,20 +161,120 @@ bool soapy_source_c::start()
 
 bool soapy_source_c::stop()
 {
+    if (_direct && _direct_avail)
+    {
+        _device->releaseReadBuffer(_stream, _direct_handle);
+        _direct_avail = 0;
+    }
     return _device->deactivateStream(_stream) == 0;
 }
 
+/* zero-copy path: a driver buffer larger than the work call is held
+ * across calls and consumed incrementally */
+int soapy_source_c::work_direct( int noutput_items,
+                                 gr_vector_void_star &output_items )
+{
+    if (0 == _direct_avail)
+    {
+        int flags = 0;
+        long long timeNs = 0;
+
+        int ret = _device->acquireReadBuffer(
+            _stream, _direct_handle, &_direct_bufs[0], flags, timeNs);
+
+        if (ret == SOAPY_SDR_OVERFLOW)
+            _overflows.fetch_add(1, boost::memory_order_relaxed);
+
+        if (ret < 0) return 0; //call again
+
+        _direct_avail = ret;
+        _direct_offset = 0;
+    }
+
+    int nout = std::min(noutput_items, _direct_avail);
+
+    for (size_t i = 0; i < _nchan; i++)
+    {
+        if (SOAPY_SDR_CS16 == _format)
+            volk_16i_s32f_convert_32f((float *)output_items[i],
+                (const int16_t *)_direct_bufs[i] + 2 * _direct_offset,
+                _fullscale, 2 * nout);
+        else if (SOAPY_SDR_CS8 == _format)
+            volk_8i_s32f_convert_32f((float *)output_items[i],
+                (const int8_t *)_direct_bufs[i] + 2 * _direct_offset,
+                _fullscale, 2 * nout);
+        else
+            memcpy(output_items[i],
+                   (const gr_complex *)_direct_bufs[i] + _direct_offset,
+                   nout * sizeof(gr_complex));
+    }
+
+    _direct_offset += nout;
+    _direct_avail -= nout;
+
+    if (0 == _direct_avail)
+        _device->releaseReadBuffer(_stream, _direct_handle);
+
+    return nout;
+}
+
 int soapy_source_c::work( int noutput_items,
                             gr_vector_const_void_star &input_items,
                             gr_vector_void_star &output_items )
 {
     int flags = 0;
     long long timeNs = 0;
+
+    if (_direct)
+        return work_direct(noutput_items, output_items);
+
+    if (SOAPY_SDR_CF32 == _format)
+    {
+        int ret = _device->readStream(
+            _stream, &output_items[0],
+            noutput_items, flags, timeNs);
+
+        if (ret == SOAPY_SDR_OVERFLOW)
+            _overflows.fetch_add(1, boost::memory_order_relaxed);
+
+        if (ret < 0) return 0; //call again
+        return ret;
+    }
+
+    const size_t item_size = (SOAPY_SDR_CS16 == _format) ?
+        2 * sizeof(int16_t) : 2 * sizeof(int8_t);
+
+    if (noutput_items > _native_items)
+    {
+        for (size_t i = 0; i < _nchan; i++)
+        {
+            if (_native_bufs[i])
+                volk_free(_native_bufs[i]);
+            _native_bufs[i] = volk_malloc(noutput_items * item_size,
+                                          volk_get_alignment());
+        }
+        _native_items = noutput_items;
+    }
+
     int ret = _device->readStream(
-        _stream, &output_items[0],
+        _stream, &_native_bufs[0],
         noutput_items, flags, timeNs);
 
+    if (ret == SOAPY_SDR_OVERFLOW)
+        _overflows.fetch_add(1, boost::memory_order_relaxed);
+
     if (ret < 0) return 0; //call again
+
+    for (size_t i = 0; i < _nchan; i++)
+    {
+        if (SOAPY_SDR_CS16 == _format)
+            volk_16i_s32f_convert_32f((float *)output_items[i],
+                (const int16_t *)_native_bufs[i], _fullscale, 2 * ret);
+        else
+            volk_8i_s32f_convert_32f((float *)output_items[i],
+                (const int8_t *)_native_bufs[i], _fullscale, 2 * ret);
+    }
+
     return ret;
 }
 
@@ -121,6 +295,16 @@ size_t soapy_source_c::get_num_channels( void )
     return _nchan;
 }
 
+uint64_t soapy_source_c::get_num_overflows( void )
+{
+    return _overflows.load(boost::memory_order_relaxed);
+}
+
+void soapy_source_c::reset_stream_stats( void )
+{
+    _overflows.store(0, boost::memory_order_relaxed);
+}
+
 osmosdr::meta_range_t soapy_source_c::get_sample_rates( void )
 {
     osmosdr::meta_range_t result;
@@ -24,6 +24,8 @@
 #include <gnuradio/block.h>
 #include <gnuradio/sync_block.h>
 
+#include <boost/atomic.hpp>
+
 #include "osmosdr/ranges.h"
 #include "source_iface.h"
 
@@ -80,7 +82,15 @@ public:
 
   static std::vector< std::string > get_devices();
 
+private:
+  int work_direct( int noutput_items,
+                   gr_vector_void_star &output_items );
+
+public:
+
 size_t get_num_channels( void );
+uint64_t get_num_overflows( void );
+void reset_stream_stats( void );
 osmosdr::meta_range_t get_sample_rates( void );
 double set_sample_rate( double rate );
 double get_sample_rate( void );
@@ -133,8 +143,23 @@ void set_time_unknown_pps(const ::osmosdr::time_spec_t &time_spec);
 
 private:
     SoapySDR::Device *_device;
+    boost::atomic<uint64_t> _overflows;
     SoapySDR::Stream *_stream;
     size_t _nchan;
+
+    /* native format streaming, CF32 when the driver converts for us */
+    std::string _format;
+    double _fullscale;
+    std::vector<void *> _native_bufs;
+    int _native_items;
+
+    /* zero-copy streaming, converts straight out of the driver's
+     * buffers (direct=off in the device args falls back to readStream) */
+    bool _direct;
+    size_t _direct_handle;
+    std::vector<const void *> _direct_bufs;
+    int _direct_avail;
+    int _direct_offset;
 };
 
 #endif /* INCLUDED_SOAPY_SOURCE_C_H */
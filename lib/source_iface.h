@@ -23,8 +23,11 @@
 
 #include <osmosdr/ranges.h>
 #include <osmosdr/time_spec.h>
+#include <osmosdr/tune_request.h>
 #include <gnuradio/basic_block.h>
 
+#include <stdint.h>
+
 /*!
  * TODO: document
  *
@@ -38,6 +41,16 @@ public:
    */
   virtual size_t get_num_channels( void ) = 0;
 
+  /*!
+   * Gate or release the device's streaming producer. A gated driver
+   * keeps its stream and reader thread alive but discards incoming
+   * transfers, so the scheduler never observes a stopped stream;
+   * releasing is a bare flag store. start_synchronized() uses this to
+   * align the streams of a device group. Drivers without gating
+   * support inherit the no-op.
+   */
+  virtual void gate_stream( bool gated ) { }
+
   /*!
    * \brief seek file to \p seek_point relative to \p whence
    *
@@ -47,6 +60,54 @@ public:
    */
   virtual bool seek( long seek_point, int whence, size_t chan = 0 ) { return false; }
 
+  /*!
+   * \brief seek file to \p seconds from the start of the capture
+   *
+   * \param seconds	time offset into the file
+   * \return true on success
+   */
+  virtual bool seek_time( double seconds, size_t chan = 0 ) { return false; }
+
+  /*!
+   * Get the number of overflow events, i.e. samples the driver had to
+   * drop because the flow graph did not consume them in time, since
+   * stream start or the last reset_stream_stats() call. Maintained with
+   * relaxed atomics on the streaming path, so polling it is free.
+   * Drivers without overflow detection always return 0.
+   * \return the number of overflow events
+   */
+  virtual uint64_t get_num_overflows( void ) { return 0; }
+
+  /*!
+   * Get the number of underflow events since stream start or the last
+   * reset_stream_stats() call. Only meaningful for drivers that feed
+   * back transmit completion, all others return 0.
+   * \return the number of underflow events
+   */
+  virtual uint64_t get_num_underflows( void ) { return 0; }
+
+  /*!
+   * Reset the overflow/underflow counters to zero.
+   */
+  virtual void reset_stream_stats( void ) { }
+
+  /*!
+   * Get the fraction of the driver's internal buffering that is
+   * currently occupied, from 0.0 (empty) to 1.0 (about to overflow).
+   * Drivers without visibility into their buffering return 0.
+   * \return the buffer fill level
+   */
+  virtual double get_buffer_level( void ) { return 0; }
+
+  /*!
+   * Discard the given number of samples from the stream before
+   * producing again, used to trim a constant startup offset between
+   * coherent receivers. The default ignores the call.
+   * \param count the number of samples to drop
+   * \param chan the channel index 0 to N-1
+   */
+  virtual void skip_samples( uint64_t count, size_t chan = 0 ) { }
+
   /*!
    * Get the possible sample rates for the underlying radio hardware.
    * \return a range of rates in Sps
@@ -106,6 +167,31 @@ public:
    */
   virtual double get_freq_corr( size_t chan = 0 ) = 0;
 
+  /*!
+   * Apply a batch of settings as one transaction.
+   *
+   * This default forwards to the individual setters in a fixed order:
+   * correction first, so a correction induced retune happens before
+   * the new frequency is programmed instead of after it, then rate,
+   * frequency and gain. Drivers whose hardware can take several
+   * parameters in a single control transfer should override this.
+   *
+   * \param request the settings to apply, see osmosdr::tune_request_t
+   * \param chan the channel index 0 to N-1
+   */
+  virtual void apply_settings( const osmosdr::tune_request_t &request,
+                               size_t chan = 0 )
+  {
+    if ( request.set_freq_corr )
+      set_freq_corr( request.freq_corr, chan );
+    if ( request.set_rate )
+      set_sample_rate( request.rate );
+    if ( request.set_freq )
+      set_center_freq( request.freq, chan );
+    if ( request.set_gain )
+      set_gain( request.gain, chan );
+  }
+
   /*!
    * Get the gain stage names of the underlying radio hardware.
    * \param chan the channel index 0 to N-1
@@ -395,6 +481,29 @@ public:
    * \param time_spec the new time
    */
   virtual void set_time_unknown_pps(const ::osmosdr::time_spec_t &time_spec) { }
+
+  /*!
+   * Schedule subsequent setter calls for execution at the given device
+   * time. Devices without a timed-command queue apply settings
+   * immediately, so the default is a no-op.
+   * \param time_spec the absolute device time to latch the commands at
+   * \param mboard the motherboard index 0 to M-1
+   */
+  virtual void set_command_time(const ::osmosdr::time_spec_t &time_spec,
+                                size_t mboard = 0) { }
+
+  /*!
+   * Return to immediate execution of setter calls.
+   * \param mboard the motherboard index 0 to M-1
+   */
+  virtual void clear_command_time(size_t mboard = 0) { }
+
+  /*!
+   * Defer streaming to the given device time. Must be called before
+   * the flow graph is started.
+   * \param time_spec the absolute device time to start streaming at
+   */
+  virtual void set_start_time(const ::osmosdr::time_spec_t &time_spec) { }
 };
 
 #endif // OSMOSDR_SOURCE_IFACE_H
@@ -27,6 +27,8 @@
 #include "config.h"
 #endif
 
+#include <cmath>
+
 #include <gnuradio/io_signature.h>
 #include <gnuradio/blocks/null_source.h>
 #include <gnuradio/blocks/throttle.h>
@@ -92,6 +94,14 @@
 #include <freesrp_source_c.h>
 #endif
 
+#ifdef ENABLE_SYNTHETIC
+#include <synthetic_source_c.h>
+#endif
+
+#ifdef ENABLE_SHM
+#include <shm_source_c.h>
+#endif
+
 #include "arg_helpers.h"
 #include "source_impl.h"
 
@@ -117,6 +127,10 @@ source_impl::source_impl( const std::string &args )
   size_t channel = 0;
   bool device_specified = false;
 
+  /* where the spectrum tap attaches: first device, first channel */
+  gr::basic_block_sptr tap_src;
+  size_t tap_port = 0;
+
   std::vector< std::string > arg_list = args_to_vector(args);
 
   std::vector< std::string > dev_types;
@@ -165,6 +179,12 @@ source_impl::source_impl( const std::string &args )
 #endif
 #ifdef ENABLE_FREESRP
   dev_types.push_back("freesrp");
+#endif
+#ifdef ENABLE_SYNTHETIC
+  dev_types.push_back("synthetic");
+#endif
+#ifdef ENABLE_SHM
+  dev_types.push_back("shm");
 #endif
   std::cerr << "gr-osmosdr "
             << GR_OSMOSDR_VERSION << " (" << GR_OSMOSDR_LIBVER << ") "
@@ -192,58 +212,74 @@ source_impl::source_impl( const std::string &args )
   }
 
   if ( ! device_specified ) {
+    /* only the first hit is ever used below, so stop probing as soon
+     * as one backend reports a device and leave the remaining (often
+     * heavy to load) backends untouched */
     std::vector< std::string > dev_list;
 #ifdef ENABLE_OSMOSDR
-    BOOST_FOREACH( std::string dev, osmosdr_src_c::get_devices() )
-      dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      BOOST_FOREACH( std::string dev, osmosdr_src_c::get_devices() )
+        dev_list.push_back( dev );
 #endif
 #ifdef ENABLE_FCD
-    BOOST_FOREACH( std::string dev, fcd_source_c::get_devices() )
-      dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      BOOST_FOREACH( std::string dev, fcd_source_c::get_devices() )
+        dev_list.push_back( dev );
 #endif
 #ifdef ENABLE_RTL
-    BOOST_FOREACH( std::string dev, rtl_source_c::get_devices() )
-      dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      BOOST_FOREACH( std::string dev, rtl_source_c::get_devices() )
+        dev_list.push_back( dev );
 #endif
 #ifdef ENABLE_UHD
-    BOOST_FOREACH( std::string dev, uhd_source_c::get_devices() )
-      dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      BOOST_FOREACH( std::string dev, uhd_source_c::get_devices() )
+        dev_list.push_back( dev );
 #endif
 #ifdef ENABLE_MIRI
-    BOOST_FOREACH( std::string dev, miri_source_c::get_devices() )
-      dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      BOOST_FOREACH( std::string dev, miri_source_c::get_devices() )
+        dev_list.push_back( dev );
 #endif
 #ifdef ENABLE_SDRPLAY
-    BOOST_FOREACH( std::string dev, sdrplay_source_c::get_devices() )
-      dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      BOOST_FOREACH( std::string dev, sdrplay_source_c::get_devices() )
+        dev_list.push_back( dev );
 #endif
 #ifdef ENABLE_BLADERF
-    BOOST_FOREACH( std::string dev, bladerf_source_c::get_devices() )
-      dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      BOOST_FOREACH( std::string dev, bladerf_source_c::get_devices() )
+        dev_list.push_back( dev );
 #endif
 #ifdef ENABLE_RFSPACE
-    BOOST_FOREACH( std::string dev, rfspace_source_c::get_devices() )
-      dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      BOOST_FOREACH( std::string dev, rfspace_source_c::get_devices() )
+        dev_list.push_back( dev );
 #endif
 #ifdef ENABLE_HACKRF
-    BOOST_FOREACH( std::string dev, hackrf_source_c::get_devices() )
-      dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      BOOST_FOREACH( std::string dev, hackrf_source_c::get_devices() )
+        dev_list.push_back( dev );
 #endif
 #ifdef ENABLE_AIRSPY
-    BOOST_FOREACH( std::string dev, airspy_source_c::get_devices() )
-      dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      BOOST_FOREACH( std::string dev, airspy_source_c::get_devices() )
+        dev_list.push_back( dev );
 #endif
 #ifdef ENABLE_SOAPY
-    BOOST_FOREACH( std::string dev, soapy_source_c::get_devices() )
-      dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      BOOST_FOREACH( std::string dev, soapy_source_c::get_devices() )
+        dev_list.push_back( dev );
 #endif
 #ifdef ENABLE_REDPITAYA
-    BOOST_FOREACH( std::string dev, redpitaya_source_c::get_devices() )
-      dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      BOOST_FOREACH( std::string dev, redpitaya_source_c::get_devices() )
+        dev_list.push_back( dev );
 #endif
 #ifdef ENABLE_FREESRP
-    BOOST_FOREACH( std::string dev, freesrp_source_c::get_devices() )
-      dev_list.push_back( dev );
+    if ( dev_list.empty() )
+      BOOST_FOREACH( std::string dev, freesrp_source_c::get_devices() )
+        dev_list.push_back( dev );
 #endif
 
 //    std::cerr << std::endl;
@@ -376,23 +412,81 @@ source_impl::source_impl( const std::string &args )
     }
 #endif
 
+#ifdef ENABLE_SYNTHETIC
+    if ( dict.count("synthetic") ) {
+      synthetic_source_c_sptr src = make_synthetic_source_c( arg );
+      block = src; iface = src.get();
+    }
+#endif
+
+#ifdef ENABLE_SHM
+    if ( dict.count("shm") ) {
+      shm_source_c_sptr src = make_shm_source_c( arg );
+      block = src; iface = src.get();
+    }
+#endif
+
     if ( iface != NULL && long(block.get()) != 0 ) {
       _devs.push_back( iface );
 
+      bool iq_balance = true;
+      if ( dict.count("iq_balance") )
+        iq_balance = ! ( "off" == dict["iq_balance"] ||
+                         "0" == dict["iq_balance"] );
+
+      bool iq_soft = ( dict.count("iq_balance") &&
+                       "soft" == dict["iq_balance"] );
+
       for (size_t i = 0; i < iface->get_num_channels(); i++) {
-#ifdef HAVE_IQBALANCE
-        gr::iqbalance::optimize_c::sptr iq_opt = gr::iqbalance::optimize_c::make( 0 );
-        gr::iqbalance::fix_cc::sptr     iq_fix = gr::iqbalance::fix_cc::make();
+        if ( !tap_src ) {
+          tap_src = block;
+          tap_port = i;
+        }
 
-        connect(block, i, iq_fix, 0);
-        connect(iq_fix, 0, self(), channel++);
+        if ( iq_soft ) {
+          /* integrated volk correction stage, takes its coefficients
+           * through set_dc_offset()/set_iq_balance() and stays a plain
+           * copy until they are set */
+          iq_correct_cc_sptr iq_cor = make_iq_correct_cc();
 
-        connect(block, i, iq_opt, 0);
-        msg_connect(iq_opt, "iqbal_corr", iq_fix, "iqbal_corr");
+          connect(block, i, iq_cor, 0);
+          connect(iq_cor, 0, self(), channel++);
 
-        _iq_opt.push_back( iq_opt.get() );
-        _iq_fix.push_back( iq_fix.get() );
+          _iq_cor.push_back( iq_cor.get() );
+#ifdef HAVE_IQBALANCE
+          _iq_opt.push_back( NULL );
+          _iq_fix.push_back( NULL );
+#endif
+          continue;
+        }
+
+        _iq_cor.push_back( NULL );
+#ifdef HAVE_IQBALANCE
+        if ( iq_balance ) {
+          gr::iqbalance::optimize_c::sptr iq_opt = gr::iqbalance::optimize_c::make( 0 );
+          gr::iqbalance::fix_cc::sptr     iq_fix = gr::iqbalance::fix_cc::make();
+
+          connect(block, i, iq_fix, 0);
+          connect(iq_fix, 0, self(), channel++);
+
+          connect(block, i, iq_opt, 0);
+          msg_connect(iq_opt, "iqbal_corr", iq_fix, "iqbal_corr");
+
+          _iq_opt.push_back( iq_opt.get() );
+          _iq_fix.push_back( iq_fix.get() );
+        } else {
+          /* iq_balance=off gives back the direct path for deployments
+           * that correct in hardware. keep the per channel vectors
+           * aligned with NULL entries so lookups by channel still work. */
+          connect(block, i, self(), channel++);
+
+          _iq_opt.push_back( NULL );
+          _iq_fix.push_back( NULL );
+        }
 #else
+        /* this pass-through wiring disappears when the flow graph is
+         * flattened at start, the driver block then feeds downstream
+         * blocks directly without an intermediate buffer */
         connect(block, i, self(), channel++);
 #endif
       }
@@ -403,6 +497,48 @@ source_impl::source_impl( const std::string &args )
 
   if (!_devs.size())
     throw std::runtime_error("No devices specified via device arguments.");
+
+  double telemetry_ms = 0;
+
+  BOOST_FOREACH(std::string arg, arg_list) {
+    dict_t dict = params_to_dict(arg);
+    if (dict.count("telemetry"))
+      telemetry_ms = boost::lexical_cast< double >( dict["telemetry"] );
+  }
+
+  if (telemetry_ms > 0) {
+    /* publish the buffer fill of every device so a supervisor can
+     * rebalance channels before samples are actually dropped */
+    message_port_register_hier_out(pmt::mp("telemetry"));
+
+    _monitor = make_buffer_monitor( _devs, telemetry_ms );
+
+    msg_connect( _monitor, "telemetry", self(), "telemetry" );
+  }
+
+  size_t spectrum_size = 0;
+  double spectrum_fps = 30;
+
+  BOOST_FOREACH(std::string arg, arg_list) {
+    dict_t dict = params_to_dict(arg);
+    if (dict.count("spectrum"))
+      spectrum_size = boost::lexical_cast< size_t >( dict["spectrum"] );
+    if (dict.count("spectrum_fps"))
+      spectrum_fps = boost::lexical_cast< double >( dict["spectrum_fps"] );
+  }
+
+  if (spectrum_size > 0) {
+    /* monitoring UIs subscribe to decimated magnitude frames on the
+     * "spectrum" port instead of pulling a second full rate stream
+     * into Python; the full rate path is not touched */
+    message_port_register_hier_out(pmt::mp("spectrum"));
+
+    _spectrum_tap = make_spectrum_tap_c( spectrum_size, spectrum_fps );
+    _spectrum_tap->set_sample_rate( get_sample_rate() );
+
+    connect( tap_src, tap_port, _spectrum_tap, 0 );
+    msg_connect( _spectrum_tap, "spectrum", self(), "spectrum" );
+  }
 }
 
 size_t source_impl::get_num_channels()
@@ -415,6 +551,41 @@ size_t source_impl::get_num_channels()
   return channels;
 }
 
+uint64_t source_impl::get_num_overflows()
+{
+  uint64_t overflows = 0;
+
+  BOOST_FOREACH( source_iface *dev, _devs )
+    overflows += dev->get_num_overflows();
+
+  return overflows;
+}
+
+uint64_t source_impl::get_num_underflows()
+{
+  uint64_t underflows = 0;
+
+  BOOST_FOREACH( source_iface *dev, _devs )
+    underflows += dev->get_num_underflows();
+
+  return underflows;
+}
+
+void source_impl::reset_stream_stats()
+{
+  BOOST_FOREACH( source_iface *dev, _devs )
+    dev->reset_stream_stats();
+}
+
+void source_impl::skip_samples( uint64_t count, size_t chan )
+{
+  size_t channel = 0;
+  BOOST_FOREACH( source_iface *dev, _devs )
+    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
+      if ( chan == channel++ )
+        dev->skip_samples( count, dev_chan );
+}
+
 bool source_impl::seek( long seek_point, int whence, size_t chan )
 {
   size_t channel = 0;
@@ -426,6 +597,17 @@ bool source_impl::seek( long seek_point, int whence, size_t chan )
   return false;
 }
 
+bool source_impl::seek_time( double seconds, size_t chan )
+{
+  size_t channel = 0;
+  BOOST_FOREACH( source_iface *dev, _devs )
+    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
+      if ( chan == channel++ )
+        return dev->seek_time( seconds, dev_chan );
+
+  return false;
+}
+
 #define NO_DEVICES_MSG  "FATAL: No device(s) available to work with."
 
 osmosdr::meta_range_t source_impl::get_sample_rates()
@@ -455,7 +637,7 @@ double source_impl::set_sample_rate(double rate)
     size_t channel = 0;
     BOOST_FOREACH( source_iface *dev, _devs ) {
       for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++) {
-        if ( channel < _iq_opt.size() ) {
+        if ( channel < _iq_opt.size() && _iq_opt[channel] != NULL ) {
           gr::iqbalance::optimize_c *opt = _iq_opt[channel];
 
           if ( opt->period() > 0 ) { /* optimize is enabled */
@@ -470,6 +652,9 @@ double source_impl::set_sample_rate(double rate)
 #endif
 
     _sample_rate = sample_rate;
+
+    if (_spectrum_tap) /* frame pacing follows the stream rate */
+      _spectrum_tap->set_sample_rate( sample_rate );
   }
 
   return sample_rate;
@@ -477,15 +662,29 @@ double source_impl::set_sample_rate(double rate)
 
 double source_impl::get_sample_rate()
 {
-  double sample_rate = 0;
+  /* telemetry polls the getters at high rate, answer from the setter
+   * cache instead of querying the hardware for every call */
+  if ( _sample_rate == _sample_rate ) /* not NAN, cache is valid */
+    return _sample_rate;
 
   if (!_devs.empty())
-    sample_rate = _devs[0]->get_sample_rate(); // assume same devices used in the group
+    _sample_rate = _devs[0]->get_sample_rate(); // assume same devices used in the group
 #if 0
   else
     throw std::runtime_error(NO_DEVICES_MSG);
 #endif
-  return sample_rate;
+  return _sample_rate;
+}
+
+void source_impl::reset_settings_cache()
+{
+  /* the next call to each getter queries the hardware again and the
+   * next call to each setter reaches it even with an unchanged value */
+  _sample_rate = NAN;
+  _center_freq.clear();
+  _freq_corr.clear();
+  _gain_mode.clear();
+  _gain.clear();
 }
 
 osmosdr::freq_range_t source_impl::get_freq_range( size_t chan )
@@ -499,16 +698,25 @@ osmosdr::freq_range_t source_impl::get_freq_range( size_t chan )
   return osmosdr::freq_range_t();
 }
 
+/* suppresses a re-asserted frequency that only differs by floating point
+ * noise; way below the tuning resolution of any supported device */
+#define FREQ_EPSILON 0.01 /* Hz */
+
 double source_impl::set_center_freq( double freq, size_t chan )
 {
+  /* short-circuit before the device walk so a controller re-asserting
+   * its settings (e.g. on every trunking channel grant) is free */
+  std::map< size_t, double >::iterator cached = _center_freq.find( chan );
+  if ( cached != _center_freq.end() &&
+       fabs( cached->second - freq ) < FREQ_EPSILON )
+    return cached->second;
+
   size_t channel = 0;
   BOOST_FOREACH( source_iface *dev, _devs )
     for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
       if ( chan == channel++ ) {
-        if ( _center_freq[ chan ] != freq ) {
-          _center_freq[ chan ] = freq;
-          return dev->set_center_freq( freq, dev_chan );
-        } else { return _center_freq[ chan ]; }
+        _center_freq[ chan ] = freq;
+        return dev->set_center_freq( freq, dev_chan );
       }
 
   return 0;
@@ -516,25 +724,46 @@ double source_impl::set_center_freq( double freq, size_t chan )
 
 double source_impl::get_center_freq( size_t chan )
 {
+  std::map< size_t, double >::iterator cached = _center_freq.find( chan );
+  if ( cached != _center_freq.end() )
+    return cached->second;
+
   size_t channel = 0;
   BOOST_FOREACH( source_iface *dev, _devs )
     for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
       if ( chan == channel++ )
-        return dev->get_center_freq( dev_chan );
+        return _center_freq[ chan ] = dev->get_center_freq( dev_chan );
 
   return 0;
 }
 
+std::vector<double> source_impl::set_center_freqs( const std::vector<double> &freqs )
+{
+  /* batched entry point for scripted scan loops: one binding dispatch
+   * for all channels, the per channel cache logic stays in one place */
+  std::vector<double> result;
+
+  for ( size_t chan = 0; chan < freqs.size(); chan++ )
+    result.push_back( set_center_freq( freqs[ chan ], chan ) );
+
+  return result;
+}
+
 double source_impl::set_freq_corr( double ppm, size_t chan )
 {
+  std::map< size_t, double >::iterator cached = _freq_corr.find( chan );
+  if ( cached != _freq_corr.end() && cached->second == ppm )
+    return cached->second;
+
   size_t channel = 0;
   BOOST_FOREACH( source_iface *dev, _devs )
     for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
       if ( chan == channel++ ) {
-        if ( _freq_corr[ chan ] != ppm ) {
-          _freq_corr[ chan ] = ppm;
-          return dev->set_freq_corr( ppm, dev_chan );
-        } else { return _freq_corr[ chan ]; }
+        _freq_corr[ chan ] = ppm;
+        /* a correction change shifts the effective tuning, so the next
+         * set_center_freq() with the same value has to reach the device */
+        _center_freq.erase( chan );
+        return dev->set_freq_corr( ppm, dev_chan );
       }
 
   return 0;
@@ -542,15 +771,49 @@ double source_impl::set_freq_corr( double ppm, size_t chan )
 
 double source_impl::get_freq_corr( size_t chan )
 {
+  std::map< size_t, double >::iterator cached = _freq_corr.find( chan );
+  if ( cached != _freq_corr.end() )
+    return cached->second;
+
   size_t channel = 0;
   BOOST_FOREACH( source_iface *dev, _devs )
     for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
       if ( chan == channel++ )
-        return dev->get_freq_corr( dev_chan );
+        return _freq_corr[ chan ] = dev->get_freq_corr( dev_chan );
 
   return 0;
 }
 
+void source_impl::apply_settings( const osmosdr::tune_request_t &request,
+                                  size_t chan )
+{
+  osmosdr::tune_request_t req = request;
+
+  if ( req.set_rate ) {
+    /* the sample rate is common to all devices, run it through the
+     * regular path so the rate cache and the iq balance optimizers
+     * stay in sync, and strip it from the per device transaction */
+    set_sample_rate( req.rate );
+    req.set_rate = false;
+  }
+
+  size_t channel = 0;
+  BOOST_FOREACH( source_iface *dev, _devs )
+    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
+      if ( chan == channel++ ) {
+        dev->apply_settings( req, dev_chan );
+
+        /* refresh the setter caches so interleaved calls to the
+         * individual setters keep suppressing redundant updates */
+        if ( req.set_freq )
+          _center_freq[ chan ] = dev->get_center_freq( dev_chan );
+        if ( req.set_freq_corr )
+          _freq_corr[ chan ] = dev->get_freq_corr( dev_chan );
+        if ( req.set_gain )
+          _gain[ chan ] = dev->get_gain( dev_chan );
+      }
+}
+
 std::vector<std::string> source_impl::get_gain_names( size_t chan )
 {
   size_t channel = 0;
@@ -586,17 +849,19 @@ osmosdr::gain_range_t source_impl::get_gain_range( const std::string & name, siz
 
 bool source_impl::set_gain_mode( bool automatic, size_t chan )
 {
+  std::map< size_t, bool >::iterator cached = _gain_mode.find( chan );
+  if ( cached != _gain_mode.end() && cached->second == automatic )
+    return cached->second;
+
   size_t channel = 0;
   BOOST_FOREACH( source_iface *dev, _devs )
     for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
       if ( chan == channel++ ) {
-        if ( _gain_mode[ chan ] != automatic ) {
-          _gain_mode[ chan ] = automatic;
-          bool mode = dev->set_gain_mode( automatic, dev_chan );
-          if (!automatic) // reapply gain value when switched to manual mode
-            dev->set_gain( _gain[ chan ], dev_chan );
-          return mode;
-        } else { return _gain_mode[ chan ]; }
+        _gain_mode[ chan ] = automatic;
+        bool mode = dev->set_gain_mode( automatic, dev_chan );
+        if (!automatic && _gain.count( chan )) // reapply gain value when switched to manual mode
+          dev->set_gain( _gain[ chan ], dev_chan );
+        return mode;
       }
 
   return false;
@@ -604,25 +869,31 @@ bool source_impl::set_gain_mode( bool automatic, size_t chan )
 
 bool source_impl::get_gain_mode( size_t chan )
 {
+  std::map< size_t, bool >::iterator cached = _gain_mode.find( chan );
+  if ( cached != _gain_mode.end() )
+    return cached->second;
+
   size_t channel = 0;
   BOOST_FOREACH( source_iface *dev, _devs )
     for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
       if ( chan == channel++ )
-        return dev->get_gain_mode( dev_chan );
+        return _gain_mode[ chan ] = dev->get_gain_mode( dev_chan );
 
   return false;
 }
 
 double source_impl::set_gain( double gain, size_t chan )
 {
+  std::map< size_t, double >::iterator cached = _gain.find( chan );
+  if ( cached != _gain.end() && cached->second == gain )
+    return cached->second;
+
   size_t channel = 0;
   BOOST_FOREACH( source_iface *dev, _devs )
     for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
       if ( chan == channel++ ) {
-        if ( _gain[ chan ] != gain ) {
-          _gain[ chan ] = gain;
-          return dev->set_gain( gain, dev_chan );
-        } else { return _gain[ chan ]; }
+        _gain[ chan ] = gain;
+        return dev->set_gain( gain, dev_chan );
       }
 
   return 0;
@@ -633,19 +904,26 @@ double source_impl::set_gain( double gain, const std::string & name, size_t chan
   size_t channel = 0;
   BOOST_FOREACH( source_iface *dev, _devs )
     for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
+      if ( chan == channel++ ) {
+        /* a named stage shifts the overall gain, drop the cached value */
+        _gain.erase( chan );
         return dev->set_gain( gain, name, dev_chan );
+      }
 
   return 0;
 }
 
 double source_impl::get_gain( size_t chan )
 {
+  std::map< size_t, double >::iterator cached = _gain.find( chan );
+  if ( cached != _gain.end() )
+    return cached->second;
+
   size_t channel = 0;
   BOOST_FOREACH( source_iface *dev, _devs )
     for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
       if ( chan == channel++ )
-        return dev->get_gain( dev_chan );
+        return _gain[ chan ] = dev->get_gain( dev_chan );
 
   return 0;
 }
@@ -661,6 +939,29 @@ double source_impl::get_gain( const std::string & name, size_t chan )
   return 0;
 }
 
+std::vector<double> source_impl::set_gains( const std::vector<double> &gains )
+{
+  std::vector<double> result;
+
+  for ( size_t chan = 0; chan < gains.size(); chan++ )
+    result.push_back( set_gain( gains[ chan ], chan ) );
+
+  return result;
+}
+
+std::vector<double> source_impl::get_gains( void )
+{
+  /* served from the settings cache just like the per channel getter */
+  std::vector<double> result;
+  size_t channel = 0;
+
+  BOOST_FOREACH( source_iface *dev, _devs )
+    for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
+      result.push_back( get_gain( channel++ ) );
+
+  return result;
+}
+
 double source_impl::set_if_gain( double gain, size_t chan )
 {
   size_t channel = 0;
@@ -742,8 +1043,12 @@ void source_impl::set_dc_offset( const std::complex<double> &offset, size_t chan
   size_t channel = 0;
   BOOST_FOREACH( source_iface *dev, _devs )
     for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
-        dev->set_dc_offset( offset, dev_chan );
+      if ( chan == channel++ ) {
+        if ( chan < _iq_cor.size() && _iq_cor[chan] != NULL )
+          _iq_cor[chan]->set_dc_offset( offset );
+        else
+          dev->set_dc_offset( offset, dev_chan );
+      }
 }
 
 void source_impl::set_iq_balance_mode( int mode, size_t chan )
@@ -753,7 +1058,15 @@ void source_impl::set_iq_balance_mode( int mode, size_t chan )
   BOOST_FOREACH( source_iface *dev, _devs ) {
     for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++) {
       if ( chan == channel++ ) {
-        if ( chan < _iq_opt.size() && chan < _iq_fix.size() ) {
+        if ( chan < _iq_cor.size() && _iq_cor[chan] != NULL ) {
+          /* the integrated stage takes manual coefficients only */
+          if ( IQBalanceOff == mode )
+            _iq_cor[chan]->set_iq_balance( std::complex<double>(0, 0) );
+          else if ( IQBalanceAutomatic == mode )
+            std::cerr << "Automatic IQ imbalance optimization requires gr-iqbal."
+                      << std::endl;
+        } else if ( chan < _iq_opt.size() && chan < _iq_fix.size() &&
+             _iq_opt[chan] != NULL && _iq_fix[chan] != NULL ) {
           gr::iqbalance::optimize_c *opt = _iq_opt[chan];
           gr::iqbalance::fix_cc *fix = _iq_fix[chan];
 
@@ -775,6 +1088,9 @@ void source_impl::set_iq_balance_mode( int mode, size_t chan )
             opt->set_period( dev->get_sample_rate() / 5 );
             opt->reset();
           }
+        } else {
+          /* correction chain was bypassed, let the device handle it */
+          dev->set_iq_balance_mode( mode, dev_chan );
         }
       }
     }
@@ -782,8 +1098,18 @@ void source_impl::set_iq_balance_mode( int mode, size_t chan )
 #else
   BOOST_FOREACH( source_iface *dev, _devs )
     for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
+      if ( chan == channel++ ) {
+        if ( chan < _iq_cor.size() && _iq_cor[chan] != NULL ) {
+          /* the integrated stage takes manual coefficients only */
+          if ( IQBalanceOff == mode )
+            _iq_cor[chan]->set_iq_balance( std::complex<double>(0, 0) );
+          else if ( IQBalanceAutomatic == mode )
+            std::cerr << "Automatic IQ imbalance optimization requires gr-iqbal."
+                      << std::endl;
+          return;
+        }
         return dev->set_iq_balance_mode( mode, dev_chan );
+      }
 #endif
 }
 
@@ -794,7 +1120,10 @@ void source_impl::set_iq_balance( const std::complex<double> &balance, size_t ch
   BOOST_FOREACH( source_iface *dev, _devs ) {
     for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++) {
       if ( chan == channel++ ) {
-        if ( chan < _iq_opt.size() && chan < _iq_fix.size() ) {
+        if ( chan < _iq_cor.size() && _iq_cor[chan] != NULL ) {
+          _iq_cor[chan]->set_iq_balance( balance );
+        } else if ( chan < _iq_opt.size() && chan < _iq_fix.size() &&
+             _iq_opt[chan] != NULL && _iq_fix[chan] != NULL ) {
           gr::iqbalance::optimize_c *opt = _iq_opt[chan];
           gr::iqbalance::fix_cc *fix = _iq_fix[chan];
 
@@ -802,6 +1131,9 @@ void source_impl::set_iq_balance( const std::complex<double> &balance, size_t ch
             fix->set_mag( balance.real() );
             fix->set_phase( balance.imag() );
           }
+        } else {
+          /* correction chain was bypassed, let the device handle it */
+          dev->set_iq_balance( balance, dev_chan );
         }
       }
     }
@@ -809,8 +1141,11 @@ void source_impl::set_iq_balance( const std::complex<double> &balance, size_t ch
 #else
   BOOST_FOREACH( source_iface *dev, _devs )
     for (size_t dev_chan = 0; dev_chan < dev->get_num_channels(); dev_chan++)
-      if ( chan == channel++ )
+      if ( chan == channel++ ) {
+        if ( chan < _iq_cor.size() && _iq_cor[chan] != NULL )
+          return _iq_cor[chan]->set_iq_balance( balance );
         return dev->set_iq_balance( balance, dev_chan );
+      }
 #endif
 }
 
@@ -949,3 +1284,51 @@ void source_impl::set_time_unknown_pps(const osmosdr::time_spec_t &time_spec)
     dev->set_time_unknown_pps( time_spec );
   }
 }
+
+void source_impl::set_command_time(const osmosdr::time_spec_t &time_spec, size_t mboard)
+{
+  if (mboard != osmosdr::ALL_MBOARDS){
+      _devs.at(mboard)->set_command_time( time_spec );
+      return;
+  }
+
+  for (size_t m = 0; m < _devs.size(); m++){ /* propagate ALL_MBOARDS */
+      _devs.at(m)->set_command_time( time_spec, osmosdr::ALL_MBOARDS );
+  }
+}
+
+void source_impl::clear_command_time(size_t mboard)
+{
+  if (mboard != osmosdr::ALL_MBOARDS){
+      _devs.at(mboard)->clear_command_time();
+      return;
+  }
+
+  for (size_t m = 0; m < _devs.size(); m++){ /* propagate ALL_MBOARDS */
+      _devs.at(m)->clear_command_time( osmosdr::ALL_MBOARDS );
+  }
+}
+
+void source_impl::set_start_time(const osmosdr::time_spec_t &time_spec)
+{
+  BOOST_FOREACH( source_iface *dev, _devs )
+  {
+    dev->set_start_time( time_spec );
+  }
+}
+
+void source_impl::start_synchronized()
+{
+  /* arm phase: gate every producer so no new samples enter the rings.
+   * the streams and reader threads stay up - tearing a stream down
+   * here would make work() answer WORK_DONE and the scheduler would
+   * retire the block for good */
+  BOOST_FOREACH( source_iface *dev, _devs )
+    dev->gate_stream( true );
+
+  /* release phase: ungating is a bare flag store per device, so the
+   * producers resume back to back and the skew between the streams is
+   * bounded by this loop instead of a sequential bring up */
+  BOOST_FOREACH( source_iface *dev, _devs )
+    dev->gate_stream( false );
+}
@@ -29,6 +29,10 @@
 
 #include <source_iface.h>
 
+#include "buffer_monitor.h"
+#include "spectrum_tap_c.h"
+#include "iq_correct_cc.h"
+
 #include <map>
 
 class source_impl : public osmosdr::source
@@ -38,7 +42,14 @@ public:
 
   size_t get_num_channels( void );
 
+  uint64_t get_num_overflows( void );
+  uint64_t get_num_underflows( void );
+  void reset_stream_stats( void );
+  void reset_settings_cache( void );
+  void skip_samples( uint64_t count, size_t chan = 0 );
+
   bool seek( long seek_point, int whence, size_t chan );
+  bool seek_time( double seconds, size_t chan );
 
   osmosdr::meta_range_t get_sample_rates( void );
   double set_sample_rate( double rate );
@@ -47,9 +58,13 @@ public:
   osmosdr::freq_range_t get_freq_range( size_t chan = 0 );
   double set_center_freq( double freq, size_t chan = 0 );
   double get_center_freq( size_t chan = 0 );
+  std::vector<double> set_center_freqs( const std::vector<double> &freqs );
   double set_freq_corr( double ppm, size_t chan = 0 );
   double get_freq_corr( size_t chan = 0 );
 
+  void apply_settings( const osmosdr::tune_request_t &request,
+                       size_t chan = 0 );
+
   std::vector<std::string> get_gain_names( size_t chan = 0 );
   osmosdr::gain_range_t get_gain_range( size_t chan = 0 );
   osmosdr::gain_range_t get_gain_range( const std::string & name, size_t chan = 0 );
@@ -59,6 +74,8 @@ public:
   double set_gain( double gain, const std::string & name, size_t chan = 0 );
   double get_gain( size_t chan = 0 );
   double get_gain( const std::string & name, size_t chan = 0 );
+  std::vector<double> set_gains( const std::vector<double> &gains );
+  std::vector<double> get_gains( void );
 
   double set_if_gain( double gain, size_t chan = 0 );
   double set_bb_gain( double gain, size_t chan = 0 );
@@ -90,10 +107,18 @@ public:
   void set_time_now(const ::osmosdr::time_spec_t &time_spec, size_t mboard = 0);
   void set_time_next_pps(const ::osmosdr::time_spec_t &time_spec);
   void set_time_unknown_pps(const ::osmosdr::time_spec_t &time_spec);
+  void set_command_time(const ::osmosdr::time_spec_t &time_spec, size_t mboard = 0);
+  void clear_command_time(size_t mboard = 0);
+  void set_start_time(const ::osmosdr::time_spec_t &time_spec);
+  void start_synchronized();
 
 private:
   std::vector< source_iface * > _devs;
 
+  buffer_monitor_sptr _monitor;
+
+  spectrum_tap_c_sptr _spectrum_tap;
+
   /* cache to prevent multiple device calls with the same value coming from grc */
   double _sample_rate;
   std::map< size_t, double > _center_freq;
@@ -108,6 +133,8 @@ private:
   std::vector< gr::iqbalance::optimize_c * > _iq_opt;
   std::map< size_t, std::pair<float, float> > _vals;
 #endif
+  /* integrated volk correction stages, NULL for channels on another path */
+  std::vector< iq_correct_cc * > _iq_cor;
   std::map< size_t, double > _bandwidth;
 };
 
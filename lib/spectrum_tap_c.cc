@@ -0,0 +1,156 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include <gnuradio/io_signature.h>
+
+#include <volk/volk.h>
+
+#include "spectrum_tap_c.h"
+
+spectrum_tap_c_sptr make_spectrum_tap_c( size_t fft_size, double fps )
+{
+  return gnuradio::get_initial_sptr( new spectrum_tap_c(fft_size, fps) );
+}
+
+spectrum_tap_c::spectrum_tap_c( size_t fft_size, double fps )
+  : gr::sync_block("spectrum_tap_c",
+                   gr::io_signature::make(1, 1, sizeof(gr_complex)),
+                   gr::io_signature::make(0, 0, 0)),
+    _fft_size(fft_size),
+    _fps(fps),
+    _rate(0),
+    _fft(NULL),
+    _stride(0),
+    _skip(0),
+    _fill(0)
+{
+  if (0 == _fft_size || _fft_size & (_fft_size - 1))
+    throw std::runtime_error("Spectrum FFT size must be a power of two.");
+
+  if (_fps <= 0)
+    throw std::runtime_error("Spectrum frame rate must be positive.");
+
+  _fft = new gr::fft::fft_complex(_fft_size, true);
+
+  _frame = (gr_complex *)volk_malloc(_fft_size * sizeof(gr_complex),
+                                     volk_get_alignment());
+  _window = (float *)volk_malloc(_fft_size * sizeof(float),
+                                 volk_get_alignment());
+  _mag = (float *)volk_malloc(_fft_size * sizeof(float),
+                              volk_get_alignment());
+  _shifted = (float *)volk_malloc(_fft_size * sizeof(float),
+                                  volk_get_alignment());
+
+  /* Hann, scaled so a full scale carrier reads close to 0 dB */
+  double sum = 0;
+  for (size_t i = 0; i < _fft_size; i++) {
+    _window[i] = 0.5f - 0.5f * cosf(2.0f * M_PI * i / (_fft_size - 1));
+    sum += _window[i];
+  }
+  for (size_t i = 0; i < _fft_size; i++)
+    _window[i] /= sum;
+
+  message_port_register_out( pmt::mp("spectrum") );
+}
+
+spectrum_tap_c::~spectrum_tap_c()
+{
+  delete _fft;
+
+  volk_free(_frame);
+  volk_free(_window);
+  volk_free(_mag);
+  volk_free(_shifted);
+}
+
+void spectrum_tap_c::set_sample_rate( double rate )
+{
+  _rate = rate;
+
+  if (_rate > 0) {
+    _stride = (uint64_t)std::max( _rate / _fps, (double)_fft_size );
+    _skip = 0; /* the next frame starts right away */
+  } else {
+    _stride = 0; /* pause until the rate is known */
+  }
+}
+
+int spectrum_tap_c::work( int noutput_items,
+                          gr_vector_const_void_star &input_items,
+                          gr_vector_void_star &output_items )
+{
+  const gr_complex *in = (const gr_complex *)input_items[0];
+  int remaining = noutput_items;
+
+  if (0 == _stride) /* pacing unknown, just count the stream along */
+    return noutput_items;
+
+  while (remaining) {
+    if (_fill || 0 == _skip) {
+      /* collecting the frame, possibly across work calls */
+      size_t ncopy = std::min( (size_t)remaining, _fft_size - _fill );
+
+      memcpy( _frame + _fill, in, ncopy * sizeof(gr_complex) );
+
+      _fill += ncopy;
+      in += ncopy;
+      remaining -= ncopy;
+
+      if (_fft_size == _fill) {
+        volk_32fc_32f_multiply_32fc( _fft->get_inbuf(), _frame,
+                                     _window, _fft_size );
+        _fft->execute();
+
+        /* magnitude in dB; unity normalization, the window scale
+         * already carries the calibration */
+        volk_32fc_s32f_x2_power_spectral_density_32f(
+              _mag, _fft->get_outbuf(), 1.0f, 1.0f, _fft_size );
+
+        /* fft shift so the frame reads negative to positive offset */
+        memcpy( _shifted, _mag + _fft_size / 2,
+                _fft_size / 2 * sizeof(float) );
+        memcpy( _shifted + _fft_size / 2, _mag,
+                _fft_size / 2 * sizeof(float) );
+
+        message_port_pub( pmt::mp("spectrum"),
+                          pmt::init_f32vector( _fft_size, _shifted ) );
+
+        _fill = 0;
+        _skip = _stride - _fft_size;
+      }
+
+      continue;
+    }
+
+    /* between frames only the sample count moves */
+    uint64_t nskip = std::min( (uint64_t)remaining, _skip );
+
+    _skip -= nskip;
+    in += nskip;
+    remaining -= (int)nskip;
+  }
+
+  return noutput_items;
+}
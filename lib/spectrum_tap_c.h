@@ -0,0 +1,77 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_SPECTRUM_TAP_C_H
+#define OSMOSDR_SPECTRUM_TAP_C_H
+
+#include <gnuradio/sync_block.h>
+#include <gnuradio/fft/fft.h>
+
+class spectrum_tap_c;
+
+typedef boost::shared_ptr< spectrum_tap_c > spectrum_tap_c_sptr;
+
+spectrum_tap_c_sptr make_spectrum_tap_c( size_t fft_size, double fps );
+
+/*!
+ * \brief Publishes decimated magnitude spectra of the passing stream.
+ *
+ * A stream consumer without outputs: every 1/fps seconds it windows
+ * (Hann, volk) one FFT length of samples, transforms it with FFTW and
+ * publishes the shifted magnitude frame in dB as a f32vector on the
+ * "spectrum" message port. All other samples are merely counted, so the
+ * cost is one FFT per frame regardless of the stream rate and the
+ * full-rate path stays untouched - enough for a 30 fps waterfall
+ * without a second full-rate stream into Python.
+ */
+class spectrum_tap_c : public gr::sync_block
+{
+private:
+  friend spectrum_tap_c_sptr make_spectrum_tap_c( size_t fft_size,
+                                                  double fps );
+
+  spectrum_tap_c( size_t fft_size, double fps );
+
+public:
+  ~spectrum_tap_c();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  /*! Frame pacing needs the stream rate; frames pause while unknown. */
+  void set_sample_rate( double rate );
+
+private:
+  size_t _fft_size;
+  double _fps;
+  double _rate;
+
+  gr::fft::fft_complex *_fft;
+  gr_complex *_frame; /* volk-aligned frame staging ahead of the window */
+  float *_window;     /* volk-aligned Hann coefficients */
+  float *_mag;        /* volk-aligned magnitude staging */
+  float *_shifted;    /* magnitudes in fft-shifted order for publishing */
+
+  uint64_t _stride; /* input samples per published frame, 0 = paused */
+  uint64_t _skip;   /* samples left until the next frame starts */
+  size_t _fill;     /* samples staged of the frame being collected */
+};
+
+#endif /* OSMOSDR_SPECTRUM_TAP_C_H */
@@ -0,0 +1,295 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2012 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include <boost/assign.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <gnuradio/io_signature.h>
+
+#include <volk/volk.h>
+
+#include "synthetic_source_c.h"
+
+#include "arg_helpers.h"
+
+using namespace boost::assign;
+
+/* one pattern period, large enough that a work call usually runs a
+ * single memcpy, small enough to stay cache resident */
+#define PERIOD_LEN 8192
+
+synthetic_source_c_sptr make_synthetic_source_c(const std::string &args)
+{
+  return gnuradio::get_initial_sptr(new synthetic_source_c(args));
+}
+
+synthetic_source_c::synthetic_source_c(const std::string &args) :
+  gr::sync_block("synthetic_source_c",
+                 gr::io_signature::make(0, 0, 0),
+                 gr::io_signature::make(1, 1, sizeof (gr_complex))),
+  _period(NULL),
+  _period_len(PERIOD_LEN),
+  _offset(0),
+  _throttle(false),
+  _total(0),
+  _freq(100e6),
+  _rate(1e6)
+{
+  std::string pattern = "tone";
+
+  dict_t dict = params_to_dict(args);
+
+  if (dict.count("freq"))
+    _freq = boost::lexical_cast< double >( dict["freq"] );
+
+  if (dict.count("rate"))
+    _rate = boost::lexical_cast< double >( dict["rate"] );
+
+  if (dict.count("throttle"))
+    _throttle = ("true" == dict["throttle"] || "1" == dict["throttle"]);
+
+  if (dict.count("pattern"))
+    pattern = dict["pattern"];
+
+  if (_rate <= 0)
+    throw std::runtime_error("Parameter 'rate' must be positive.");
+
+  _period = (gr_complex *)volk_malloc(_period_len * sizeof(gr_complex),
+                                      volk_get_alignment());
+
+  fill_pattern( pattern );
+
+  /* Set up constraints: produce in aligned full SIMD widths so the
+   * conversion kernels never have to run a scalar tail */
+  int const alignment_multiple = volk_get_alignment() / sizeof(gr_complex);
+  set_alignment(std::max(1, alignment_multiple));
+  set_output_multiple(std::max(1, alignment_multiple));
+}
+
+synthetic_source_c::~synthetic_source_c()
+{
+  if (_period)
+    volk_free(_period);
+}
+
+/*
+ * The patterns are periodic in PERIOD_LEN and fully deterministic, so
+ * perf runs stay comparable and consumers may verify the stream.
+ */
+void synthetic_source_c::fill_pattern( const std::string &pattern )
+{
+  if ("tone" == pattern) {
+    /* complex exponential at fs/16, an integer number of cycles fits
+     * the period exactly */
+    for (unsigned int i = 0; i < _period_len; i++)
+      _period[i] = gr_complex( cosf(2.0f * M_PI * i / 16.0f),
+                               sinf(2.0f * M_PI * i / 16.0f) );
+  } else if ("ramp" == pattern) {
+    for (unsigned int i = 0; i < _period_len; i++) {
+      float v = 2.0f * i / _period_len - 1.0f;
+      _period[i] = gr_complex( v, -v );
+    }
+  } else if ("prbs" == pattern) {
+    /* fixed-seed LCG, noise-like but reproducible */
+    uint32_t state = 0x12345678;
+    for (unsigned int i = 0; i < _period_len; i++) {
+      state = state * 1664525 + 1013904223;
+      float re = int32_t(state) / 2147483648.0f;
+      state = state * 1664525 + 1013904223;
+      float im = int32_t(state) / 2147483648.0f;
+      _period[i] = gr_complex( re, im );
+    }
+  } else {
+    throw std::runtime_error("Pattern '" + pattern +
+                             "' not supported by synthetic backend.");
+  }
+}
+
+bool synthetic_source_c::start()
+{
+  _total = 0;
+  _start_time = osmosdr::time_spec_t::get_system_time();
+
+  return true;
+}
+
+int synthetic_source_c::work( int noutput_items,
+                              gr_vector_const_void_star &input_items,
+                              gr_vector_void_star &output_items )
+{
+  gr_complex *out = (gr_complex *)output_items[0];
+  int produced = 0;
+
+  while (produced < noutput_items) {
+    int nout = std::min( (unsigned int)(noutput_items - produced),
+                         _period_len - _offset );
+
+    memcpy( &out[produced], &_period[_offset], nout * sizeof(gr_complex) );
+
+    produced += nout;
+    _offset = (_offset + nout) % _period_len;
+  }
+
+  if (_throttle) {
+    /* sleep off whatever we are ahead of the configured rate */
+    _total += produced;
+
+    double elapsed =
+        (osmosdr::time_spec_t::get_system_time() - _start_time).get_real_secs();
+    double ahead = _total / _rate - elapsed;
+
+    if (ahead > 0)
+      boost::this_thread::sleep(
+          boost::posix_time::microseconds(long(ahead * 1e6)));
+  }
+
+  return produced;
+}
+
+std::string synthetic_source_c::name()
+{
+  return "Synthetic Signal Source";
+}
+
+std::vector<std::string> synthetic_source_c::get_devices( bool fake )
+{
+  std::vector<std::string> devices;
+
+  if ( fake )
+  {
+    std::string args = "synthetic=0";
+    args += ",pattern=tone,rate=1e6,throttle=false";
+    args += ",label='Synthetic Signal Source'";
+    devices.push_back( args );
+  }
+
+  return devices;
+}
+
+size_t synthetic_source_c::get_num_channels( void )
+{
+  return 1;
+}
+
+osmosdr::meta_range_t synthetic_source_c::get_sample_rates( void )
+{
+  osmosdr::meta_range_t range;
+
+  range += osmosdr::range_t( _rate );
+
+  return range;
+}
+
+double synthetic_source_c::set_sample_rate( double rate )
+{
+  if (rate > 0)
+    _rate = rate;
+
+  return get_sample_rate();
+}
+
+double synthetic_source_c::get_sample_rate( void )
+{
+  return _rate;
+}
+
+osmosdr::freq_range_t synthetic_source_c::get_freq_range( size_t chan )
+{
+  return osmosdr::freq_range_t(_freq, _freq);
+}
+
+double synthetic_source_c::set_center_freq( double freq, size_t chan )
+{
+  _freq = freq;
+
+  return get_center_freq(chan);
+}
+
+double synthetic_source_c::get_center_freq( size_t chan )
+{
+  return _freq;
+}
+
+double synthetic_source_c::set_freq_corr( double ppm, size_t chan )
+{
+  return get_freq_corr( chan );
+}
+
+double synthetic_source_c::get_freq_corr( size_t chan )
+{
+  return 0;
+}
+
+std::vector<std::string> synthetic_source_c::get_gain_names( size_t chan )
+{
+  return std::vector< std::string >();
+}
+
+osmosdr::gain_range_t synthetic_source_c::get_gain_range( size_t chan )
+{
+  return osmosdr::gain_range_t();
+}
+
+osmosdr::gain_range_t synthetic_source_c::get_gain_range( const std::string & name, size_t chan )
+{
+  return get_gain_range( chan );
+}
+
+double synthetic_source_c::set_gain( double gain, size_t chan )
+{
+  return get_gain(chan);
+}
+
+double synthetic_source_c::set_gain( double gain, const std::string & name, size_t chan )
+{
+  return set_gain(gain, chan);
+}
+
+double synthetic_source_c::get_gain( size_t chan )
+{
+  return 0;
+}
+
+double synthetic_source_c::get_gain( const std::string & name, size_t chan )
+{
+  return get_gain(chan);
+}
+
+std::vector< std::string > synthetic_source_c::get_antennas( size_t chan )
+{
+  return std::vector< std::string >();
+}
+
+std::string synthetic_source_c::set_antenna( const std::string & antenna, size_t chan )
+{
+  return get_antenna(chan);
+}
+
+std::string synthetic_source_c::get_antenna( size_t chan )
+{
+  return "";
+}
@@ -0,0 +1,104 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2012 Dimitri Stolnikov <horiz0n@gmx.net>
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef SYNTHETIC_SOURCE_C_H
+#define SYNTHETIC_SOURCE_C_H
+
+#include <gnuradio/sync_block.h>
+
+#include <osmosdr/time_spec.h>
+
+#include "source_iface.h"
+
+class synthetic_source_c;
+
+typedef boost::shared_ptr< synthetic_source_c > synthetic_source_c_sptr;
+
+synthetic_source_c_sptr make_synthetic_source_c( const std::string & args = "" );
+
+/*!
+ * \brief Deterministic IQ source without hardware or I/O.
+ *
+ * Replays a precomputed pattern period straight from memory, so a
+ * flowgraph built on it measures nothing but the gr-osmosdr plumbing:
+ * scheduler hops, conversion and hier block overhead. By default the
+ * block produces as fast as the scheduler asks, throttle=true paces
+ * it to the configured rate for realtime-shaped runs.
+ */
+class synthetic_source_c :
+    public gr::sync_block,
+    public source_iface
+{
+private:
+  friend synthetic_source_c_sptr make_synthetic_source_c(const std::string &args);
+
+  synthetic_source_c(const std::string &args);
+
+public:
+  ~synthetic_source_c();
+
+  bool start();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  std::string name();
+
+  static std::vector< std::string > get_devices( bool fake = false );
+
+  size_t get_num_channels( void );
+
+  osmosdr::meta_range_t get_sample_rates( void );
+  double set_sample_rate( double rate );
+  double get_sample_rate( void );
+
+  osmosdr::freq_range_t get_freq_range( size_t chan = 0 );
+  double set_center_freq( double freq, size_t chan = 0 );
+  double get_center_freq( size_t chan = 0 );
+  double set_freq_corr( double ppm, size_t chan = 0 );
+  double get_freq_corr( size_t chan = 0 );
+
+  std::vector<std::string> get_gain_names( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( const std::string & name, size_t chan = 0 );
+  double set_gain( double gain, size_t chan = 0 );
+  double set_gain( double gain, const std::string & name, size_t chan = 0 );
+  double get_gain( size_t chan = 0 );
+  double get_gain( const std::string & name, size_t chan = 0 );
+
+  std::vector< std::string > get_antennas( size_t chan = 0 );
+  std::string set_antenna( const std::string & antenna, size_t chan = 0 );
+  std::string get_antenna( size_t chan = 0 );
+
+private:
+  void fill_pattern( const std::string &pattern );
+
+  gr_complex *_period;    /* volk-aligned pattern period */
+  unsigned int _period_len;
+  unsigned int _offset;   /* read position inside the period */
+
+  bool _throttle;         /* pace output to _rate instead of max speed */
+  uint64_t _total;        /* samples produced since start() */
+  osmosdr::time_spec_t _start_time;
+
+  double _freq, _rate;
+};
+
+#endif // SYNTHETIC_SOURCE_C_H
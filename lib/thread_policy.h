@@ -0,0 +1,78 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef OSMOSDR_THREAD_POLICY_H
+#define OSMOSDR_THREAD_POLICY_H
+
+#include <iostream>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/*!
+ * Scheduling policy for a driver's streaming thread, parsed from the
+ * affinity=N and rt_prio=P device arguments. Pinning the USB/network
+ * servicing to an isolated core stops the scheduler from migrating it
+ * under load, a SCHED_FIFO priority keeps it ahead of best-effort
+ * tasks. Both are Linux only and the priority needs CAP_SYS_NICE or a
+ * matching rtprio rlimit, failures are reported and ignored.
+ */
+struct thread_policy
+{
+  int affinity; /* core to pin to, -1 leaves placement to the scheduler */
+  int rt_prio;  /* SCHED_FIFO priority, -1 keeps SCHED_OTHER */
+
+  thread_policy() : affinity(-1), rt_prio(-1) {}
+
+  bool is_default() const { return affinity < 0 && rt_prio < 0; }
+};
+
+/*!
+ * Apply the policy to the calling thread. Call this from the streaming
+ * thread itself; for threads spawned inside a vendor library it may be
+ * called from the first streaming callback, which runs on that thread.
+ */
+static inline void apply_thread_policy( const thread_policy &policy )
+{
+#ifdef __linux__
+  if (policy.affinity >= 0) {
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    CPU_SET(policy.affinity, &set);
+
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+      std::cerr << "Failed to pin streaming thread to core "
+                << policy.affinity << "." << std::endl;
+  }
+
+  if (policy.rt_prio >= 0) {
+    struct sched_param param;
+    param.sched_priority = policy.rt_prio;
+
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0)
+      std::cerr << "Failed to set real-time priority " << policy.rt_prio
+                << ", check the rtprio rlimit." << std::endl;
+  }
+#endif
+}
+
+#endif /* OSMOSDR_THREAD_POLICY_H */
@@ -103,12 +103,39 @@ time_spec_t::time_spec_t(time_t full_secs, long tick_count, double tick_rate){
 time_spec_t time_spec_t::from_ticks(long long ticks, double tick_rate){
     const long long rate_i = (long long)(tick_rate);
     const double rate_f = tick_rate - rate_i;
+
+    if (rate_f == 0.0 and rate_i == 1000000000ll)
+        return time_spec_t::from_nsecs(ticks);
+
     const time_t secs_full = time_t(ticks/rate_i);
     const long long ticks_error = ticks - (secs_full*rate_i);
     const double ticks_frac = ticks_error - secs_full*rate_f;
     return time_spec_t(secs_full, ticks_frac/tick_rate);
 }
 
+/***********************************************************************
+ * Integer nanosecond fast path
+ **********************************************************************/
+static const long long NSECS_PER_SEC = 1000000000ll;
+
+time_spec_t time_spec_t::from_nsecs(long long nsecs){
+    time_t secs_full = time_t(nsecs/NSECS_PER_SEC);
+    long long nsecs_frac = nsecs - secs_full*NSECS_PER_SEC;
+    if (nsecs_frac < 0) { //already normalized, skip time_spec_init
+        secs_full -= 1;
+        nsecs_frac += NSECS_PER_SEC;
+    }
+    time_spec_t t;
+    t._full_secs = secs_full;
+    t._frac_secs = nsecs_frac*1e-9;
+    return t;
+}
+
+long long time_spec_t::to_nsecs(void) const{
+    return this->get_full_secs()*NSECS_PER_SEC +
+        fast_llround(this->get_frac_secs()*1e9);
+}
+
 /***********************************************************************
  * Time spec accessors
  **********************************************************************/
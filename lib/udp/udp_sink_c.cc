@@ -0,0 +1,438 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* sendmmsg */
+#endif
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <netinet/in.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include <boost/assign.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/algorithm/string.hpp>
+
+#include <gnuradio/io_signature.h>
+#include <volk/volk.h>
+
+#include "arg_helpers.h"
+#include "udp_sink_c.h"
+
+using namespace boost::assign;
+
+#define DEFAULT_DEST     "127.0.0.1:50000"
+
+#define UDP_PACKET_SIZE  (1024 * 2) /* matches the rfspace receive buffer */
+#define UDP_PACKET_POOL  64         /* datagrams handed over per syscall */
+
+#define UDP_HEADER_SIZE  2
+#define UDP_SEQNUM_SIZE  2
+#define UDP_PAYLOAD_SIZE (UDP_PACKET_SIZE - UDP_HEADER_SIZE - UDP_SEQNUM_SIZE)
+
+udp_sink_c_sptr make_udp_sink_c( const std::string &args )
+{
+  return gnuradio::get_initial_sptr( new udp_sink_c(args) );
+}
+
+udp_sink_c::udp_sink_c( const std::string &args ) :
+    gr::sync_block( "udp_sink_c",
+                    gr::io_signature::make(1, 1, sizeof(gr_complex)),
+                    gr::io_signature::make(0, 0, 0) ),
+    _socket(-1),
+    _pkt_pool(NULL),
+    _npkts(0),
+    _pkt_fill(0),
+    _sequence(0),
+    _wire_size(sizeof(int16_t)),
+    _freq(0),
+    _rate(0),
+    _corr(0),
+    _gain_val(0)
+{
+  std::string dest = DEFAULT_DEST;
+  std::string format = "cs16";
+
+  dict_t dict = params_to_dict(args);
+
+  if ( dict.count("udp") && dict["udp"].length() )
+    dest = dict["udp"];
+
+  if ( dict.count("format") )
+    format = dict["format"];
+
+  /* the cs16 header is what a NetSDR emits for 16 bit contiguous data
+   * and what the rfspace source accepts. cs8 halves the wire rate with
+   * a marker outside the rfspace set, so a 16 bit consumer drops the
+   * datagrams instead of misparsing them. */
+  if ( "cs16" == format )
+  {
+    _header[0] = 0x04;
+    _header[1] = 0x84;
+    _wire_size = sizeof(int16_t);
+  }
+  else if ( "cs8" == format )
+  {
+    _header[0] = 0x04;
+    _header[1] = 0x8C;
+    _wire_size = sizeof(int8_t);
+  }
+  else
+    throw std::runtime_error("Wire format (format) must be cs16 or cs8");
+
+  if ( dict.count("freq") )
+    _freq = boost::lexical_cast< double >( dict["freq"] );
+
+  if ( dict.count("rate") )
+    _rate = boost::lexical_cast< double >( dict["rate"] );
+
+  std::vector< std::string > tokens;
+  boost::algorithm::split( tokens, dest, boost::is_any_of(":") );
+
+  if ( tokens.size() != 2 || !tokens[0].length() || !tokens[1].length() )
+    throw std::runtime_error("Destination (udp) must be of the form ip:port");
+
+  struct addrinfo hints;
+  struct addrinfo *result;
+
+  memset( &hints, 0, sizeof(hints) );
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+  hints.ai_protocol = IPPROTO_UDP;
+
+  if ( getaddrinfo( tokens[0].c_str(), tokens[1].c_str(),
+                    &hints, &result ) != 0 )
+    throw std::runtime_error("Could not resolve destination " + dest);
+
+  memcpy( &_dest, result->ai_addr, sizeof(_dest) );
+  freeaddrinfo( result );
+
+  _socket = socket( AF_INET, SOCK_DGRAM, IPPROTO_UDP );
+  if ( _socket < 0 )
+    throw std::runtime_error("Could not create UDP socket: " +
+                             std::string(strerror(errno)));
+
+  /* room for a few milliseconds of samples at high rates so a scheduling
+   * hiccup of the softirq path does not drop datagrams at the sender */
+  int sndbuf = 1024 * 1024 * 4;
+  setsockopt( _socket, SOL_SOCKET, SO_SNDBUF,
+              (const char *)&sndbuf, sizeof(sndbuf) );
+
+  /* a directed broadcast address is a convenient way to feed a cluster */
+  int broadcast = 1;
+  setsockopt( _socket, SOL_SOCKET, SO_BROADCAST,
+              (const char *)&broadcast, sizeof(broadcast) );
+
+  _pkt_pool = new unsigned char[UDP_PACKET_POOL * UDP_PACKET_SIZE];
+
+  std::cerr << "Distributing IQ stream to " << dest
+            << " (" << format << ")" << std::endl;
+}
+
+udp_sink_c::~udp_sink_c()
+{
+  if ( _socket >= 0 )
+    close( _socket );
+
+  delete [] _pkt_pool;
+}
+
+bool udp_sink_c::start()
+{
+  /* consumers expect the first datagram to carry sequence number 1 */
+  _sequence = 0;
+  _npkts = 0;
+  _pkt_fill = 0;
+
+  return true;
+}
+
+bool udp_sink_c::stop()
+{
+  /* push out whatever work() left staged, a short datagram included */
+  flush_pool( _pkt_fill );
+  _pkt_fill = 0;
+
+  return true;
+}
+
+/* Hand the staged datagrams to the kernel, all of them with a single
+ * sendmmsg() where available. tail_len > 0 additionally sends the
+ * partially filled datagram following the complete ones. */
+void udp_sink_c::flush_pool( size_t tail_len )
+{
+  unsigned int count = _npkts + (tail_len ? 1 : 0);
+
+  if ( 0 == count )
+    return;
+
+#ifdef __linux__
+  struct mmsghdr msgs[UDP_PACKET_POOL + 1];
+  struct iovec iovs[UDP_PACKET_POOL + 1];
+
+  memset( msgs, 0, sizeof(msgs[0]) * count );
+  for ( unsigned int i = 0; i < count; i++ )
+  {
+    iovs[i].iov_base = _pkt_pool + i * UDP_PACKET_SIZE;
+    iovs[i].iov_len = UDP_PACKET_SIZE;
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+    msgs[i].msg_hdr.msg_name = &_dest;
+    msgs[i].msg_hdr.msg_namelen = sizeof(_dest);
+  }
+
+  if ( tail_len )
+    iovs[count - 1].iov_len = UDP_HEADER_SIZE + UDP_SEQNUM_SIZE + tail_len;
+
+  unsigned int sent = 0;
+  while ( sent < count )
+  {
+    int n = sendmmsg( _socket, msgs + sent, count - sent, 0 );
+
+    if ( n < 0 )
+    {
+      if ( EINTR == errno )
+        continue;
+
+      throw std::runtime_error("Sending samples failed: " +
+                               std::string(strerror(errno)));
+    }
+
+    sent += n;
+  }
+#else
+  for ( unsigned int i = 0; i < count; i++ )
+  {
+    size_t len = UDP_PACKET_SIZE;
+
+    if ( tail_len && i == count - 1 )
+      len = UDP_HEADER_SIZE + UDP_SEQNUM_SIZE + tail_len;
+
+    if ( sendto( _socket, _pkt_pool + i * UDP_PACKET_SIZE, len, 0,
+                 (struct sockaddr *)&_dest, sizeof(_dest) ) < 0 &&
+         EINTR != errno )
+      throw std::runtime_error("Sending samples failed: " +
+                               std::string(strerror(errno)));
+  }
+#endif
+
+  /* the datagram still being built follows the complete ones, carry it
+   * over to the front of the drained pool */
+  if ( 0 == tail_len && _pkt_fill && _npkts )
+    memmove( _pkt_pool, _pkt_pool + _npkts * UDP_PACKET_SIZE,
+             UDP_HEADER_SIZE + UDP_SEQNUM_SIZE + _pkt_fill );
+
+  _npkts = 0;
+}
+
+int udp_sink_c::work( int noutput_items,
+                      gr_vector_const_void_star &input_items,
+                      gr_vector_void_star &output_items )
+{
+  const gr_complex *in = (const gr_complex *)input_items[0];
+  int remaining = noutput_items;
+
+  /* in contiguous mode every datagram carries the same number of samples
+   * so the consumer can conceal sequence gaps exactly. a tail that does
+   * not fill a datagram stays staged for the next work call. */
+  const size_t samples_per_pkt = UDP_PAYLOAD_SIZE / (_wire_size * 2) ;
+
+  while ( remaining )
+  {
+    unsigned char *pkt = _pkt_pool + _npkts * UDP_PACKET_SIZE;
+
+    if ( 0 == _pkt_fill )
+    {
+      if ( 0 == ++_sequence ) /* zero restarts the consumer's tracking */
+        _sequence = 1;
+
+      pkt[0] = _header[0];
+      pkt[1] = _header[1];
+      *((uint16_t *)(pkt + UDP_HEADER_SIZE)) = _sequence;
+    }
+
+    size_t filled = _pkt_fill / (_wire_size * 2);
+    size_t nconv = std::min( samples_per_pkt - filled, (size_t)remaining );
+    unsigned char *payload = pkt + UDP_HEADER_SIZE + UDP_SEQNUM_SIZE +
+                             _pkt_fill;
+
+    if ( sizeof(int16_t) == _wire_size )
+      volk_32f_s32f_convert_16i( (int16_t *)payload, (const float *)in,
+                                 32768.f, nconv * 2 );
+    else
+      volk_32f_s32f_convert_8i( (int8_t *)payload, (const float *)in,
+                                128.f, nconv * 2 );
+
+    in += nconv;
+    remaining -= nconv;
+    _pkt_fill += nconv * _wire_size * 2;
+
+    if ( _pkt_fill == UDP_PAYLOAD_SIZE )
+    {
+      _pkt_fill = 0;
+
+      if ( ++_npkts == UDP_PACKET_POOL )
+        flush_pool();
+    }
+  }
+
+  flush_pool();
+
+  return noutput_items;
+}
+
+std::string udp_sink_c::name()
+{
+  return "UDP IQ sink";
+}
+
+std::vector<std::string> udp_sink_c::get_devices( bool fake )
+{
+  std::vector<std::string> devices;
+
+  if ( fake )
+  {
+    std::string args = "udp=" DEFAULT_DEST;
+    args += ",label='UDP IQ Distribution'";
+    devices.push_back( args );
+  }
+
+  return devices;
+}
+
+size_t udp_sink_c::get_num_channels( void )
+{
+  return 1;
+}
+
+osmosdr::meta_range_t udp_sink_c::get_sample_rates( void )
+{
+  osmosdr::meta_range_t range;
+
+  range += osmosdr::range_t( _rate, _rate );
+
+  return range;
+}
+
+double udp_sink_c::set_sample_rate( double rate )
+{
+  _rate = rate;
+
+  return get_sample_rate();
+}
+
+double udp_sink_c::get_sample_rate( void )
+{
+  return _rate;
+}
+
+osmosdr::freq_range_t udp_sink_c::get_freq_range( size_t chan )
+{
+  return osmosdr::freq_range_t(_freq, _freq);
+}
+
+double udp_sink_c::set_center_freq( double freq, size_t chan )
+{
+  _freq = freq;
+
+  return get_center_freq(chan);
+}
+
+double udp_sink_c::get_center_freq( size_t chan )
+{
+  return _freq;
+}
+
+double udp_sink_c::set_freq_corr( double ppm, size_t chan )
+{
+  _corr = ppm;
+
+  return get_freq_corr( chan );
+}
+
+double udp_sink_c::get_freq_corr( size_t chan )
+{
+  return _corr;
+}
+
+std::vector<std::string> udp_sink_c::get_gain_names( size_t chan )
+{
+  return std::vector< std::string >();
+}
+
+osmosdr::gain_range_t udp_sink_c::get_gain_range( size_t chan )
+{
+  return osmosdr::gain_range_t();
+}
+
+osmosdr::gain_range_t udp_sink_c::get_gain_range( const std::string & name, size_t chan )
+{
+  return get_gain_range( chan );
+}
+
+double udp_sink_c::set_gain( double gain, size_t chan )
+{
+  _gain_val = gain;
+
+  return get_gain(chan);
+}
+
+double udp_sink_c::set_gain( double gain, const std::string & name, size_t chan )
+{
+  return set_gain( gain, chan );
+}
+
+double udp_sink_c::get_gain( size_t chan )
+{
+  return _gain_val;
+}
+
+double udp_sink_c::get_gain( const std::string & name, size_t chan )
+{
+  return get_gain( chan );
+}
+
+std::vector< std::string > udp_sink_c::get_antennas( size_t chan )
+{
+  return std::vector< std::string >();
+}
+
+std::string udp_sink_c::set_antenna( const std::string & antenna, size_t chan )
+{
+  return get_antenna( chan );
+}
+
+std::string udp_sink_c::get_antenna( size_t chan )
+{
+  return "";
+}
@@ -0,0 +1,109 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef UDP_SINK_C_H
+#define UDP_SINK_C_H
+
+#include <netinet/in.h>
+
+#include <gnuradio/sync_block.h>
+
+#include "sink_iface.h"
+
+class udp_sink_c;
+
+typedef boost::shared_ptr< udp_sink_c > udp_sink_c_sptr;
+
+udp_sink_c_sptr make_udp_sink_c( const std::string & args = "" );
+
+/*!
+ * Transmits the IQ stream as a sequence numbered UDP datagram stream.
+ *
+ * The wire format is the one the rfspace source already parses: every
+ * datagram starts with a two byte header and a 16 bit sequence number,
+ * followed by interleaved IQ samples. With format=cs16 (the default)
+ * the datagrams are indistinguishable from a NetSDR in 16 bit contiguous
+ * mode, so any rfspace-capable consumer can attach to the stream.
+ */
+class udp_sink_c :
+    public gr::sync_block,
+    public sink_iface
+{
+private:
+  friend udp_sink_c_sptr make_udp_sink_c(const std::string &args);
+
+  udp_sink_c(const std::string &args);
+
+public:
+  ~udp_sink_c();
+
+  bool start();
+  bool stop();
+
+  int work( int noutput_items,
+            gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items );
+
+  std::string name();
+
+  static std::vector< std::string > get_devices( bool fake = false );
+
+  size_t get_num_channels( void );
+
+  osmosdr::meta_range_t get_sample_rates( void );
+  double set_sample_rate( double rate );
+  double get_sample_rate( void );
+
+  osmosdr::freq_range_t get_freq_range( size_t chan = 0 );
+  double set_center_freq( double freq, size_t chan = 0 );
+  double get_center_freq( size_t chan = 0 );
+  double set_freq_corr( double ppm, size_t chan = 0 );
+  double get_freq_corr( size_t chan = 0 );
+
+  std::vector<std::string> get_gain_names( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( size_t chan = 0 );
+  osmosdr::gain_range_t get_gain_range( const std::string & name, size_t chan = 0 );
+  double set_gain( double gain, size_t chan = 0 );
+  double set_gain( double gain, const std::string & name, size_t chan = 0 );
+  double get_gain( size_t chan = 0 );
+  double get_gain( const std::string & name, size_t chan = 0 );
+
+  std::vector< std::string > get_antennas( size_t chan = 0 );
+  std::string set_antenna( const std::string & antenna, size_t chan = 0 );
+  std::string get_antenna( size_t chan = 0 );
+
+private:
+  void flush_pool( size_t tail_len = 0 );
+
+  int _socket;
+  struct sockaddr_in _dest;
+
+  unsigned char *_pkt_pool;   /* staged datagrams, sent with one syscall */
+  unsigned int _npkts;        /* complete datagrams waiting in the pool */
+  size_t _pkt_fill;           /* payload bytes of the datagram being built */
+  uint16_t _sequence;
+
+  unsigned char _header[2];   /* wire format marker, see the .cc */
+  size_t _wire_size;          /* bytes per I or Q value on the wire */
+
+  double _freq, _rate, _corr;
+  double _gain_val;
+};
+
+#endif // UDP_SINK_C_H
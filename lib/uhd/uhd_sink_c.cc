@@ -239,11 +239,14 @@ double uhd_sink_c::get_center_freq( size_t chan )
 
 double uhd_sink_c::set_freq_corr( double ppm, size_t chan )
 {
+  if ( ppm == _freq_corr )
+    return get_freq_corr( chan );
+
   _freq_corr = ppm;
 
   set_center_freq( _center_freq );
 
-  return get_freq_corr(chan);
+  return get_freq_corr( chan );
 }
 
 double uhd_sink_c::get_freq_corr( size_t chan )
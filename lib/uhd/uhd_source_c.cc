@@ -240,6 +240,9 @@ double uhd_source_c::get_center_freq( size_t chan )
 
 double uhd_source_c::set_freq_corr( double ppm, size_t chan )
 {
+  if ( ppm == _freq_corr )
+    return get_freq_corr( chan );
+
   _freq_corr = ppm;
 
   set_center_freq( _center_freq );
@@ -455,3 +458,21 @@ void uhd_source_c::set_time_unknown_pps(const osmosdr::time_spec_t &time_spec)
 {
   _src->set_time_unknown_pps( uhd::time_spec_t( time_spec.get_full_secs(), time_spec.get_frac_secs() ) );
 }
+
+void uhd_source_c::set_command_time(const osmosdr::time_spec_t &time_spec, size_t mboard)
+{
+  /* setters issued from now on are queued by the device and latched at
+   * the given time, so freq/gain changes across channels land in the
+   * same instant */
+  _src->set_command_time( uhd::time_spec_t( time_spec.get_full_secs(), time_spec.get_frac_secs() ), mboard );
+}
+
+void uhd_source_c::clear_command_time(size_t mboard)
+{
+  _src->clear_command_time( mboard );
+}
+
+void uhd_source_c::set_start_time(const osmosdr::time_spec_t &time_spec)
+{
+  _src->set_start_time( uhd::time_spec_t( time_spec.get_full_secs(), time_spec.get_frac_secs() ) );
+}
@@ -12,6 +12,7 @@
 
 %{
 #include "osmosdr/device.h"
+#include "osmosdr/tune_request.h"
 #include "osmosdr/source.h"
 #include "osmosdr/sink.h"
 %}
@@ -26,6 +27,7 @@
 %}
 
 %template(string_vector_t) std::vector<std::string>;
+%template(double_vector_t) std::vector<double>; //batched control calls
 
 //%template(size_vector_t) std::vector<size_t>;
 
@@ -47,6 +49,8 @@
 
 %include <osmosdr/time_spec.h>
 
+%include <osmosdr/tune_request.h>
+
 %extend osmosdr::time_spec_t{
     osmosdr::time_spec_t __add__(const osmosdr::time_spec_t &what)
     {
@@ -70,6 +74,59 @@ BASE_NAME = BASE_NAME.make;
 %}
 %enddef
 
+// The control-plane setters below end up in synchronous USB control
+// transfers or network round-trips inside the drivers. Release the GIL
+// while the hardware call is in flight so the other Python threads of a
+// controller (GUI, telemetry pollers) keep running; the handler mirrors
+// the default one from gnuradio.i, the thread state is restored before
+// any exception is raised.
+%define OSMOSDR_RELEASE_GIL(METHOD)
+%exception METHOD {
+    PyThreadState *_save = PyEval_SaveThread();
+    try {
+        $action
+        PyEval_RestoreThread(_save);
+    }
+    catch(std::exception &e) {
+        PyEval_RestoreThread(_save);
+        SWIG_exception(SWIG_RuntimeError, e.what());
+    }
+    catch(...) {
+        PyEval_RestoreThread(_save);
+        SWIG_exception(SWIG_RuntimeError, "Unknown exception");
+    }
+}
+%enddef
+
+OSMOSDR_RELEASE_GIL(osmosdr::source::set_sample_rate)
+OSMOSDR_RELEASE_GIL(osmosdr::source::set_center_freq)
+OSMOSDR_RELEASE_GIL(osmosdr::source::set_center_freqs)
+OSMOSDR_RELEASE_GIL(osmosdr::source::set_freq_corr)
+OSMOSDR_RELEASE_GIL(osmosdr::source::apply_settings)
+OSMOSDR_RELEASE_GIL(osmosdr::source::set_gain_mode)
+OSMOSDR_RELEASE_GIL(osmosdr::source::set_gain)
+OSMOSDR_RELEASE_GIL(osmosdr::source::set_gains)
+OSMOSDR_RELEASE_GIL(osmosdr::source::set_if_gain)
+OSMOSDR_RELEASE_GIL(osmosdr::source::set_bb_gain)
+OSMOSDR_RELEASE_GIL(osmosdr::source::set_antenna)
+OSMOSDR_RELEASE_GIL(osmosdr::source::set_dc_offset_mode)
+OSMOSDR_RELEASE_GIL(osmosdr::source::set_dc_offset)
+OSMOSDR_RELEASE_GIL(osmosdr::source::set_iq_balance_mode)
+OSMOSDR_RELEASE_GIL(osmosdr::source::set_iq_balance)
+OSMOSDR_RELEASE_GIL(osmosdr::source::set_bandwidth)
+
+OSMOSDR_RELEASE_GIL(osmosdr::sink::set_sample_rate)
+OSMOSDR_RELEASE_GIL(osmosdr::sink::set_center_freq)
+OSMOSDR_RELEASE_GIL(osmosdr::sink::set_freq_corr)
+OSMOSDR_RELEASE_GIL(osmosdr::sink::set_gain_mode)
+OSMOSDR_RELEASE_GIL(osmosdr::sink::set_gain)
+OSMOSDR_RELEASE_GIL(osmosdr::sink::set_if_gain)
+OSMOSDR_RELEASE_GIL(osmosdr::sink::set_bb_gain)
+OSMOSDR_RELEASE_GIL(osmosdr::sink::set_antenna)
+OSMOSDR_RELEASE_GIL(osmosdr::sink::set_dc_offset)
+OSMOSDR_RELEASE_GIL(osmosdr::sink::set_iq_balance)
+OSMOSDR_RELEASE_GIL(osmosdr::sink::set_bandwidth)
+
 %include "osmosdr/source.h"
 %include "osmosdr/sink.h"
 